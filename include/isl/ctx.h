@@ -70,6 +70,25 @@ extern "C" {
  */
 struct isl_stats {
 	long	gbr_solved_lps;
+	long	gbr_warm_starts;
+	long	sample_parallel_searches;
+	long	sample_cuts;
+	long	sample_cut_searches_avoided;
+	long	pip_parallel_branches;
+	long	pip_shared_contexts;
+	long	pip_splits;
+	long	pip_pieces;
+	long	pip_cuts;
+	long	tab_pivots;
+	long	tab_degenerate_pivots;
+	long	tab_sparse_pivots;
+	long	tab_float_accepted;
+	long	tab_float_rejected;
+	long	presolve_fixed_vars;
+	long	presolve_trivial_rows;
+	long	presolve_singleton_rows;
+	long	presolve_duplicate_rows;
+	long	presolve_dominated_rows;
 };
 enum isl_error {
 	isl_error_none = 0,
@@ -171,6 +190,20 @@ void isl_ctx_set_max_operations(isl_ctx *ctx, unsigned long max_operations);
 unsigned long isl_ctx_get_max_operations(isl_ctx *ctx);
 void isl_ctx_reset_operations(isl_ctx *ctx);
 
+void isl_ctx_set_max_block_cache_size(isl_ctx *ctx, unsigned long size);
+unsigned long isl_ctx_get_max_block_cache_size(isl_ctx *ctx);
+unsigned long isl_ctx_get_block_cache_hits(isl_ctx *ctx);
+unsigned long isl_ctx_get_block_cache_misses(isl_ctx *ctx);
+void isl_ctx_reset_block_cache_stats(isl_ctx *ctx);
+void isl_ctx_clear_block_cache(isl_ctx *ctx);
+
+void isl_ctx_set_max_basic_map_cache_size(isl_ctx *ctx, unsigned long size);
+unsigned long isl_ctx_get_max_basic_map_cache_size(isl_ctx *ctx);
+unsigned long isl_ctx_get_basic_map_cache_hits(isl_ctx *ctx);
+unsigned long isl_ctx_get_basic_map_cache_misses(isl_ctx *ctx);
+void isl_ctx_reset_basic_map_cache_stats(isl_ctx *ctx);
+void isl_ctx_clear_basic_map_cache(isl_ctx *ctx);
+
 #define ISL_ARG_CTX_DECL(prefix,st,args)				\
 st *isl_ctx_peek_ ## prefix(isl_ctx *ctx);
 
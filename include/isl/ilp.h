@@ -28,6 +28,14 @@ __isl_give isl_val *isl_set_min_val(__isl_keep isl_set *set,
 __isl_export
 __isl_give isl_val *isl_set_max_val(__isl_keep isl_set *set,
 	__isl_keep isl_aff *obj);
+__isl_give isl_multi_val *isl_basic_set_min_multi_aff(
+	__isl_keep isl_basic_set *bset, __isl_keep isl_multi_aff *obj);
+__isl_give isl_multi_val *isl_basic_set_max_multi_aff(
+	__isl_keep isl_basic_set *bset, __isl_keep isl_multi_aff *obj);
+__isl_give isl_multi_val *isl_set_min_multi_aff(__isl_keep isl_set *set,
+	__isl_keep isl_multi_aff *obj);
+__isl_give isl_multi_val *isl_set_max_multi_aff(__isl_keep isl_set *set,
+	__isl_keep isl_multi_aff *obj);
 __isl_give isl_multi_val *isl_union_set_min_multi_union_pw_aff(
 	__isl_keep isl_union_set *set, __isl_keep isl_multi_union_pw_aff *obj);
 
@@ -270,6 +270,12 @@ __isl_give isl_pw_multi_aff *isl_map_lexmin_pw_multi_aff(
 	__isl_take isl_map *map);
 __isl_give isl_pw_multi_aff *isl_map_lexmax_pw_multi_aff(
 	__isl_take isl_map *map);
+isl_stat isl_basic_map_foreach_lexmin(__isl_keep isl_basic_map *bmap,
+	isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user), void *user);
+isl_stat isl_basic_map_foreach_lexmax(__isl_keep isl_basic_map *bmap,
+	isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user), void *user);
 
 void isl_basic_map_print_internal(__isl_keep isl_basic_map *bmap,
 	FILE *out, int indent);
@@ -35,6 +35,25 @@ int isl_options_get_on_error(isl_ctx *ctx);
 isl_stat isl_options_set_gbr_only_first(isl_ctx *ctx, int val);
 int isl_options_get_gbr_only_first(isl_ctx *ctx);
 
+isl_stat isl_options_set_gbr_warm_start(isl_ctx *ctx, int val);
+int isl_options_get_gbr_warm_start(isl_ctx *ctx);
+
+isl_stat isl_options_set_sample_threads(isl_ctx *ctx, int val);
+int isl_options_get_sample_threads(isl_ctx *ctx);
+
+isl_stat isl_options_set_sample_cut_rounds(isl_ctx *ctx, int val);
+int isl_options_get_sample_cut_rounds(isl_ctx *ctx);
+
+isl_stat isl_options_set_pip_threads(isl_ctx *ctx, int val);
+int isl_options_get_pip_threads(isl_ctx *ctx);
+
+#define		ISL_PIP_SPLIT_REDUNDANT		0
+#define		ISL_PIP_SPLIT_DIVS		1
+#define		ISL_PIP_SPLIT_CONSTRAINED	2
+#define		ISL_PIP_SPLIT_LOOKAHEAD		3
+isl_stat isl_options_set_pip_split(isl_ctx *ctx, int val);
+int isl_options_get_pip_split(isl_ctx *ctx);
+
 #define		ISL_SCHEDULE_ALGORITHM_ISL		0
 #define		ISL_SCHEDULE_ALGORITHM_FEAUTRIER	1
 isl_stat isl_options_set_schedule_algorithm(isl_ctx *ctx, int val);
@@ -43,6 +62,22 @@ int isl_options_get_schedule_algorithm(isl_ctx *ctx);
 isl_stat isl_options_set_pip_symmetry(isl_ctx *ctx, int val);
 int isl_options_get_pip_symmetry(isl_ctx *ctx);
 
+#define		ISL_TAB_PRICING_BLAND		0
+#define		ISL_TAB_PRICING_DEVEX		1
+#define		ISL_TAB_PRICING_STEEPEST_EDGE	2
+#define		ISL_TAB_PRICING_RANDOM		3
+isl_stat isl_options_set_tab_pricing(isl_ctx *ctx, int val);
+int isl_options_get_tab_pricing(isl_ctx *ctx);
+
+isl_stat isl_options_set_tab_float_filter(isl_ctx *ctx, int val);
+int isl_options_get_tab_float_filter(isl_ctx *ctx);
+
+isl_stat isl_options_set_tab_presolve(isl_ctx *ctx, int val);
+int isl_options_get_tab_presolve(isl_ctx *ctx);
+
+isl_stat isl_options_set_tab_sparse_density(isl_ctx *ctx, int val);
+int isl_options_get_tab_sparse_density(isl_ctx *ctx);
+
 isl_stat isl_options_set_coalesce_bounded_wrapping(isl_ctx *ctx, int val);
 int isl_options_get_coalesce_bounded_wrapping(isl_ctx *ctx);
 
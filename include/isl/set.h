@@ -200,6 +200,12 @@ __isl_give isl_pw_multi_aff *isl_set_lexmin_pw_multi_aff(
 	__isl_take isl_set *set);
 __isl_give isl_pw_multi_aff *isl_set_lexmax_pw_multi_aff(
 	__isl_take isl_set *set);
+isl_stat isl_basic_set_foreach_lexmin(__isl_keep isl_basic_set *bset,
+	isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user), void *user);
+isl_stat isl_basic_set_foreach_lexmax(__isl_keep isl_basic_set *bset,
+	isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user), void *user);
 
 __isl_export
 __isl_give isl_set *isl_basic_set_union(
@@ -0,0 +1,326 @@
+/*
+ * Copyright 2016      Sven Verdoolaege
+ *
+ * Use of this software is governed by the MIT license
+ *
+ * Written by Sven Verdoolaege
+ */
+
+#include <isl_ctx_private.h>
+#include <isl_map_private.h>
+#include <isl_seq.h>
+#include <isl_vec_private.h>
+#include <isl_basic_map_cache.h>
+
+/* An entry in the basic map cache, recording that "test" applied
+ * to "bmap1" and "bmap2" (which may be NULL) returned "res".
+ * The basic maps are private copies with sorted inequality constraints.
+ * "hash" is the hash value of the test.
+ * "prev" and "next" point to the more and less recently used entries.
+ */
+struct isl_basic_map_cache_entry {
+	uint32_t hash;
+	isl_bool (*test)(__isl_keep isl_basic_map *bmap1,
+		__isl_keep isl_basic_map *bmap2);
+	isl_basic_map *bmap1;
+	isl_basic_map *bmap2;
+	isl_bool res;
+
+	struct isl_basic_map_cache_entry *prev;
+	struct isl_basic_map_cache_entry *next;
+};
+
+/* Return a private copy of "bmap" with sorted inequality constraints,
+ * such that basic maps that only differ in the order of their
+ * inequality constraints are mapped to the same key.
+ * The cached sample is not needed for comparing keys and
+ * is therefore dropped from the copy.
+ */
+static __isl_give isl_basic_map *cache_key(__isl_keep isl_basic_map *bmap)
+{
+	if (!bmap)
+		return NULL;
+	bmap = isl_basic_map_cow(isl_basic_map_copy(bmap));
+	if (!bmap)
+		return NULL;
+	isl_vec_free(bmap->sample);
+	bmap->sample = NULL;
+	return isl_basic_map_sort_constraints(bmap);
+}
+
+/* Update "hash" with the hash value of "bmap", which may be NULL.
+ * Only the parts of "bmap" that are compared by
+ * isl_basic_map_plain_cmp are taken into account.
+ */
+static uint32_t hash_key(uint32_t hash, __isl_keep isl_basic_map *bmap)
+{
+	int i;
+	unsigned total;
+
+	if (!bmap) {
+		isl_hash_byte(hash, 0);
+		return hash;
+	}
+
+	isl_hash_word(hash, ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL));
+	isl_hash_word(hash, isl_basic_map_dim(bmap, isl_dim_all));
+	isl_hash_word(hash, ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY));
+	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
+		return hash;
+	total = isl_basic_map_total_dim(bmap);
+	isl_hash_word(hash, bmap->n_eq);
+	for (i = 0; i < bmap->n_eq; ++i)
+		isl_hash_hash(hash, isl_seq_get_hash(bmap->eq[i], 1 + total));
+	isl_hash_word(hash, bmap->n_ineq);
+	for (i = 0; i < bmap->n_ineq; ++i)
+		isl_hash_hash(hash, isl_seq_get_hash(bmap->ineq[i], 1 + total));
+	isl_hash_word(hash, bmap->n_div);
+	for (i = 0; i < bmap->n_div; ++i)
+		isl_hash_hash(hash, isl_seq_get_hash(bmap->div[i], 2 + total));
+
+	return hash;
+}
+
+/* Are "key" and "bmap", either of which may be NULL, the same
+ * for the purpose of the basic map cache?
+ * That is, do they live in the same space and do they have
+ * the same constraints?
+ */
+static isl_bool same_key(__isl_keep isl_basic_map *key,
+	__isl_keep isl_basic_map *bmap)
+{
+	isl_bool equal;
+
+	if (!key || !bmap)
+		return key == bmap;
+	equal = isl_space_is_equal(key->dim, bmap->dim);
+	if (equal < 0 || !equal)
+		return equal;
+	return isl_basic_map_plain_cmp(key, bmap) == 0;
+}
+
+/* The test that is being looked up in the basic map cache.
+ */
+struct isl_basic_map_cache_query {
+	isl_bool (*test)(__isl_keep isl_basic_map *bmap1,
+		__isl_keep isl_basic_map *bmap2);
+	isl_basic_map *bmap1;
+	isl_basic_map *bmap2;
+};
+
+/* Does the cache entry "entry" correspond to the query "val"?
+ */
+static int has_query(const void *entry, const void *val)
+{
+	const struct isl_basic_map_cache_entry *e = entry;
+	const struct isl_basic_map_cache_query *q = val;
+	isl_bool equal;
+
+	if (e->test != q->test)
+		return 0;
+	equal = same_key(e->bmap1, q->bmap1);
+	if (equal < 0 || !equal)
+		return 0;
+	equal = same_key(e->bmap2, q->bmap2);
+	return equal == isl_bool_true;
+}
+
+/* Is "entry" equal to "val"?
+ */
+static int is_entry(const void *entry, const void *val)
+{
+	return entry == val;
+}
+
+/* Remove "entry" from the list of entries of "cache".
+ */
+static void unlink_entry(struct isl_basic_map_cache *cache,
+	struct isl_basic_map_cache_entry *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		cache->first = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		cache->last = entry->prev;
+}
+
+/* Insert "entry" at the start of the list of entries of "cache",
+ * marking it as the most recently used entry.
+ */
+static void link_entry(struct isl_basic_map_cache *cache,
+	struct isl_basic_map_cache_entry *entry)
+{
+	entry->prev = NULL;
+	entry->next = cache->first;
+	if (cache->first)
+		cache->first->prev = entry;
+	else
+		cache->last = entry;
+	cache->first = entry;
+}
+
+/* Remove "entry" from the basic map cache of "ctx" and free it.
+ */
+static void evict(isl_ctx *ctx, struct isl_basic_map_cache_entry *entry)
+{
+	struct isl_basic_map_cache *cache = &ctx->basic_map_cache;
+	struct isl_hash_table_entry *table_entry;
+
+	table_entry = isl_hash_table_find(ctx, &cache->table, entry->hash,
+					&is_entry, entry, 0);
+	if (table_entry)
+		isl_hash_table_remove(ctx, &cache->table, table_entry);
+	unlink_entry(cache, entry);
+	cache->n--;
+	isl_basic_map_free(entry->bmap1);
+	isl_basic_map_free(entry->bmap2);
+	free(entry);
+}
+
+/* Record that applying the test of "query" to the basic maps
+ * of "query" resulted in "res", taking ownership of those basic maps.
+ * Make room by evicting the least recently used entries if needed.
+ * Failure to add the entry is not considered to be an error
+ * since the result is then simply not cached.
+ */
+static void insert(isl_ctx *ctx, uint32_t hash,
+	struct isl_basic_map_cache_query *query, isl_bool res)
+{
+	struct isl_basic_map_cache *cache = &ctx->basic_map_cache;
+	struct isl_hash_table_entry *table_entry;
+	struct isl_basic_map_cache_entry *entry;
+
+	while (cache->n >= cache->max_size && cache->last)
+		evict(ctx, cache->last);
+
+	if (!cache->table.entries &&
+	    isl_hash_table_init(ctx, &cache->table, 16) < 0)
+		goto drop;
+	table_entry = isl_hash_table_find(ctx, &cache->table, hash,
+					&has_query, query, 1);
+	if (!table_entry)
+		goto drop;
+	if (table_entry->data) {
+		entry = table_entry->data;
+		entry->res = res;
+		goto drop;
+	}
+	entry = isl_alloc_type(ctx, struct isl_basic_map_cache_entry);
+	if (!entry) {
+		isl_hash_table_remove(ctx, &cache->table, table_entry);
+		goto drop;
+	}
+
+	entry->hash = hash;
+	entry->test = query->test;
+	entry->bmap1 = query->bmap1;
+	entry->bmap2 = query->bmap2;
+	entry->res = res;
+	table_entry->data = entry;
+	link_entry(cache, entry);
+	cache->n++;
+	return;
+drop:
+	isl_basic_map_free(query->bmap1);
+	isl_basic_map_free(query->bmap2);
+}
+
+/* Apply "test" to "bmap1" and "bmap2", where "bmap2" may be NULL,
+ * looking up the result in the basic map cache of the isl_ctx of "bmap1"
+ * and adding it to the cache if it is not in there yet.
+ * If the cache is disabled, then "test" is simply called.
+ *
+ * "test" is assumed to only depend on the spaces and the constraints
+ * of the basic maps and not on the order of the inequality constraints.
+ * The cache is keyed on private copies of the inputs
+ * with sorted inequality constraints.
+ * Note that "test" may itself perform cached tests, possibly evicting
+ * other entries, so the cache is only updated after "test" returns.
+ * Errors are not cached.
+ */
+isl_bool isl_basic_map_cache_test(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2,
+	isl_bool (*test)(__isl_keep isl_basic_map *bmap1,
+		__isl_keep isl_basic_map *bmap2))
+{
+	isl_ctx *ctx;
+	struct isl_basic_map_cache *cache;
+	struct isl_basic_map_cache_query query;
+	struct isl_hash_table_entry *table_entry;
+	struct isl_basic_map_cache_entry *entry;
+	uint32_t hash;
+	isl_bool res;
+
+	if (!bmap1)
+		return isl_bool_error;
+	ctx = isl_basic_map_get_ctx(bmap1);
+	cache = &ctx->basic_map_cache;
+	if (cache->max_size == 0)
+		return test(bmap1, bmap2);
+
+	query.test = test;
+	query.bmap1 = cache_key(bmap1);
+	query.bmap2 = cache_key(bmap2);
+	if (!query.bmap1 || (bmap2 && !query.bmap2)) {
+		isl_basic_map_free(query.bmap1);
+		isl_basic_map_free(query.bmap2);
+		return isl_bool_error;
+	}
+
+	hash = isl_hash_init();
+	isl_hash_builtin(hash, test);
+	hash = hash_key(hash, query.bmap1);
+	hash = hash_key(hash, query.bmap2);
+
+	table_entry = NULL;
+	if (cache->table.entries)
+		table_entry = isl_hash_table_find(ctx, &cache->table, hash,
+						&has_query, &query, 0);
+	if (table_entry) {
+		entry = table_entry->data;
+		unlink_entry(cache, entry);
+		link_entry(cache, entry);
+		cache->n_hit++;
+		isl_basic_map_free(query.bmap1);
+		isl_basic_map_free(query.bmap2);
+		return entry->res;
+	}
+
+	cache->n_miss++;
+	res = test(bmap1, bmap2);
+	if (res < 0 || cache->max_size == 0) {
+		isl_basic_map_free(query.bmap1);
+		isl_basic_map_free(query.bmap2);
+		return res;
+	}
+	insert(ctx, hash, &query, res);
+
+	return res;
+}
+
+/* Evict the least recently used entries from the basic map cache
+ * of "ctx" until the number of entries no longer exceeds the maximum.
+ */
+void isl_basic_map_cache_trim(isl_ctx *ctx)
+{
+	struct isl_basic_map_cache *cache = &ctx->basic_map_cache;
+
+	while (cache->n > cache->max_size && cache->last)
+		evict(ctx, cache->last);
+}
+
+/* Free all entries in the basic map cache of "ctx" and release
+ * the memory used for keeping track of them.
+ */
+void isl_basic_map_cache_clear(isl_ctx *ctx)
+{
+	struct isl_basic_map_cache *cache = &ctx->basic_map_cache;
+
+	while (cache->last)
+		evict(ctx, cache->last);
+	isl_hash_table_clear(&cache->table);
+	cache->table.entries = NULL;
+}
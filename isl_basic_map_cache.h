@@ -0,0 +1,46 @@
+#ifndef ISL_BASIC_MAP_CACHE_H
+#define ISL_BASIC_MAP_CACHE_H
+
+#include <isl/hash.h>
+#include <isl/map_type.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct isl_basic_map_cache_entry;
+
+/* A cache of the results of tests on (pairs of) basic maps,
+ * such as emptiness and subset tests.
+ *
+ * "table" maps the hash of a test to the corresponding entry and
+ * is only initialized when the first entry is added.
+ * "n" is the number of entries and "max_size" is the maximal value of "n".
+ * The entries are also kept in a doubly linked list, from "first",
+ * the most recently used entry, to "last", the least recently used entry,
+ * which is the first to be evicted when room is needed.
+ * "n_hit" and "n_miss" keep track of the number of tests that
+ * could and could not be answered from the cache.
+ */
+struct isl_basic_map_cache {
+	struct isl_hash_table			table;
+	unsigned long				n;
+	unsigned long				max_size;
+	unsigned long				n_hit;
+	unsigned long				n_miss;
+	struct isl_basic_map_cache_entry	*first;
+	struct isl_basic_map_cache_entry	*last;
+};
+
+isl_bool isl_basic_map_cache_test(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2,
+	isl_bool (*test)(__isl_keep isl_basic_map *bmap1,
+		__isl_keep isl_basic_map *bmap2));
+void isl_basic_map_cache_trim(isl_ctx *ctx);
+void isl_basic_map_cache_clear(isl_ctx *ctx);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
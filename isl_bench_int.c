@@ -0,0 +1,610 @@
+/*
+ * Copyright 2016      Sven Verdoolaege
+ *
+ * Use of this software is governed by the MIT license
+ *
+ * Written by Sven Verdoolaege
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <isl_ctx_private.h>
+#include <isl_map_private.h>
+#include <isl_mat_private.h>
+#include <isl_seq.h>
+#include <isl_int.h>
+#include <isl_id_private.h>
+#include <isl_space_private.h>
+
+/* Benchmark the isl_int implementation selected at configure time
+ * (--with-int=gmp|imath|imath-32|imath-64).
+ *
+ * The benchmark first measures the throughput of individual isl_int
+ * operations on values of increasing bit sizes and then
+ * the throughput of the operations that dominate typical isl
+ * computations, i.e., row normalization (isl_seq_normalize),
+ * Hermite normal form computation (isl_mat_left_hermite) and
+ * tableau pivoting (through emptiness checks and sampling of
+ * randomly generated polytopes).
+ * The speed and quality of the hash functions on integer rows,
+ * identifiers and spaces are measured separately.
+ *
+ * All inputs are generated from a fixed seed such that the same
+ * workload is replayed for each backend.  Comparing the output of
+ * builds configured with different backends then shows which backend
+ * is best suited for which sizes of values.
+ * For the small integer optimization, the fraction of results
+ * that had to be promoted to big representation is also reported.
+ *
+ * The optional argument is a scale factor for the number of repetitions.
+ */
+
+#define ARRAY_SIZE(array) (sizeof(array)/sizeof(*array))
+
+#define N_VAL		1024
+#define ROW_LEN		16
+#define N_ROW		256
+#define MAT_SIZE	6
+#define N_MAT		64
+#define DIM		4
+#define N_INEQ		6
+#define N_BSET		32
+#define N_HASH		4096
+#define HASH_BITS	12
+
+#ifdef USE_SMALL_INT_OPT_64
+static const char *backend = "imath-64";
+#elif defined(USE_SMALL_INT_OPT)
+static const char *backend = "imath-32";
+#elif defined(USE_IMATH_FOR_MP)
+static const char *backend = "imath";
+#else
+static const char *backend = "gmp";
+#endif
+
+#ifdef USE_SMALL_INT_OPT
+/* Return the number of elements of "p" of length "len"
+ * that are stored in big representation.
+ */
+static int count_big(isl_int *p, int len)
+{
+	int i;
+	int n = 0;
+
+	for (i = 0; i < len; ++i)
+		if (isl_sioimath_is_big(*p[i]))
+			n++;
+
+	return n;
+}
+
+/* Print the fraction of "n" values that are in big representation,
+ * given that "n_big" of them are.
+ * If "n" is zero, then no values have been checked.
+ */
+static void print_promoted(long n_big, long n)
+{
+	if (n == 0)
+		printf(" %9s\n", "-");
+	else
+		printf(" %8.1f%%\n", 100.0 * n_big / n);
+}
+#else
+static int count_big(isl_int *p, int len)
+{
+	return 0;
+}
+
+static void print_promoted(long n_big, long n)
+{
+	printf(" %9s\n", "-");
+}
+#endif
+
+/* A simple linear congruential generator such that the generated
+ * values are the same on all platforms.
+ */
+static unsigned long bench_rand(unsigned long *state)
+{
+	*state = (*state * 1103515245UL + 12345UL) & 0xffffffffUL;
+	return *state >> 1;
+}
+
+/* Set "v" to a random value with at most "bits" bits in absolute value,
+ * which is non-zero if "nonzero" is set.
+ */
+static void random_value(isl_int v, int bits, int nonzero,
+	unsigned long *state)
+{
+	int chunk;
+
+	isl_int_set_si(v, 0);
+	while (bits > 0) {
+		chunk = bits < 30 ? bits : 30;
+		isl_int_mul_2exp(v, v, chunk);
+		isl_int_add_ui(v, v, bench_rand(state) & ((1UL << chunk) - 1));
+		bits -= chunk;
+	}
+	if (nonzero && isl_int_is_zero(v))
+		isl_int_set_si(v, 1);
+	if (bench_rand(state) & 1)
+		isl_int_neg(v, v);
+}
+
+/* The sizes of the values used in the benchmarks.
+ * The sizes are chosen to be just below and just above the limits
+ * of the small representations.
+ */
+static struct {
+	const char *name;
+	int bits;
+} sizes[] = {
+	{ "15 bit", 15 },
+	{ "31 bit", 31 },
+	{ "40 bit", 40 },
+	{ "62 bit", 62 },
+	{ "128 bit", 128 },
+};
+
+static void op_add(isl_int r, isl_int a, isl_int b)
+{
+	isl_int_add(r, a, b);
+}
+
+static void op_sub(isl_int r, isl_int a, isl_int b)
+{
+	isl_int_sub(r, a, b);
+}
+
+static void op_mul(isl_int r, isl_int a, isl_int b)
+{
+	isl_int_mul(r, a, b);
+}
+
+static void op_addmul(isl_int r, isl_int a, isl_int b)
+{
+	isl_int_set(r, a);
+	isl_int_addmul(r, a, b);
+}
+
+static void op_submul(isl_int r, isl_int a, isl_int b)
+{
+	isl_int_set(r, a);
+	isl_int_submul(r, a, b);
+}
+
+static void op_divexact(isl_int r, isl_int a, isl_int b)
+{
+	isl_int_divexact(r, a, b);
+}
+
+static void op_fdiv_q(isl_int r, isl_int a, isl_int b)
+{
+	isl_int_fdiv_q(r, a, b);
+}
+
+static void op_gcd(isl_int r, isl_int a, isl_int b)
+{
+	isl_int_gcd(r, a, b);
+}
+
+static void op_cmp(isl_int r, isl_int a, isl_int b)
+{
+	isl_int_set_si(r, isl_int_cmp(a, b));
+}
+
+/* The isl_int operations that are benchmarked.
+ * If "exact" is set, then the first argument is replaced
+ * by its product with the second argument.
+ * The fused operations first copy the first argument to the result
+ * such that the result does not keep on growing.
+ */
+static struct {
+	const char *name;
+	void (*fn)(isl_int r, isl_int a, isl_int b);
+	int exact;
+} ops[] = {
+	{ "add", &op_add, 0 },
+	{ "sub", &op_sub, 0 },
+	{ "mul", &op_mul, 0 },
+	{ "addmul", &op_addmul, 0 },
+	{ "submul", &op_submul, 0 },
+	{ "divexact", &op_divexact, 1 },
+	{ "fdiv_q", &op_fdiv_q, 0 },
+	{ "gcd", &op_gcd, 0 },
+	{ "cmp", &op_cmp, 0 },
+};
+
+/* Return the number of seconds spent between "start" and "end".
+ */
+static double elapsed(clock_t start, clock_t end)
+{
+	return (double) (end - start) / CLOCKS_PER_SEC;
+}
+
+/* Print the throughput of "n" operations performed in "t" seconds
+ * in thousands of operations per second.
+ */
+static void print_rate(const char *name, const char *size, long n, double t)
+{
+	printf("%-16s %-8s %12.1f", name, size, t > 0 ? n / t / 1e3 : 0.0);
+}
+
+/* Benchmark each of the operations in "ops" on values of each of
+ * the sizes in "sizes", repeating each operation "rounds" times
+ * on each of N_VAL pairs of arguments.
+ */
+static void bench_ops(int rounds)
+{
+	int i, j, k, s;
+	unsigned long state = 1;
+	isl_int a[N_VAL], b[N_VAL], r[N_VAL];
+	clock_t start;
+	double t;
+	long n_big;
+
+	for (k = 0; k < N_VAL; ++k) {
+		isl_int_init(a[k]);
+		isl_int_init(b[k]);
+		isl_int_init(r[k]);
+	}
+
+	for (s = 0; s < ARRAY_SIZE(sizes); ++s) {
+		for (i = 0; i < ARRAY_SIZE(ops); ++i) {
+			for (k = 0; k < N_VAL; ++k) {
+				random_value(a[k], sizes[s].bits, 0, &state);
+				random_value(b[k], sizes[s].bits, 1, &state);
+				if (ops[i].exact)
+					isl_int_mul(a[k], a[k], b[k]);
+				isl_int_set_si(r[k], 0);
+			}
+			start = clock();
+			for (j = 0; j < rounds; ++j)
+				for (k = 0; k < N_VAL; ++k)
+					ops[i].fn(r[k], a[k], b[k]);
+			t = elapsed(start, clock());
+			n_big = count_big(r, N_VAL);
+			print_rate(ops[i].name, sizes[s].name,
+				    (long) rounds * N_VAL, t);
+			print_promoted(n_big, N_VAL);
+		}
+	}
+
+	for (k = 0; k < N_VAL; ++k) {
+		isl_int_clear(a[k]);
+		isl_int_clear(b[k]);
+		isl_int_clear(r[k]);
+	}
+}
+
+/* Benchmark isl_seq_normalize on N_ROW rows of length ROW_LEN
+ * with elements of each of the sizes in "sizes" that have
+ * a random common factor.
+ * Each row is copied before it is normalized.
+ */
+static void bench_normalize(isl_ctx *ctx, int rounds)
+{
+	int i, j, k, s;
+	unsigned long state = 2;
+	isl_mat *src, *dst;
+	isl_int f;
+	clock_t start;
+	double t;
+	long n_big;
+
+	src = isl_mat_alloc(ctx, N_ROW, ROW_LEN);
+	dst = isl_mat_alloc(ctx, N_ROW, ROW_LEN);
+	if (!src || !dst)
+		goto error;
+
+	isl_int_init(f);
+	for (s = 0; s < ARRAY_SIZE(sizes); ++s) {
+		for (i = 0; i < N_ROW; ++i) {
+			random_value(f, 10, 1, &state);
+			for (k = 0; k < ROW_LEN; ++k) {
+				random_value(src->row[i][k],
+					    sizes[s].bits - 10, 0, &state);
+				isl_int_mul(src->row[i][k], src->row[i][k], f);
+			}
+		}
+		start = clock();
+		for (j = 0; j < rounds; ++j)
+			for (i = 0; i < N_ROW; ++i) {
+				isl_seq_cpy(dst->row[i], src->row[i], ROW_LEN);
+				isl_seq_normalize(ctx, dst->row[i], ROW_LEN);
+			}
+		t = elapsed(start, clock());
+		n_big = 0;
+		for (i = 0; i < N_ROW; ++i)
+			n_big += count_big(dst->row[i], ROW_LEN);
+		print_rate("seq_normalize", sizes[s].name,
+			    (long) rounds * N_ROW, t);
+		print_promoted(n_big, N_ROW * ROW_LEN);
+	}
+	isl_int_clear(f);
+
+error:
+	isl_mat_free(src);
+	isl_mat_free(dst);
+}
+
+/* Benchmark isl_mat_left_hermite on N_MAT square matrices
+ * of size MAT_SIZE with elements of each of the sizes in "sizes".
+ */
+static void bench_hermite(isl_ctx *ctx, int rounds)
+{
+	int i, j, k, l, s;
+	unsigned long state = 3;
+	isl_mat *mat[N_MAT];
+	isl_mat *h;
+	clock_t start;
+	double t;
+	long n_big;
+
+	for (s = 0; s < ARRAY_SIZE(sizes); ++s) {
+		for (i = 0; i < N_MAT; ++i) {
+			mat[i] = isl_mat_alloc(ctx, MAT_SIZE, MAT_SIZE);
+			if (!mat[i])
+				continue;
+			for (k = 0; k < MAT_SIZE; ++k)
+				for (l = 0; l < MAT_SIZE; ++l)
+					random_value(mat[i]->row[k][l],
+						    sizes[s].bits, 0, &state);
+		}
+		n_big = 0;
+		start = clock();
+		for (j = 0; j < rounds; ++j)
+			for (i = 0; i < N_MAT; ++i) {
+				h = isl_mat_left_hermite(isl_mat_copy(mat[i]),
+							0, NULL, NULL);
+				if (h && j == 0)
+					for (k = 0; k < MAT_SIZE; ++k)
+						n_big += count_big(h->row[k],
+								MAT_SIZE);
+				isl_mat_free(h);
+			}
+		t = elapsed(start, clock());
+		print_rate("mat_left_hermite", sizes[s].name,
+			    (long) rounds * N_MAT, t);
+		print_promoted(n_big, N_MAT * MAT_SIZE * MAT_SIZE);
+		for (i = 0; i < N_MAT; ++i)
+			isl_mat_free(mat[i]);
+	}
+}
+
+/* Construct a random polytope of dimension DIM with N_INEQ random
+ * constraints inside a box with sides of "bits" bits.
+ * The coefficients of the variables are small, while
+ * the constant terms are of the same order as the size of the box,
+ * such that roughly half of the polytopes are empty.
+ * The size of the values in the tableau is then mainly determined
+ * by "bits", while the problems remain easy to solve.
+ */
+static __isl_give isl_basic_set *random_polytope(isl_ctx *ctx, int bits,
+	unsigned long *state)
+{
+	int i, j, k;
+	isl_basic_set *bset;
+
+	bset = isl_basic_set_alloc(ctx, 0, DIM, 0, 0, 2 * DIM + N_INEQ);
+	for (i = 0; i < DIM; ++i) {
+		k = isl_basic_set_alloc_inequality(bset);
+		if (k < 0)
+			return isl_basic_set_free(bset);
+		isl_seq_clr(bset->ineq[k], 1 + DIM);
+		isl_int_set_si(bset->ineq[k][0], 1);
+		isl_int_mul_2exp(bset->ineq[k][0], bset->ineq[k][0], bits);
+		isl_int_set_si(bset->ineq[k][1 + i], 1);
+		k = isl_basic_set_alloc_inequality(bset);
+		if (k < 0)
+			return isl_basic_set_free(bset);
+		isl_seq_clr(bset->ineq[k], 1 + DIM);
+		isl_int_set_si(bset->ineq[k][0], 1);
+		isl_int_mul_2exp(bset->ineq[k][0], bset->ineq[k][0], bits);
+		isl_int_set_si(bset->ineq[k][1 + i], -1);
+	}
+	for (i = 0; i < N_INEQ; ++i) {
+		k = isl_basic_set_alloc_inequality(bset);
+		if (k < 0)
+			return isl_basic_set_free(bset);
+		random_value(bset->ineq[k][0], bits, 0, state);
+		for (j = 1; j < 1 + DIM; ++j)
+			random_value(bset->ineq[k][j], 4, 0, state);
+	}
+
+	return isl_basic_set_finalize(bset);
+}
+
+/* Benchmark tableau operations by checking the emptiness of
+ * and computing a sample point for N_BSET random polytopes
+ * with coefficients of each of the sizes in "sizes".
+ */
+static void bench_tab(isl_ctx *ctx, int rounds)
+{
+	int i, j, s;
+	unsigned long state = 4;
+	isl_basic_set *bset[N_BSET];
+	clock_t start;
+	double t;
+
+	for (s = 0; s < ARRAY_SIZE(sizes); ++s) {
+		for (i = 0; i < N_BSET; ++i)
+			bset[i] = random_polytope(ctx, sizes[s].bits, &state);
+		start = clock();
+		for (j = 0; j < rounds; ++j)
+			for (i = 0; i < N_BSET; ++i) {
+				isl_basic_set_is_empty(bset[i]);
+				isl_basic_set_free(isl_basic_set_sample(
+					    isl_basic_set_copy(bset[i])));
+			}
+		t = elapsed(start, clock());
+		print_rate("tab", sizes[s].name, (long) rounds * N_BSET, t);
+		print_promoted(0, 0);
+		for (i = 0; i < N_BSET; ++i)
+			isl_basic_set_free(bset[i]);
+	}
+}
+
+/* Return the number of collisions that are expected when "n" distinct
+ * values are hashed into 2^"bits" buckets by a perfectly random hash function.
+ */
+static double expected_collisions(int n, int bits)
+{
+	int i;
+	double m = 1 << bits;
+	double empty = 1;
+
+	for (i = 0; i < n; ++i)
+		empty *= 1 - 1 / m;
+
+	return n - m * (1 - empty);
+}
+
+/* Return the number of collisions among the "n" hash values in "hash"
+ * that occur when they are reduced to "bits" bits,
+ * i.e., "n" minus the number of distinct buckets that are hit.
+ */
+static int count_collisions(uint32_t *hash, int n, int bits)
+{
+	int i;
+	int n_hit = 0;
+	char *hit;
+
+	hit = calloc(1 << bits, 1);
+	if (!hit)
+		return -1;
+	for (i = 0; i < n; ++i) {
+		uint32_t h = isl_hash_bits(hash[i], bits);
+		if (!hit[h])
+			n_hit++;
+		hit[h] = 1;
+	}
+	free(hit);
+
+	return n - n_hit;
+}
+
+/* Print the ratio of the number of collisions among the "n" hash values
+ * in "hash" and the number of collisions that is expected
+ * for a random hash function.
+ * A ratio close to 1 indicates a good hash function.
+ */
+static void print_quality(uint32_t *hash, int n)
+{
+	int n_coll;
+
+	n_coll = count_collisions(hash, n, HASH_BITS);
+	printf(" %8.2fx\n", n_coll / expected_collisions(n, HASH_BITS));
+}
+
+/* Benchmark isl_seq_get_hash on N_HASH rows of length ROW_LEN
+ * with elements of each of the sizes in "sizes" and
+ * check the quality of the resulting hash values.
+ * The rows are all perturbations of the same row
+ * in a single position by a small amount, as is typical
+ * for the constraints that are compared in isl_basic_map_sort_constraints
+ * or when removing duplicate constraints.
+ * Finally, measure the speed and quality of hashing the names
+ * of identifiers with similar names and of hashing spaces
+ * with such identifiers as parameters.
+ */
+static void bench_hash(isl_ctx *ctx, int rounds)
+{
+	int i, j, s;
+	unsigned long state = 5;
+	isl_mat *mat;
+	isl_id *id[N_HASH];
+	isl_space *space[N_HASH];
+	uint32_t hash[N_HASH];
+	char name[20];
+	clock_t start;
+	double t;
+
+	printf("%-16s %-8s %12s %9s\n", "hash", "values", "kops/s",
+		"coll/exp");
+
+	mat = isl_mat_alloc(ctx, N_HASH, ROW_LEN);
+	if (!mat)
+		return;
+	for (s = 0; s < ARRAY_SIZE(sizes); ++s) {
+		for (j = 0; j < ROW_LEN; ++j)
+			random_value(mat->row[0][j], sizes[s].bits, 0, &state);
+		for (i = 1; i < N_HASH; ++i) {
+			isl_seq_cpy(mat->row[i], mat->row[0], ROW_LEN);
+			isl_int_add_ui(mat->row[i][i % ROW_LEN],
+				    mat->row[i][i % ROW_LEN], i / ROW_LEN + 1);
+		}
+		start = clock();
+		for (j = 0; j < rounds; ++j)
+			for (i = 0; i < N_HASH; ++i)
+				hash[i] = isl_seq_get_hash(mat->row[i],
+							    ROW_LEN);
+		t = elapsed(start, clock());
+		print_rate("seq_get_hash", sizes[s].name,
+			    (long) rounds * N_HASH, t);
+		print_quality(hash, N_HASH);
+	}
+	isl_mat_free(mat);
+
+	for (i = 0; i < N_HASH; ++i) {
+		snprintf(name, sizeof(name), "i%d", i);
+		id[i] = isl_id_alloc(ctx, name, NULL);
+	}
+	start = clock();
+	for (j = 0; j < rounds; ++j)
+		for (i = 0; i < N_HASH; ++i)
+			hash[i] = isl_hash_string(isl_hash_init(),
+						isl_id_get_name(id[i]));
+	t = elapsed(start, clock());
+	print_rate("id name", "-", (long) rounds * N_HASH, t);
+	print_quality(hash, N_HASH);
+
+	for (i = 0; i < N_HASH; ++i) {
+		space[i] = isl_space_params_alloc(ctx, 2);
+		space[i] = isl_space_set_dim_id(space[i], isl_dim_param, 0,
+					    isl_id_copy(id[i]));
+		space[i] = isl_space_set_dim_id(space[i], isl_dim_param, 1,
+				    isl_id_copy(id[(i + 1) % N_HASH]));
+		space[i] = isl_space_set_from_params(space[i]);
+		space[i] = isl_space_add_dims(space[i], isl_dim_set, 1 + i % 3);
+	}
+	start = clock();
+	for (j = 0; j < rounds; ++j)
+		for (i = 0; i < N_HASH; ++i)
+			hash[i] = isl_space_get_hash(space[i]);
+	t = elapsed(start, clock());
+	print_rate("space", "-", (long) rounds * N_HASH, t);
+	print_quality(hash, N_HASH);
+
+	for (i = 0; i < N_HASH; ++i) {
+		isl_id_free(id[i]);
+		isl_space_free(space[i]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int scale = 1;
+	isl_ctx *ctx;
+
+	if (argc > 1)
+		scale = atoi(argv[1]);
+	if (scale < 1)
+		scale = 1;
+
+	ctx = isl_ctx_alloc();
+
+	printf("backend: %s\n", backend);
+	printf("%-16s %-8s %12s %9s\n", "operation", "values", "kops/s",
+		"promoted");
+	bench_ops(200 * scale);
+	bench_normalize(ctx, 100 * scale);
+	bench_hermite(ctx, 4 * scale);
+	bench_tab(ctx, scale);
+	bench_hash(ctx, 20 * scale);
+
+	isl_ctx_free(ctx);
+
+	return 0;
+}
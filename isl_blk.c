@@ -10,9 +10,6 @@
 #include <isl_blk.h>
 #include <isl_ctx_private.h>
 
-/* The maximal number of cache misses before first element is evicted */
-#define ISL_BLK_MAX_MISS	100
-
 struct isl_blk isl_blk_empty()
 {
 	struct isl_blk block;
@@ -71,34 +68,91 @@ static struct isl_blk extend(struct isl_ctx *ctx, struct isl_blk block,
 	return block;
 }
 
+/* Return the size class of a block of size "n" > 0,
+ * i.e., the position of the most significant bit of "n".
+ */
+static int get_size_class(size_t n)
+{
+	int c = 0;
+
+	while (n >>= 1)
+		++c;
+
+	return c;
+}
+
+/* Remove the most recently cached block of size class "c" from the cache
+ * and return it.
+ */
+static struct isl_blk pop(struct isl_blk_cache *cache, int c)
+{
+	struct isl_blk block;
+
+	block = cache->size_class[c].blk[--cache->size_class[c].n];
+	cache->n_cached -= block.size;
+
+	return block;
+}
+
+/* Add "block" to the cache, provided this does not make the total
+ * number of cached elements exceed the maximum.
+ * Return 0 if the block was added and -1 otherwise.
+ * The stack of a size class is only extended when it is full.
+ * Since the block is simply freed if this fails, there is no need
+ * to report an error.
+ */
+static int push(struct isl_blk_cache *cache, struct isl_blk block)
+{
+	int c;
+	struct isl_blk_class *cl;
+
+	if (block.size > cache->max_cached - cache->n_cached)
+		return -1;
+
+	c = get_size_class(block.size);
+	cl = &cache->size_class[c];
+	if (cl->n >= cl->size) {
+		int size = 2 * cl->size + 4;
+		struct isl_blk *blk;
+
+		blk = realloc(cl->blk, size * sizeof(struct isl_blk));
+		if (!blk)
+			return -1;
+		cl->blk = blk;
+		cl->size = size;
+	}
+
+	cl->blk[cl->n++] = block;
+	cache->n_cached += block.size;
+
+	return 0;
+}
+
+/* Allocate a block of "n" elements.
+ *
+ * If possible, reuse a cached block of the same size class,
+ * which may then have to be extended, or of the next size class,
+ * which is then large enough, but at most four times too large.
+ * Otherwise, a new block is allocated.
+ */
 struct isl_blk isl_blk_alloc(struct isl_ctx *ctx, size_t n)
 {
-	int i;
+	int c;
 	struct isl_blk block;
+	struct isl_blk_cache *cache = &ctx->block_cache;
 
 	block = isl_blk_empty();
-	if (n && ctx->n_cached) {
-		int best = 0;
-		for (i = 1; ctx->cache[best].size != n && i < ctx->n_cached; ++i) {
-			if (ctx->cache[best].size < n) {
-				if (ctx->cache[i].size > ctx->cache[best].size)
-					best = i;
-			} else if (ctx->cache[i].size >= n &&
-				   ctx->cache[i].size < ctx->cache[best].size)
-					best = i;
-		}
-		if (ctx->cache[best].size < 2 * n + 100) {
-			block = ctx->cache[best];
-			if (--ctx->n_cached != best)
-				ctx->cache[best] = ctx->cache[ctx->n_cached];
-			if (best == 0)
-				ctx->n_miss = 0;
-		} else if (ctx->n_miss++ >= ISL_BLK_MAX_MISS) {
-			isl_blk_free_force(ctx, ctx->cache[0]);
-			if (--ctx->n_cached != 0)
-				ctx->cache[0] = ctx->cache[ctx->n_cached];
-			ctx->n_miss = 0;
-		}
+	if (n) {
+		c = get_size_class(n);
+		if (cache->size_class[c].n > 0)
+			block = pop(cache, c);
+		else if (c + 1 < ISL_BLK_N_CLASS &&
+			    cache->size_class[c + 1].n > 0)
+			block = pop(cache, c + 1);
+		if (isl_blk_is_empty(block))
+			cache->n_miss++;
+		else
+			cache->n_hit++;
 	}
 
 	return extend(ctx, block, n);
@@ -113,22 +167,45 @@ struct isl_blk isl_blk_extend(struct isl_ctx *ctx, struct isl_blk block,
 	return extend(ctx, block, new_n);
 }
 
+/* Free "block", keeping it in the cache of "ctx" if there is room.
+ */
 void isl_blk_free(struct isl_ctx *ctx, struct isl_blk block)
 {
 	if (isl_blk_is_empty(block) || isl_blk_is_error(block))
 		return;
 
-	if (ctx->n_cached < ISL_BLK_CACHE_SIZE)
-		ctx->cache[ctx->n_cached++] = block;
-	else
+	if (push(&ctx->block_cache, block) < 0)
 		isl_blk_free_force(ctx, block);
 }
 
-void isl_blk_clear_cache(struct isl_ctx *ctx)
+/* Free cached blocks, starting from the largest size class,
+ * until the total number of cached elements no longer exceeds
+ * the maximum.
+ */
+void isl_blk_trim_cache(struct isl_ctx *ctx)
 {
-	int i;
+	int c;
+	struct isl_blk_cache *cache = &ctx->block_cache;
+
+	for (c = ISL_BLK_N_CLASS - 1; c >= 0; --c)
+		while (cache->n_cached > cache->max_cached &&
+		    cache->size_class[c].n > 0)
+			isl_blk_free_force(ctx, pop(cache, c));
+}
 
-	for (i = 0; i < ctx->n_cached; ++i)
-		isl_blk_free_force(ctx, ctx->cache[i]);
-	ctx->n_cached = 0;
+/* Free all cached blocks and release the memory used
+ * for keeping track of them.
+ */
+void isl_blk_clear_cache(struct isl_ctx *ctx)
+{
+	int c;
+	struct isl_blk_cache *cache = &ctx->block_cache;
+
+	for (c = 0; c < ISL_BLK_N_CLASS; ++c) {
+		while (cache->size_class[c].n > 0)
+			isl_blk_free_force(ctx, pop(cache, c));
+		free(cache->size_class[c].blk);
+		cache->size_class[c].blk = NULL;
+		cache->size_class[c].size = 0;
+	}
 }
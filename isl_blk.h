@@ -21,7 +21,36 @@ struct isl_blk {
 	isl_int *data;
 };
 
-#define ISL_BLK_CACHE_SIZE	20
+/* The number of size classes of cached blocks.
+ * Size class i holds blocks with a size in [2^i, 2^(i+1)).
+ */
+#define ISL_BLK_N_CLASS		(8 * sizeof(size_t))
+
+/* A stack of "n" cached blocks of the same size class,
+ * with room for "size" blocks.
+ */
+struct isl_blk_class {
+	int n;
+	int size;
+	struct isl_blk *blk;
+};
+
+/* A cache of freed blocks, organized by size class.
+ * The elements of a cached block remain initialized such that
+ * they can be reused without calling isl_int_init.
+ *
+ * "n_cached" is the total number of elements in the cached blocks.
+ * "max_cached" is the maximal value of "n_cached".
+ * "n_hit" and "n_miss" keep track of the number of allocations
+ * that could and could not be served from the cache.
+ */
+struct isl_blk_cache {
+	size_t			n_cached;
+	unsigned long		max_cached;
+	unsigned long		n_hit;
+	unsigned long		n_miss;
+	struct isl_blk_class	size_class[ISL_BLK_N_CLASS];
+};
 
 struct isl_ctx;
 
@@ -32,6 +61,7 @@ struct isl_blk isl_blk_extend(struct isl_ctx *ctx, struct isl_blk block,
 				size_t new_n);
 void isl_blk_free(struct isl_ctx *ctx, struct isl_blk block);
 void isl_blk_clear_cache(struct isl_ctx *ctx);
+void isl_blk_trim_cache(struct isl_ctx *ctx);
 
 #if defined(__cplusplus)
 }
@@ -7,9 +7,11 @@
  * Computerwetenschappen, Celestijnenlaan 200A, B-3001 Leuven, Belgium
  */
 
+#include <string.h>
 #include <isl_ctx_private.h>
 #include <isl/vec.h>
 #include <isl_options_private.h>
+#include <isl_val_private.h>
 
 #define __isl_calloc(type,size)		((type *)calloc(1, size))
 #define __isl_calloc_type(type)		__isl_calloc(type,sizeof(type))
@@ -153,6 +155,7 @@ void *isl_ctx_peek_options(isl_ctx *ctx, struct isl_args *args)
 
 isl_ctx *isl_ctx_alloc_with_options(struct isl_args *args, void *user_opt)
 {
+	int i;
 	struct isl_ctx *ctx = NULL;
 	struct isl_options *opt = NULL;
 	int opt_allocated = 0;
@@ -199,8 +202,14 @@ isl_ctx *isl_ctx_alloc_with_options(struct isl_args *args, void *user_opt)
 
 	isl_int_init(ctx->normalize_gcd);
 
-	ctx->n_cached = 0;
-	ctx->n_miss = 0;
+	for (i = 0; i < ISL_CTX_N_SCRATCH; ++i)
+		isl_int_init(ctx->scratch[i]);
+	ctx->n_scratch = 0;
+	ctx->n_val_cache = 0;
+
+	isl_ctx_set_max_block_cache_size(ctx, ctx->opt->block_cache_size);
+	isl_ctx_set_max_basic_map_cache_size(ctx,
+					ctx->opt->basic_map_cache_size);
 
 	ctx->error = isl_error_none;
 
@@ -225,6 +234,194 @@ struct isl_ctx *isl_ctx_alloc()
 	return isl_ctx_alloc_with_options(&isl_options_args, opt);
 }
 
+/* Allocate an isl_ctx for performing part of a computation of "ctx"
+ * in a separate thread.
+ * The new isl_ctx receives a copy of all options of "ctx",
+ * except that it does not print any statistics when it is freed
+ * since those are added to the statistics of "ctx"
+ * by isl_ctx_merge_worker instead.
+ * The caller is responsible for turning off any options
+ * that would make the worker start threads of its own.
+ * The cache sizes and the quota on the number of operations
+ * of "ctx" are also copied.  The worker starts counting operations
+ * from the number of operations already performed by "ctx",
+ * such that it stops when the remaining operations of "ctx" run out.
+ * Since the worker runs concurrently with other threads,
+ * the total may still exceed the quota by the operations
+ * performed by those other threads.
+ * The excess is detected by "ctx" after isl_ctx_merge_worker.
+ */
+isl_ctx *isl_ctx_alloc_worker(isl_ctx *ctx)
+{
+	struct isl_options *opt;
+	char *iterator_type;
+	isl_ctx *worker;
+
+	if (!ctx)
+		return NULL;
+
+	opt = isl_options_new_with_defaults();
+	if (!opt)
+		return NULL;
+	iterator_type = opt->ast_iterator_type;
+	*opt = *ctx->opt;
+	opt->ast_iterator_type = iterator_type;
+	if (ctx->opt->ast_iterator_type) {
+		free(opt->ast_iterator_type);
+		opt->ast_iterator_type = strdup(ctx->opt->ast_iterator_type);
+	}
+	opt->print_stats = 0;
+
+	worker = isl_ctx_alloc_with_options(&isl_options_args, opt);
+	if (!worker)
+		return NULL;
+
+	isl_ctx_set_max_block_cache_size(worker,
+				isl_ctx_get_max_block_cache_size(ctx));
+	isl_ctx_set_max_basic_map_cache_size(worker,
+				isl_ctx_get_max_basic_map_cache_size(ctx));
+	worker->operations = ctx->operations;
+	worker->inherited_operations = ctx->operations;
+	worker->max_operations = ctx->max_operations;
+
+	return worker;
+}
+
+/* Add the counter "src" of a worker context to the corresponding
+ * counter "dst" of its parent and reset "src".
+ */
+static void merge_stat(long *dst, long *src)
+{
+	*dst += *src;
+	*src = 0;
+}
+
+/* Add the operations performed by "worker", allocated
+ * by isl_ctx_alloc_worker from "ctx", as well as its statistics
+ * to those of "ctx".
+ * Every field of struct isl_stats needs to be merged here.
+ */
+void isl_ctx_merge_worker(isl_ctx *ctx, isl_ctx *worker)
+{
+	struct isl_stats *dst, *src;
+
+	if (!ctx || !worker)
+		return;
+
+	ctx->operations += worker->operations - worker->inherited_operations;
+	worker->inherited_operations = worker->operations;
+
+	dst = ctx->stats;
+	src = worker->stats;
+	merge_stat(&dst->gbr_solved_lps, &src->gbr_solved_lps);
+	merge_stat(&dst->gbr_warm_starts, &src->gbr_warm_starts);
+	merge_stat(&dst->sample_parallel_searches,
+		    &src->sample_parallel_searches);
+	merge_stat(&dst->sample_cuts, &src->sample_cuts);
+	merge_stat(&dst->sample_cut_searches_avoided,
+		    &src->sample_cut_searches_avoided);
+	merge_stat(&dst->pip_parallel_branches, &src->pip_parallel_branches);
+	merge_stat(&dst->pip_shared_contexts, &src->pip_shared_contexts);
+	merge_stat(&dst->pip_splits, &src->pip_splits);
+	merge_stat(&dst->pip_pieces, &src->pip_pieces);
+	merge_stat(&dst->pip_cuts, &src->pip_cuts);
+	merge_stat(&dst->tab_pivots, &src->tab_pivots);
+	merge_stat(&dst->tab_degenerate_pivots, &src->tab_degenerate_pivots);
+	merge_stat(&dst->tab_sparse_pivots, &src->tab_sparse_pivots);
+	merge_stat(&dst->tab_float_accepted, &src->tab_float_accepted);
+	merge_stat(&dst->tab_float_rejected, &src->tab_float_rejected);
+	merge_stat(&dst->presolve_fixed_vars, &src->presolve_fixed_vars);
+	merge_stat(&dst->presolve_trivial_rows, &src->presolve_trivial_rows);
+	merge_stat(&dst->presolve_singleton_rows,
+		    &src->presolve_singleton_rows);
+	merge_stat(&dst->presolve_duplicate_rows,
+		    &src->presolve_duplicate_rows);
+	merge_stat(&dst->presolve_dominated_rows,
+		    &src->presolve_dominated_rows);
+}
+
+/* Return "n" consecutive initialized integers that can be used
+ * as temporaries until they are handed back to "ctx"
+ * through isl_ctx_scratch_release.
+ * The integers may hold arbitrary values and
+ * they need to be released in the reverse order of acquisition.
+ *
+ * The integers are taken from a stack of integers that are initialized
+ * when "ctx" is created and that keep their memory when they are released.
+ * Repeatedly acquiring and releasing temporaries therefore
+ * does not involve any memory allocation,
+ * unlike initializing and clearing local isl_ints.
+ * If the stack does not have enough room left,
+ * then a fresh array of integers is allocated instead.
+ */
+isl_int *isl_ctx_scratch_acquire(isl_ctx *ctx, int n)
+{
+	int i;
+	isl_int *v;
+
+	if (!ctx)
+		return NULL;
+
+	if (ctx->n_scratch + n <= ISL_CTX_N_SCRATCH) {
+		v = ctx->scratch + ctx->n_scratch;
+		ctx->n_scratch += n;
+		return v;
+	}
+
+	v = isl_alloc_array(ctx, isl_int, n);
+	if (!v)
+		return NULL;
+	for (i = 0; i < n; ++i)
+		isl_int_init(v[i]);
+	return v;
+}
+
+/* Does "v" point into the stack of scratch integers stored inside "ctx"?
+ * The position just past the end of the stack is also considered
+ * to be part of the stack since it is handed out for requests
+ * of zero integers on a full stack.
+ * Only equality comparisons are used since "v" may also have been
+ * allocated separately.
+ */
+static int is_stack_scratch(isl_ctx *ctx, isl_int *v)
+{
+	int i;
+
+	for (i = 0; i <= ISL_CTX_N_SCRATCH; ++i)
+		if (v == ctx->scratch + i)
+			return 1;
+	return 0;
+}
+
+/* Hand back the "n" temporaries "v" obtained from isl_ctx_scratch_acquire.
+ * If they were taken from the stack of "ctx", then
+ * they need to be on top of the stack and they are simply popped off.
+ * Releasing temporaries from the stack out of order is an error and
+ * leaves the stack untouched.
+ * Otherwise, they were freshly allocated and are freed.
+ */
+void isl_ctx_scratch_release(isl_ctx *ctx, isl_int *v, int n)
+{
+	int i;
+
+	if (!ctx || !v)
+		return;
+
+	if (is_stack_scratch(ctx, v)) {
+		if (ctx->n_scratch < n ||
+		    v != ctx->scratch + ctx->n_scratch - n)
+			isl_die(ctx, isl_error_internal,
+				"scratch integers released out of order",
+				return);
+		ctx->n_scratch -= n;
+		return;
+	}
+
+	for (i = 0; i < n; ++i)
+		isl_int_clear(v[i]);
+	free(v);
+}
+
 void isl_ctx_ref(struct isl_ctx *ctx)
 {
 	ctx->ref++;
@@ -241,12 +438,63 @@ void isl_ctx_deref(struct isl_ctx *ctx)
 static void print_stats(isl_ctx *ctx)
 {
 	fprintf(stderr, "operations: %lu\n", ctx->operations);
+	fprintf(stderr, "basis reduction LPs: %ld\n",
+		ctx->stats->gbr_solved_lps);
+	fprintf(stderr, "warm started basis reductions: %ld\n",
+		ctx->stats->gbr_warm_starts);
+	fprintf(stderr, "parallel integer point searches: %ld\n",
+		ctx->stats->sample_parallel_searches);
+	fprintf(stderr, "integer point search cuts: %ld\n",
+		ctx->stats->sample_cuts);
+	fprintf(stderr, "integer point searches avoided by cuts: %ld\n",
+		ctx->stats->sample_cut_searches_avoided);
+	fprintf(stderr, "parallel parametric integer programming branches: "
+		"%ld\n", ctx->stats->pip_parallel_branches);
+	fprintf(stderr, "shared parametric integer programming contexts: "
+		"%ld\n", ctx->stats->pip_shared_contexts);
+	fprintf(stderr, "parametric integer programming splits: %ld\n",
+		ctx->stats->pip_splits);
+	fprintf(stderr, "parametric integer programming pieces: %ld\n",
+		ctx->stats->pip_pieces);
+	fprintf(stderr, "parametric integer programming cuts: %ld\n",
+		ctx->stats->pip_cuts);
+	fprintf(stderr, "block cache hits: %lu\n", ctx->block_cache.n_hit);
+	fprintf(stderr, "block cache misses: %lu\n", ctx->block_cache.n_miss);
+	fprintf(stderr, "basic map cache hits: %lu\n",
+		ctx->basic_map_cache.n_hit);
+	fprintf(stderr, "basic map cache misses: %lu\n",
+		ctx->basic_map_cache.n_miss);
+	fprintf(stderr, "tableau pivots: %ld\n", ctx->stats->tab_pivots);
+	fprintf(stderr, "degenerate tableau pivots: %ld\n",
+		ctx->stats->tab_degenerate_pivots);
+	fprintf(stderr, "sparse tableau pivots: %ld\n",
+		ctx->stats->tab_sparse_pivots);
+	fprintf(stderr, "accepted floating point bases: %ld\n",
+		ctx->stats->tab_float_accepted);
+	fprintf(stderr, "rejected floating point bases: %ld\n",
+		ctx->stats->tab_float_rejected);
+	fprintf(stderr, "presolve fixed variables: %ld\n",
+		ctx->stats->presolve_fixed_vars);
+	fprintf(stderr, "presolve trivial rows: %ld\n",
+		ctx->stats->presolve_trivial_rows);
+	fprintf(stderr, "presolve singleton rows: %ld\n",
+		ctx->stats->presolve_singleton_rows);
+	fprintf(stderr, "presolve duplicate rows: %ld\n",
+		ctx->stats->presolve_duplicate_rows);
+	fprintf(stderr, "presolve dominated rows: %ld\n",
+		ctx->stats->presolve_dominated_rows);
 }
 
 void isl_ctx_free(struct isl_ctx *ctx)
 {
+	int i;
+
 	if (!ctx)
 		return;
+	isl_basic_map_cache_clear(ctx);
+	ctx->gbr_basis = isl_mat_free(ctx->gbr_basis);
+	ctx->gbr_ineq = isl_mat_free(ctx->gbr_ineq);
+	isl_val_clear_cache(ctx);
 	if (ctx->ref != 0)
 		isl_die(ctx, isl_error_invalid,
 			"isl_ctx freed, but some objects still reference it",
@@ -262,6 +510,8 @@ void isl_ctx_free(struct isl_ctx *ctx)
 	isl_int_clear(ctx->two);
 	isl_int_clear(ctx->negone);
 	isl_int_clear(ctx->normalize_gcd);
+	for (i = 0; i < ISL_CTX_N_SCRATCH; ++i)
+		isl_int_clear(ctx->scratch[i]);
 	isl_args_free(ctx->user_args, ctx->user_opt);
 	if (ctx->opt_allocated)
 		isl_options_free(ctx->opt);
@@ -340,3 +590,114 @@ void isl_ctx_reset_operations(isl_ctx *ctx)
 		return;
 	ctx->operations = 0;
 }
+
+/* Set the maximal number of integers that can be kept
+ * in the block cache of "ctx" to "size", freeing cached blocks
+ * if they no longer fit.
+ */
+void isl_ctx_set_max_block_cache_size(isl_ctx *ctx, unsigned long size)
+{
+	if (!ctx)
+		return;
+	ctx->block_cache.max_cached = size;
+	isl_blk_trim_cache(ctx);
+}
+
+/* Return the maximal number of integers that can be kept
+ * in the block cache of "ctx".
+ */
+unsigned long isl_ctx_get_max_block_cache_size(isl_ctx *ctx)
+{
+	return ctx ? ctx->block_cache.max_cached : 0;
+}
+
+/* Return the number of block allocations of "ctx" that were
+ * served from the block cache.
+ */
+unsigned long isl_ctx_get_block_cache_hits(isl_ctx *ctx)
+{
+	return ctx ? ctx->block_cache.n_hit : 0;
+}
+
+/* Return the number of block allocations of "ctx" that could not
+ * be served from the block cache.
+ */
+unsigned long isl_ctx_get_block_cache_misses(isl_ctx *ctx)
+{
+	return ctx ? ctx->block_cache.n_miss : 0;
+}
+
+/* Reset the number of block cache hits and misses of "ctx".
+ */
+void isl_ctx_reset_block_cache_stats(isl_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	ctx->block_cache.n_hit = 0;
+	ctx->block_cache.n_miss = 0;
+}
+
+/* Free all blocks in the block cache of "ctx", returning the memory
+ * to the system.
+ */
+void isl_ctx_clear_block_cache(isl_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	isl_blk_clear_cache(ctx);
+}
+
+/* Set the maximal number of test results that can be kept
+ * in the basic map cache of "ctx" to "size", evicting the least
+ * recently used entries if they no longer fit.
+ */
+void isl_ctx_set_max_basic_map_cache_size(isl_ctx *ctx, unsigned long size)
+{
+	if (!ctx)
+		return;
+	ctx->basic_map_cache.max_size = size;
+	isl_basic_map_cache_trim(ctx);
+}
+
+/* Return the maximal number of test results that can be kept
+ * in the basic map cache of "ctx".
+ */
+unsigned long isl_ctx_get_max_basic_map_cache_size(isl_ctx *ctx)
+{
+	return ctx ? ctx->basic_map_cache.max_size : 0;
+}
+
+/* Return the number of emptiness and subset tests on basic maps
+ * of "ctx" that were answered from the basic map cache.
+ */
+unsigned long isl_ctx_get_basic_map_cache_hits(isl_ctx *ctx)
+{
+	return ctx ? ctx->basic_map_cache.n_hit : 0;
+}
+
+/* Return the number of emptiness and subset tests on basic maps
+ * of "ctx" that could not be answered from the basic map cache.
+ */
+unsigned long isl_ctx_get_basic_map_cache_misses(isl_ctx *ctx)
+{
+	return ctx ? ctx->basic_map_cache.n_miss : 0;
+}
+
+/* Reset the number of basic map cache hits and misses of "ctx".
+ */
+void isl_ctx_reset_basic_map_cache_stats(isl_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	ctx->basic_map_cache.n_hit = 0;
+	ctx->basic_map_cache.n_miss = 0;
+}
+
+/* Remove all entries from the basic map cache of "ctx".
+ */
+void isl_ctx_clear_basic_map_cache(isl_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	isl_basic_map_cache_clear(ctx);
+}
@@ -1,5 +1,20 @@
 #include <isl/ctx.h>
+#include <isl/mat.h>
 #include <isl_blk.h>
+#include <isl_basic_map_cache.h>
+
+/* The number of scratch integers that are kept in an isl_ctx.
+ * See isl_ctx_scratch_acquire.
+ */
+#define ISL_CTX_N_SCRATCH	16
+
+/* The maximal number of freed isl_val objects that are kept in an isl_ctx
+ * for reuse.
+ * See isl_val_alloc.
+ */
+#define ISL_CTX_N_VAL_CACHE	64
+
+struct isl_shared_contexts;
 
 struct isl_ctx {
 	int			ref;
@@ -18,9 +33,18 @@ struct isl_ctx {
 
 	isl_int			normalize_gcd;
 
-	int			n_cached;
-	int			n_miss;
-	struct isl_blk		cache[ISL_BLK_CACHE_SIZE];
+	int			n_scratch;
+	isl_int			scratch[ISL_CTX_N_SCRATCH];
+
+	int			n_val_cache;
+	struct isl_val		*val_cache[ISL_CTX_N_VAL_CACHE];
+
+	struct isl_blk_cache	block_cache;
+	struct isl_basic_map_cache	basic_map_cache;
+
+	isl_mat			*gbr_basis;
+	isl_mat			*gbr_ineq;
+	struct isl_shared_contexts	*shared_contexts;
 	struct isl_hash_table	id_table;
 
 	enum isl_error		error;
@@ -29,6 +53,13 @@ struct isl_ctx {
 
 	unsigned long		operations;
 	unsigned long		max_operations;
+	unsigned long		inherited_operations;
 };
 
 int isl_ctx_next_operation(isl_ctx *ctx);
+
+isl_ctx *isl_ctx_alloc_worker(isl_ctx *ctx);
+void isl_ctx_merge_worker(isl_ctx *ctx, isl_ctx *worker);
+
+isl_int *isl_ctx_scratch_acquire(isl_ctx *ctx, int n);
+void isl_ctx_scratch_release(isl_ctx *ctx, isl_int *v, int n);
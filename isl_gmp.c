@@ -9,16 +9,45 @@
 
 #include <isl_int.h>
 
+/* Update "hash" with "v".
+ * If "v" fits in a 64-bit signed integer, then it is hashed
+ * as a single word holding its two's complement representation.
+ * Otherwise, its signed number of limbs is hashed in first,
+ * followed by the absolute value, 64 bits at a time.
+ * Values that fit in a word are therefore hashed in the same way
+ * as in the other isl_int implementations.
+ */
 uint32_t isl_gmp_hash(mpz_t v, uint32_t hash)
 {
+	int i;
 	int sa = v[0]._mp_size;
 	int abs_sa = sa < 0 ? -sa : sa;
-	unsigned char *data = (unsigned char *)v[0]._mp_d;
-	unsigned char *end = data + abs_sa * sizeof(v[0]._mp_d[0]);
+	mp_limb_t *d = v[0]._mp_d;
+	unsigned shift = 0;
+	uint64_t w = 0;
+
+	if (abs_sa * sizeof(mp_limb_t) <= sizeof(uint64_t)) {
+		for (i = 0; i < abs_sa; ++i, shift += 8 * sizeof(mp_limb_t))
+			w |= (uint64_t) d[i] << shift;
+		if (w <= (uint64_t) INT64_MAX + (sa < 0)) {
+			isl_hash_word(hash, sa < 0 ? -w : w);
+			return hash;
+		}
+		shift = 0;
+		w = 0;
+	}
 
-	if (sa < 0)
-		isl_hash_byte(hash, 0xFF);
-	for (; data < end; ++data)
-		isl_hash_byte(hash, *data);
+	isl_hash_word(hash, (int64_t) sa);
+	for (i = 0; i < abs_sa; ++i) {
+		w |= (uint64_t) d[i] << shift;
+		shift += 8 * sizeof(mp_limb_t);
+		if (shift < 64)
+			continue;
+		isl_hash_word(hash, w);
+		shift = 0;
+		w = 0;
+	}
+	if (shift != 0)
+		isl_hash_word(hash, w);
 	return hash;
 }
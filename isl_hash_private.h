@@ -3,6 +3,24 @@
 
 #include <isl/hash.h>
 
+/* Update the 32-bit hash "h" with the 64-bit word "w" in one step.
+ * The word is first scrambled by multiplying it with an odd constant,
+ * then combined with (two copies of) "h" and finally mixed
+ * such that every bit of the result depends on every bit of the input.
+ * This is only used internally, on frequently hashed objects.
+ * The public isl_hash_hash, isl_hash_string and isl_hash_mem
+ * keep on hashing a byte at a time.
+ */
+#define isl_hash_word(h,w)						\
+	do {								\
+		uint64_t isl_hash_w = (uint64_t) (w);			\
+		isl_hash_w *= (uint64_t) 0x9e3779b97f4a7c15ull;		\
+		isl_hash_w ^= ((uint64_t) (h) << 32) | (uint32_t) (h);	\
+		isl_hash_w ^= isl_hash_w >> 32;				\
+		isl_hash_w *= (uint64_t) 0xbf58476d1ce4e5b9ull;		\
+		h = (uint32_t) (isl_hash_w >> 32);			\
+	} while(0)
+
 extern struct isl_hash_table_entry *isl_hash_table_entry_none;
 
 #endif
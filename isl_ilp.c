@@ -14,6 +14,8 @@
 #include "isl_sample.h"
 #include <isl_seq.h>
 #include "isl_equalities.h"
+#include "isl_presolve.h"
+#include "isl_tab.h"
 #include <isl_aff_private.h>
 #include <isl_local_space_private.h>
 #include <isl_mat_private.h>
@@ -21,6 +23,7 @@
 #include <isl_vec_private.h>
 #include <isl_lp_private.h>
 #include <isl_ilp_private.h>
+#include <isl_options_private.h>
 #include <isl/deprecated/ilp_int.h>
 
 /* Given a basic set "bset", construct a basic set U such that for
@@ -191,12 +194,17 @@ static struct isl_vec *solve_ilp_search(struct isl_basic_set *bset,
 	return sol;
 }
 
-/* Find an integer point in "bset" that minimizes f (if any).
+/* Find an integer point in "bset" that minimizes f (if any),
+ * given the result "res" of minimizing f over the rationals,
+ * with "sol" the rational optimum (if "res" is isl_lp_ok)
+ * and *opt the minimal value, rounded up to the nearest integer.
  * If sol_p is not NULL then the integer point is returned in *sol_p.
  * The optimal value of f is returned in *opt.
  *
- * The algorithm maintains a currently best solution and an interval [l, u]
- * of values of f for which integer solutions could potentially still be found.
+ * If the rational optimum is integral, then it is also the integer optimum.
+ * Otherwise, the algorithm maintains a currently best solution and
+ * an interval [l, u] of values of f for which integer solutions could
+ * potentially still be found.
  * The initial value of the best solution so far is any solution.
  * The initial value of l is minimal value of f over the rationals
  * (rounded up to the nearest integer).
@@ -204,16 +212,12 @@ static struct isl_vec *solve_ilp_search(struct isl_basic_set *bset,
  *
  * We then call solve_ilp_search to perform a binary search on the interval.
  */
-static enum isl_lp_result solve_ilp(struct isl_basic_set *bset,
-				      isl_int *f, isl_int *opt,
-				      struct isl_vec **sol_p)
+static enum isl_lp_result solve_ilp_from_lp(struct isl_basic_set *bset,
+	isl_int *f, enum isl_lp_result res, struct isl_vec *sol,
+	isl_int *opt, struct isl_vec **sol_p)
 {
-	enum isl_lp_result res;
 	isl_int l, u;
-	struct isl_vec *sol;
 
-	res = isl_basic_set_solve_lp(bset, 0, f, bset->ctx->one,
-					opt, NULL, &sol);
 	if (res == isl_lp_ok && isl_int_is_one(sol->el[0])) {
 		if (sol_p)
 			*sol_p = sol;
@@ -260,9 +264,40 @@ static enum isl_lp_result solve_ilp(struct isl_basic_set *bset,
 	return res;
 }
 
-static enum isl_lp_result solve_ilp_with_eq(struct isl_basic_set *bset, int max,
+/* Find an integer point in "bset" that minimizes f (if any).
+ * If sol_p is not NULL then the integer point is returned in *sol_p.
+ * The optimal value of f is returned in *opt.
+ *
+ * First minimize f over the rationals and then continue
+ * in solve_ilp_from_lp.
+ */
+static enum isl_lp_result solve_ilp(struct isl_basic_set *bset,
 				      isl_int *f, isl_int *opt,
 				      struct isl_vec **sol_p)
+{
+	enum isl_lp_result res;
+	struct isl_vec *sol;
+
+	res = isl_basic_set_solve_lp(bset, 0, f, bset->ctx->one,
+					opt, NULL, &sol);
+	return solve_ilp_from_lp(bset, f, res, sol, opt, sol_p);
+}
+
+static enum isl_lp_result basic_set_solve_ilp(struct isl_basic_set *bset,
+	int max, isl_int *f, isl_int *opt, struct isl_vec **sol_p);
+
+/* Transform "bset" using "transform", which also returns
+ * the transformation matrix T that maps the variables of the result
+ * back to those of the input, and solve the resulting integer linear
+ * program in terms of the remaining variables.
+ * The objective function "f" is transformed in the same way
+ * and the optimal point (if requested) is mapped back
+ * to the original variables.
+ */
+static enum isl_lp_result solve_ilp_transformed(struct isl_basic_set *bset,
+	int max, isl_int *f, isl_int *opt, struct isl_vec **sol_p,
+	__isl_give isl_basic_set *(*transform)(__isl_take isl_basic_set *bset,
+		__isl_give isl_mat **T))
 {
 	unsigned dim;
 	enum isl_lp_result res;
@@ -275,11 +310,11 @@ static enum isl_lp_result solve_ilp_with_eq(struct isl_basic_set *bset, int max,
 	if (!v)
 		goto error;
 	isl_seq_cpy(v->el, f, 1 + dim);
-	bset = isl_basic_set_remove_equalities(bset, &T, NULL);
+	bset = transform(bset, &T);
 	v = isl_vec_mat_product(v, isl_mat_copy(T));
 	if (!v)
 		goto error;
-	res = isl_basic_set_solve_ilp(bset, max, v->el, opt, sol_p);
+	res = basic_set_solve_ilp(bset, max, v->el, opt, sol_p);
 	isl_vec_free(v);
 	if (res == isl_lp_ok && sol_p) {
 		*sol_p = isl_mat_vec_product(T, *sol_p);
@@ -295,17 +330,61 @@ error:
 	return isl_lp_error;
 }
 
+/* Remove the equalities of "bset", returning the transformation
+ * in *T.
+ */
+static __isl_give isl_basic_set *remove_equalities(
+	__isl_take isl_basic_set *bset, __isl_give isl_mat **T)
+{
+	return isl_basic_set_remove_equalities(bset, T, NULL);
+}
+
+/* Presolve "bset", returning the transformation in *T.
+ */
+static __isl_give isl_basic_set *presolve(__isl_take isl_basic_set *bset,
+	__isl_give isl_mat **T)
+{
+	return isl_basic_set_presolve(bset, 0, T, NULL);
+}
+
 /* Find an integer point in "bset" that minimizes (or maximizes if max is set)
  * f (if any).
  * If sol_p is not NULL then the integer point is returned in *sol_p.
  * The optimal value of f is returned in *opt.
  *
- * If there is any equality among the points in "bset", then we first
- * project it out.  Otherwise, we continue with solve_ilp above.
+ * If the tab-presolve option is set, then we first presolve "bset"
+ * in solve_ilp_transformed.
  */
 enum isl_lp_result isl_basic_set_solve_ilp(struct isl_basic_set *bset, int max,
 				      isl_int *f, isl_int *opt,
 				      struct isl_vec **sol_p)
+{
+	if (!bset)
+		return isl_lp_error;
+	if (sol_p)
+		*sol_p = NULL;
+
+	isl_assert(bset->ctx, isl_basic_set_n_param(bset) == 0,
+		return isl_lp_error);
+
+	if (isl_basic_set_plain_is_empty(bset))
+		return isl_lp_empty;
+
+	if (bset->ctx->opt->tab_presolve)
+		return solve_ilp_transformed(bset, max, f, opt, sol_p,
+						&presolve);
+
+	return basic_set_solve_ilp(bset, max, f, opt, sol_p);
+}
+
+/* Find an integer point in "bset" that minimizes (or maximizes if max is set)
+ * f (if any), as in isl_basic_set_solve_ilp, but without presolving.
+ *
+ * If there is any equality among the points in "bset", then we first
+ * project it out.  Otherwise, we continue with solve_ilp above.
+ */
+static enum isl_lp_result basic_set_solve_ilp(struct isl_basic_set *bset,
+	int max, isl_int *f, isl_int *opt, struct isl_vec **sol_p)
 {
 	unsigned dim;
 	enum isl_lp_result res;
@@ -315,13 +394,12 @@ enum isl_lp_result isl_basic_set_solve_ilp(struct isl_basic_set *bset, int max,
 	if (sol_p)
 		*sol_p = NULL;
 
-	isl_assert(bset->ctx, isl_basic_set_n_param(bset) == 0, goto error);
-
 	if (isl_basic_set_plain_is_empty(bset))
 		return isl_lp_empty;
 
 	if (bset->n_eq)
-		return solve_ilp_with_eq(bset, max, f, opt, sol_p);
+		return solve_ilp_transformed(bset, max, f, opt, sol_p,
+						&remove_equalities);
 
 	dim = isl_basic_set_total_dim(bset);
 
@@ -336,9 +414,91 @@ enum isl_lp_result isl_basic_set_solve_ilp(struct isl_basic_set *bset, int max,
 	}
 
 	return res;
+}
+
+/* Compute the minima (maxima if "max" is set) of the objective functions
+ * in the rows of "f" over the integer points in "bset" and
+ * store them in the corresponding elements of "opt", with the nature
+ * of each result stored in the corresponding element of "res".
+ * "bset" is assumed not to have any parameters or existentially
+ * quantified variables.
+ *
+ * The equalities of "bset" (and, if the tab-presolve option is set,
+ * the variables that can be fixed by presolving) are removed only once,
+ * with the objective functions transformed accordingly, and
+ * a single tableau is constructed for the resulting basic set.
+ * Since isl_tab_min only rolls back the addition of the objective row,
+ * the optimal basis for one objective function serves as the starting
+ * basis for the next one.
+ * If the rational optimum is not integral, then solve_ilp_from_lp
+ * continues looking for the integer optimum.
+ */
+static isl_stat solve_ilp_multi(__isl_take isl_basic_set *bset, int max,
+	__isl_take isl_mat *f, enum isl_lp_result *res, isl_int *opt)
+{
+	int i, n;
+	isl_ctx *ctx;
+	isl_mat *T;
+	struct isl_tab *tab;
+
+	if (!bset || !f)
+		goto error;
+
+	ctx = isl_basic_set_get_ctx(bset);
+	if (max)
+		for (i = 0; i < f->n_row; ++i)
+			isl_seq_neg(f->row[i], f->row[i], f->n_col);
+
+	if (ctx->opt->tab_presolve && !isl_basic_set_plain_is_empty(bset)) {
+		bset = isl_basic_set_presolve(bset, 0, &T, NULL);
+		f = isl_mat_product(f, T);
+	}
+	if (bset && bset->n_eq > 0 && !isl_basic_set_plain_is_empty(bset)) {
+		bset = isl_basic_set_remove_equalities(bset, &T, NULL);
+		f = isl_mat_product(f, T);
+	}
+	if (!bset || !f)
+		goto error;
+
+	if (isl_basic_set_plain_is_empty(bset)) {
+		for (i = 0; i < f->n_row; ++i)
+			res[i] = isl_lp_empty;
+		isl_mat_free(f);
+		isl_basic_set_free(bset);
+		return isl_stat_ok;
+	}
+
+	tab = isl_tab_from_basic_set(bset, 0);
+	if (!tab)
+		goto error;
+
+	n = f->n_row;
+	for (i = 0; i < n; ++i) {
+		struct isl_vec *sol = NULL;
+
+		res[i] = isl_tab_min(tab, f->row[i], ctx->one, &opt[i],
+					NULL, 0);
+		if (res[i] == isl_lp_ok) {
+			sol = isl_tab_get_sample_value(tab);
+			if (!sol)
+				res[i] = isl_lp_error;
+		}
+		res[i] = solve_ilp_from_lp(bset, f->row[i], res[i], sol,
+					    &opt[i], NULL);
+		if (res[i] == isl_lp_error)
+			break;
+		if (max)
+			isl_int_neg(opt[i], opt[i]);
+	}
+
+	isl_tab_free(tab);
+	isl_mat_free(f);
+	isl_basic_set_free(bset);
+	return i < n ? isl_stat_error : isl_stat_ok;
 error:
+	isl_mat_free(f);
 	isl_basic_set_free(bset);
-	return isl_lp_error;
+	return isl_stat_error;
 }
 
 static enum isl_lp_result basic_set_opt(__isl_keep isl_basic_set *bset, int max,
@@ -670,6 +830,237 @@ error:
 	return NULL;
 }
 
+/* Return a list of minima (maxima if "max" is set) over the points
+ * in "bset" for each of the integer affine expressions in "obj".
+ *
+ * An element in the list is infinity or negative infinity if the optimal
+ * value of the corresponding expression is unbounded and
+ * NaN if "bset" is empty.
+ *
+ * The expressions that do not involve any integer divisions
+ * are optimized together in solve_ilp_multi, over the underlying set
+ * of "bset", such that they can share the same tableau.
+ * The other expressions are handled separately by isl_basic_set_opt_val.
+ */
+static __isl_give isl_multi_val *isl_basic_set_opt_multi_aff(
+	__isl_keep isl_basic_set *bset, int max, __isl_keep isl_multi_aff *obj)
+{
+	int i, n, n_batch;
+	unsigned total;
+	int *pos = NULL;
+	isl_int *opt = NULL;
+	enum isl_lp_result *res = NULL;
+	isl_ctx *ctx;
+	isl_space *space;
+	isl_mat *f = NULL;
+	isl_multi_val *mv;
+
+	if (!bset || !obj)
+		return NULL;
+
+	ctx = isl_multi_aff_get_ctx(obj);
+	space = isl_multi_aff_get_domain_space(obj);
+	if (!isl_space_is_equal(bset->dim, space)) {
+		isl_space_free(space);
+		isl_die(ctx, isl_error_invalid,
+			"spaces don't match", return NULL);
+	}
+	isl_space_free(space);
+
+	n = isl_multi_aff_dim(obj, isl_dim_out);
+	space = isl_space_range(isl_multi_aff_get_space(obj));
+	mv = isl_multi_val_zero(space);
+	if (n == 0 || !mv)
+		return mv;
+
+	total = isl_basic_set_total_dim(bset);
+	f = isl_mat_alloc(ctx, n, 1 + total);
+	pos = isl_alloc_array(ctx, int, n);
+	if (!f || !pos)
+		goto error;
+
+	n_batch = 0;
+	for (i = 0; i < n; ++i) {
+		isl_aff *aff = obj->p[i];
+		unsigned len = aff->v->size - 1;
+
+		if (!isl_int_is_one(aff->v->el[0]) ||
+		    isl_aff_dim(aff, isl_dim_div) != 0) {
+			isl_val *v = isl_basic_set_opt_val(bset, max, aff);
+			mv = isl_multi_val_set_val(mv, i, v);
+			continue;
+		}
+		isl_seq_cpy(f->row[n_batch], aff->v->el + 1, len);
+		isl_seq_clr(f->row[n_batch] + len, 1 + total - len);
+		pos[n_batch++] = i;
+	}
+	f = isl_mat_drop_rows(f, n_batch, n - n_batch);
+	if (!mv || !f)
+		goto error;
+	if (n_batch == 0) {
+		isl_mat_free(f);
+		free(pos);
+		return mv;
+	}
+
+	opt = isl_alloc_array(ctx, isl_int, n_batch);
+	res = isl_alloc_array(ctx, enum isl_lp_result, n_batch);
+	if (!opt || !res)
+		goto error;
+	for (i = 0; i < n_batch; ++i)
+		isl_int_init(opt[i]);
+
+	bset = isl_basic_set_underlying_set(isl_basic_set_copy(bset));
+	if (solve_ilp_multi(bset, max, f, res, opt) < 0)
+		mv = isl_multi_val_free(mv);
+
+	for (i = 0; i < n_batch; ++i) {
+		isl_val *v;
+
+		v = isl_val_alloc(ctx);
+		if (v)
+			isl_int_set(v->n, opt[i]);
+		if (mv && v)
+			v = convert_lp_result(res[i], v, max);
+		mv = isl_multi_val_set_val(mv, pos[i], v);
+		isl_int_clear(opt[i]);
+	}
+
+	free(res);
+	free(opt);
+	free(pos);
+	return mv;
+error:
+	free(res);
+	free(opt);
+	free(pos);
+	isl_mat_free(f);
+	isl_multi_val_free(mv);
+	return NULL;
+}
+
+/* Return a list of minima over the points in "bset"
+ * for each of the integer affine expressions in "obj".
+ *
+ * An element in the list is infinity or negative infinity if the optimal
+ * value of the corresponding expression is unbounded and
+ * NaN if "bset" is empty.
+ */
+__isl_give isl_multi_val *isl_basic_set_min_multi_aff(
+	__isl_keep isl_basic_set *bset, __isl_keep isl_multi_aff *obj)
+{
+	return isl_basic_set_opt_multi_aff(bset, 0, obj);
+}
+
+/* Return a list of maxima over the points in "bset"
+ * for each of the integer affine expressions in "obj".
+ *
+ * An element in the list is infinity or negative infinity if the optimal
+ * value of the corresponding expression is unbounded and
+ * NaN if "bset" is empty.
+ */
+__isl_give isl_multi_val *isl_basic_set_max_multi_aff(
+	__isl_keep isl_basic_set *bset, __isl_keep isl_multi_aff *obj)
+{
+	return isl_basic_set_opt_multi_aff(bset, 1, obj);
+}
+
+/* Return a list of minima (maxima if "max" is set) over the points
+ * in "set" for each of the integer affine expressions in "obj".
+ *
+ * The parameters are assumed to have been aligned.
+ *
+ * Initialize all elements of the result to NaN and then update them
+ * with the optima over each of the basic sets in "set".
+ */
+static __isl_give isl_multi_val *isl_set_opt_multi_aff_aligned(
+	__isl_keep isl_set *set, int max, __isl_keep isl_multi_aff *obj)
+{
+	int i, j, n;
+	isl_ctx *ctx;
+	isl_multi_val *mv;
+
+	if (!set || !obj)
+		return NULL;
+
+	ctx = isl_set_get_ctx(set);
+	n = isl_multi_aff_dim(obj, isl_dim_out);
+	mv = isl_multi_val_zero(isl_space_range(isl_multi_aff_get_space(obj)));
+	for (j = 0; j < n; ++j)
+		mv = isl_multi_val_set_val(mv, j, isl_val_nan(ctx));
+
+	for (i = 0; mv && i < set->n; ++i) {
+		isl_multi_val *mv_i;
+
+		mv_i = isl_basic_set_opt_multi_aff(set->p[i], max, obj);
+		if (!mv_i)
+			return isl_multi_val_free(mv);
+		for (j = 0; j < n; ++j) {
+			isl_val *v;
+
+			v = isl_multi_val_get_val(mv, j);
+			v = val_opt(v, isl_multi_val_get_val(mv_i, j), max);
+			mv = isl_multi_val_set_val(mv, j, v);
+		}
+		isl_multi_val_free(mv_i);
+	}
+
+	return mv;
+}
+
+/* Return a list of minima (maxima if "max" is set) over the points
+ * in "set" for each of the integer affine expressions in "obj".
+ */
+static __isl_give isl_multi_val *isl_set_opt_multi_aff(
+	__isl_keep isl_set *set, int max, __isl_keep isl_multi_aff *obj)
+{
+	isl_multi_val *mv;
+
+	if (!set || !obj)
+		return NULL;
+
+	if (isl_space_match(set->dim, isl_dim_param, obj->space, isl_dim_param))
+		return isl_set_opt_multi_aff_aligned(set, max, obj);
+
+	set = isl_set_copy(set);
+	obj = isl_multi_aff_copy(obj);
+	set = isl_set_align_params(set, isl_multi_aff_get_domain_space(obj));
+	obj = isl_multi_aff_align_params(obj, isl_set_get_space(set));
+
+	mv = isl_set_opt_multi_aff_aligned(set, max, obj);
+
+	isl_set_free(set);
+	isl_multi_aff_free(obj);
+
+	return mv;
+}
+
+/* Return a list of minima over the points in "set"
+ * for each of the integer affine expressions in "obj".
+ *
+ * An element in the list is infinity or negative infinity if the optimal
+ * value of the corresponding expression is unbounded and
+ * NaN if "set" is empty.
+ */
+__isl_give isl_multi_val *isl_set_min_multi_aff(__isl_keep isl_set *set,
+	__isl_keep isl_multi_aff *obj)
+{
+	return isl_set_opt_multi_aff(set, 0, obj);
+}
+
+/* Return a list of maxima over the points in "set"
+ * for each of the integer affine expressions in "obj".
+ *
+ * An element in the list is infinity or negative infinity if the optimal
+ * value of the corresponding expression is unbounded and
+ * NaN if "set" is empty.
+ */
+__isl_give isl_multi_val *isl_set_max_multi_aff(__isl_keep isl_set *set,
+	__isl_keep isl_multi_aff *obj)
+{
+	return isl_set_opt_multi_aff(set, 1, obj);
+}
+
 /* Internal data structure for isl_set_opt_pw_aff.
  *
  * "max" is set if the maximum should be computed.
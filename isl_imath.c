@@ -1,14 +1,44 @@
 #include <isl_int.h>
 
+/* Update "hash" with "v".
+ * If "v" fits in a 64-bit signed integer, then it is hashed
+ * as a single word holding its two's complement representation,
+ * such that small and big representations of the same value
+ * in isl_int_sioimath get the same hash value.
+ * Otherwise, its signed number of digits is hashed in first,
+ * followed by the absolute value, 64 bits at a time.
+ */
 uint32_t isl_imath_hash(mp_int v, uint32_t hash)
 {
-	unsigned const char *data = (unsigned char *)v->digits;
-	unsigned const char *end = data + v->used * sizeof(v->digits[0]);
+	int i;
+	int neg = v->sign == MP_NEG;
+	mp_digit *d = v->digits;
+	unsigned shift = 0;
+	uint64_t w = 0;
+
+	if (v->used * sizeof(mp_digit) <= sizeof(uint64_t)) {
+		for (i = 0; i < v->used; ++i, shift += 8 * sizeof(mp_digit))
+			w |= (uint64_t) d[i] << shift;
+		if (w <= (uint64_t) INT64_MAX + neg) {
+			isl_hash_word(hash, neg ? -w : w);
+			return hash;
+		}
+		shift = 0;
+		w = 0;
+	}
 
-	if (v->sign == 1)
-		isl_hash_byte(hash, 0xFF);
-	for (; data < end; ++data)
-		isl_hash_byte(hash, *data);
+	isl_hash_word(hash, neg ? -(int64_t) v->used : (int64_t) v->used);
+	for (i = 0; i < v->used; ++i) {
+		w |= (uint64_t) d[i] << shift;
+		shift += 8 * sizeof(mp_digit);
+		if (shift < 64)
+			continue;
+		isl_hash_word(hash, w);
+		shift = 0;
+		w = 0;
+	}
+	if (shift != 0)
+		isl_hash_word(hash, w);
 	return hash;
 }
 
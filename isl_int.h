@@ -11,7 +11,7 @@
 #define ISL_INT_H
 #define ISL_DEPRECATED_INT_H
 
-#include <isl/hash.h>
+#include <isl_hash_private.h>
 #include <isl/printer.h>
 #include <string.h>
 #include <isl_config.h>
@@ -36,6 +36,23 @@
 #define isl_int_is_nonpos(i)	(isl_int_sgn(i) <= 0)
 #define isl_int_is_nonneg(i)	(isl_int_sgn(i) >= 0)
 
+/* Row-level fast paths for the isl_seq functions.
+ * Each of these returns 1 if the operation has been performed
+ * on machine words and 0 if the caller should fall back
+ * to the element-wise isl_int operations, in which case nothing
+ * has been modified.
+ * Only the small integer optimization has a representation
+ * that can be checked cheaply.
+ */
+#ifndef USE_SMALL_INT_OPT
+#define isl_int_seq_addmul_small(dst, f, src, len)		0
+#define isl_int_seq_submul_small(dst, f, src, len)		0
+#define isl_int_seq_scale_small(dst, src, m, len)		0
+#define isl_int_seq_scale_down_small(dst, src, m, len)		0
+#define isl_int_seq_combine_small(dst, m1, src1, m2, src2, len)	0
+#define isl_int_seq_gcd_small(p, len, gcd)			0
+#endif /* USE_SMALL_INT_OPT */
+
 #ifndef USE_SMALL_INT_OPT
 #define isl_int_print(out,i,width)					\
 	do {								\
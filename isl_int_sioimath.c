@@ -3,15 +3,17 @@
 
 #include <isl_int.h>
 
-extern int isl_sioimath_decode(isl_sioimath val, int32_t *small, mp_int *big);
+extern int isl_sioimath_decode(isl_sioimath val, isl_sioimath_small_t *small,
+	mp_int *big);
 extern int isl_sioimath_decode_big(isl_sioimath val, mp_int *big);
-extern int isl_sioimath_decode_small(isl_sioimath val, int32_t *small);
+extern int isl_sioimath_decode_small(isl_sioimath val,
+	isl_sioimath_small_t *small);
 
-extern isl_sioimath isl_sioimath_encode_small(int32_t val);
+extern isl_sioimath isl_sioimath_encode_small(isl_sioimath_small_t val);
 extern isl_sioimath isl_sioimath_encode_big(mp_int val);
 extern int isl_sioimath_is_small(isl_sioimath val);
 extern int isl_sioimath_is_big(isl_sioimath val);
-extern int32_t isl_sioimath_get_small(isl_sioimath val);
+extern isl_sioimath_small_t isl_sioimath_get_small(isl_sioimath val);
 extern mp_int isl_sioimath_get_big(isl_sioimath val);
 
 extern void isl_siomath_uint32_to_digits(uint32_t num, mp_digit *digits,
@@ -20,6 +22,10 @@ extern void isl_siomath_ulong_to_digits(unsigned long num, mp_digit *digits,
 	mp_size *used);
 extern void isl_siomath_uint64_to_digits(uint64_t num, mp_digit *digits,
 	mp_size *used);
+extern void isl_siomath_usmall_to_digits(isl_sioimath_usmall_t num,
+	mp_digit *digits, mp_size *used);
+extern void isl_siomath_uwide_to_digits(isl_sioimath_uwide_t num,
+	mp_digit *digits, mp_size *used);
 
 extern mp_int isl_sioimath_bigarg_src(isl_sioimath arg,
 	isl_sioimath_scratchspace_t *scratch);
@@ -27,12 +33,17 @@ extern mp_int isl_sioimath_siarg_src(signed long arg,
 	isl_sioimath_scratchspace_t *scratch);
 extern mp_int isl_sioimath_si64arg_src(int64_t arg,
 	isl_sioimath_scratchspace_t *scratch);
+extern mp_int isl_sioimath_widearg_src(isl_sioimath_wide_t arg,
+	isl_sioimath_scratchspace_t *scratch);
 extern mp_int isl_sioimath_uiarg_src(unsigned long arg,
 	isl_sioimath_scratchspace_t *scratch);
 extern mp_int isl_sioimath_reinit_big(isl_sioimath_ptr ptr);
-extern void isl_sioimath_set_small(isl_sioimath_ptr ptr, int32_t val);
+extern void isl_sioimath_set_small(isl_sioimath_ptr ptr,
+	isl_sioimath_small_t val);
 extern void isl_sioimath_set_int32(isl_sioimath_ptr ptr, int32_t val);
 extern void isl_sioimath_set_int64(isl_sioimath_ptr ptr, int64_t val);
+extern void isl_sioimath_set_wide(isl_sioimath_ptr ptr,
+	isl_sioimath_wide_t val);
 extern void isl_sioimath_promote(isl_sioimath_ptr dst);
 extern void isl_sioimath_try_demote(isl_sioimath_ptr dst);
 
@@ -81,9 +92,10 @@ extern void isl_sioimath_submul_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 /* Implements the Euclidean algorithm to compute the greatest common divisor of
  * two values in small representation.
  */
-static uint32_t isl_sioimath_smallgcd(int32_t lhs, int32_t rhs)
+static isl_sioimath_usmall_t isl_sioimath_smallgcd(isl_sioimath_small_t lhs,
+	isl_sioimath_small_t rhs)
 {
-	uint32_t dividend, divisor, remainder;
+	isl_sioimath_usmall_t dividend, divisor, remainder;
 
 	dividend = labs(lhs);
 	divisor = labs(rhs);
@@ -103,8 +115,8 @@ static uint32_t isl_sioimath_smallgcd(int32_t lhs, int32_t rhs)
 void isl_sioimath_gcd(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
-	int32_t lhssmall, rhssmall;
-	uint32_t smallgcd;
+	isl_sioimath_small_t lhssmall, rhssmall;
+	isl_sioimath_usmall_t smallgcd;
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
@@ -125,9 +137,9 @@ void isl_sioimath_gcd(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 void isl_sioimath_lcm(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
-	int32_t lhssmall, rhssmall;
-	uint32_t smallgcd;
-	uint64_t multiple;
+	isl_sioimath_small_t lhssmall, rhssmall;
+	isl_sioimath_usmall_t smallgcd;
+	isl_sioimath_uwide_t multiple;
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
@@ -137,8 +149,9 @@ void isl_sioimath_lcm(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 			return;
 		}
 		smallgcd = isl_sioimath_smallgcd(lhssmall, rhssmall);
-		multiple = (uint64_t) abs(lhssmall) * (uint64_t) abs(rhssmall);
-		isl_sioimath_set_int64(dst, multiple / smallgcd);
+		multiple = (isl_sioimath_uwide_t) labs(lhssmall) *
+		    (isl_sioimath_uwide_t) labs(rhssmall);
+		isl_sioimath_set_wide(dst, multiple / smallgcd);
 		return;
 	}
 
@@ -148,6 +161,256 @@ void isl_sioimath_lcm(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_try_demote(dst);
 }
 
+/* Return whether all "len" elements of "p" are in small representation.
+ *
+ * The discriminator bits are combined without any branches
+ * such that the compiler can vectorize the loop.
+ */
+static int isl_sioimath_seq_is_small(isl_sioimath *p, unsigned len)
+{
+	int i;
+	isl_sioimath tag = 0x00000001;
+
+	for (i = 0; i < len; ++i)
+		tag &= p[i];
+
+	return isl_sioimath_is_small(tag);
+}
+
+/* Return whether "dst" can be overwritten by values in small representation
+ * without freeing any big representations, i.e., whether "dst"
+ * is one of the inputs "src1" or "src2" (which have already been checked)
+ * or whether all its elements are in small representation.
+ */
+static int isl_sioimath_seq_dst_is_small(isl_sioimath *dst,
+	isl_sioimath *src1, isl_sioimath *src2, unsigned len)
+{
+	if (dst == src1 || dst == src2)
+		return 1;
+	return isl_sioimath_seq_is_small(dst, len);
+}
+
+/* Return whether "val" fits in small representation.
+ */
+static int isl_sioimath_wide_fits_small(isl_sioimath_wide_t val)
+{
+	return ISL_SIOIMATH_SMALL_MIN <= val && val <= ISL_SIOIMATH_SMALL_MAX;
+}
+
+/* Set dst[i] = f1 * src1[i] + f2 * src2[i] for all elements,
+ * assuming that "f1", "f2", the elements of "src1" and "src2" and
+ * the elements of "dst" are all in small representation.
+ *
+ * Since isl_sioimath_wide_t can hold the sum of two products
+ * of small values, the intermediate results cannot overflow.
+ * The first loop only checks whether all results fit
+ * in small representation again.  If so, then the second loop
+ * stores them without any further checks.  Both loops are free
+ * of function calls and can therefore be vectorized by the compiler.
+ * Otherwise, the third loop stores the results one by one,
+ * promoting them to big representation if needed.
+ */
+static void isl_sioimath_seq_combine_wide(isl_sioimath *dst,
+	isl_sioimath_wide_t f1, isl_sioimath *src1,
+	isl_sioimath_wide_t f2, isl_sioimath *src2, unsigned len)
+{
+	int i;
+	int fits = 1;
+	isl_sioimath_wide_t v;
+
+	for (i = 0; i < len; ++i) {
+		v = f1 * isl_sioimath_get_small(src1[i]) +
+		    f2 * isl_sioimath_get_small(src2[i]);
+		fits &= isl_sioimath_wide_fits_small(v);
+	}
+
+	if (fits) {
+		for (i = 0; i < len; ++i) {
+			v = f1 * isl_sioimath_get_small(src1[i]) +
+			    f2 * isl_sioimath_get_small(src2[i]);
+			dst[i] = isl_sioimath_encode_small(v);
+		}
+		return;
+	}
+
+	for (i = 0; i < len; ++i) {
+		v = f1 * isl_sioimath_get_small(src1[i]) +
+		    f2 * isl_sioimath_get_small(src2[i]);
+		isl_sioimath_set_wide(&dst[i], v);
+	}
+}
+
+/* Set dst[i] = m1 * src1[i] + m2 * src2[i] on machine words
+ * if all inputs are in small representation.
+ * Return 1 if the computation was performed and 0 if the caller
+ * should fall back to the general case.
+ */
+int isl_sioimath_seq_combine_small(isl_sioimath *dst, isl_sioimath_src m1,
+	isl_sioimath *src1, isl_sioimath_src m2, isl_sioimath *src2,
+	unsigned len)
+{
+	if (!isl_sioimath_is_small(m1) || !isl_sioimath_is_small(m2))
+		return 0;
+	if (!isl_sioimath_seq_is_small(src1, len) ||
+	    !isl_sioimath_seq_is_small(src2, len) ||
+	    !isl_sioimath_seq_dst_is_small(dst, src1, src2, len))
+		return 0;
+
+	isl_sioimath_seq_combine_wide(dst, isl_sioimath_get_small(m1), src1,
+	    isl_sioimath_get_small(m2), src2, len);
+	return 1;
+}
+
+/* Set dst[i] = dst[i] + f * src[i] on machine words
+ * if all inputs are in small representation.
+ * Return 1 if the computation was performed and 0 if the caller
+ * should fall back to the general case.
+ */
+int isl_sioimath_seq_addmul_small(isl_sioimath *dst, isl_sioimath_src f,
+	isl_sioimath *src, unsigned len)
+{
+	if (!isl_sioimath_is_small(f))
+		return 0;
+	if (!isl_sioimath_seq_is_small(dst, len) ||
+	    !isl_sioimath_seq_is_small(src, len))
+		return 0;
+
+	isl_sioimath_seq_combine_wide(dst, 1, dst,
+	    isl_sioimath_get_small(f), src, len);
+	return 1;
+}
+
+/* Set dst[i] = dst[i] - f * src[i] on machine words
+ * if all inputs are in small representation.
+ * Return 1 if the computation was performed and 0 if the caller
+ * should fall back to the general case.
+ *
+ * Note that -f is in small representation since
+ * ISL_SIOIMATH_SMALL_MIN is equal to -ISL_SIOIMATH_SMALL_MAX.
+ */
+int isl_sioimath_seq_submul_small(isl_sioimath *dst, isl_sioimath_src f,
+	isl_sioimath *src, unsigned len)
+{
+	if (!isl_sioimath_is_small(f))
+		return 0;
+	if (!isl_sioimath_seq_is_small(dst, len) ||
+	    !isl_sioimath_seq_is_small(src, len))
+		return 0;
+
+	isl_sioimath_seq_combine_wide(dst, 1, dst,
+	    -(isl_sioimath_wide_t) isl_sioimath_get_small(f), src, len);
+	return 1;
+}
+
+/* Set dst[i] = m * src[i] on machine words
+ * if all inputs are in small representation.
+ * Return 1 if the computation was performed and 0 if the caller
+ * should fall back to the general case.
+ */
+int isl_sioimath_seq_scale_small(isl_sioimath *dst, isl_sioimath *src,
+	isl_sioimath_src m, unsigned len)
+{
+	if (!isl_sioimath_is_small(m))
+		return 0;
+	if (!isl_sioimath_seq_is_small(src, len) ||
+	    !isl_sioimath_seq_dst_is_small(dst, src, src, len))
+		return 0;
+
+	isl_sioimath_seq_combine_wide(dst, isl_sioimath_get_small(m), src,
+	    0, src, len);
+	return 1;
+}
+
+/* Return the inverse of the odd number "d" modulo 2^64.
+ *
+ * Since d * d = 1 modulo 8, "d" is its own inverse modulo 2^3.
+ * Each Newton iteration inv = inv * (2 - d * inv) doubles
+ * the number of correct bits, so five iterations are needed
+ * to obtain all 64 bits.
+ */
+static uint64_t isl_sioimath_inverse_odd(uint64_t d)
+{
+	int i;
+	uint64_t inv = d;
+
+	for (i = 0; i < 5; ++i)
+		inv *= 2 - d * inv;
+
+	return inv;
+}
+
+/* Set dst[i] = src[i] / m, where m is known to divide every src[i],
+ * on machine words if all inputs are in small representation.
+ * Return 1 if the computation was performed and 0 if the caller
+ * should fall back to the general case.
+ *
+ * The quotients are at most as large as the dividends in absolute value,
+ * so they are all in small representation.
+ *
+ * Write |m| as 2^shift * d with d odd.  Since the divisions are exact,
+ * src[i] / m can be computed by shifting out the factor 2^shift and
+ * multiplying the result by the inverse of d modulo 2^64
+ * (negated if m is negative).  The product modulo 2^64 is the quotient
+ * because the quotient fits in 64 bits.  The inverse is computed
+ * only once for the entire row, so that every element only requires
+ * a shift and a multiplication instead of a division.
+ */
+int isl_sioimath_seq_scale_down_small(isl_sioimath *dst, isl_sioimath *src,
+	isl_sioimath_src m, unsigned len)
+{
+	int i;
+	int shift;
+	isl_sioimath_small_t small;
+	uint64_t d, inv;
+
+	if (!isl_sioimath_is_small(m))
+		return 0;
+	if (!isl_sioimath_seq_is_small(src, len) ||
+	    !isl_sioimath_seq_dst_is_small(dst, src, src, len))
+		return 0;
+
+	small = isl_sioimath_get_small(m);
+	if (small == 0)
+		return 0;
+	d = small < 0 ? -(uint64_t) small : (uint64_t) small;
+	for (shift = 0; !(d & 1); ++shift)
+		d >>= 1;
+	inv = isl_sioimath_inverse_odd(d);
+	if (small < 0)
+		inv = -inv;
+
+	for (i = 0; i < len; ++i) {
+		int64_t v = isl_sioimath_get_small(src[i]) >> shift;
+		dst[i] = isl_sioimath_encode_small(
+				    (int64_t) ((uint64_t) v * inv));
+	}
+	return 1;
+}
+
+/* Compute the greatest common divisor of the elements of "p" and
+ * store it in "gcd" if all elements are in small representation.
+ * Return 1 if the computation was performed and 0 if the caller
+ * should fall back to the general case.
+ *
+ * The computation stops as soon as the greatest common divisor
+ * is known to be one.
+ */
+int isl_sioimath_seq_gcd_small(isl_sioimath *p, unsigned len,
+	isl_sioimath_ptr gcd)
+{
+	int i;
+	isl_sioimath_usmall_t g = 0;
+
+	if (!isl_sioimath_seq_is_small(p, len))
+		return 0;
+
+	for (i = 0; g != 1 && i < len; ++i)
+		g = isl_sioimath_smallgcd(g, isl_sioimath_get_small(p[i]));
+
+	isl_sioimath_set_small(gcd, g);
+	return 1;
+}
+
 extern void isl_sioimath_tdiv_q(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs);
 extern void isl_sioimath_tdiv_q_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
@@ -162,14 +425,15 @@ extern void isl_sioimath_fdiv_r(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs);
 
 /* Parse a number from a string.
- * If it has less than 10 characters then it will fit into the small
- * representation (i.e. strlen("2147483647")). Otherwise, let IMath parse it.
+ * If it has less than ISL_SIOIMATH_SMALL_DIGITS characters then it will fit
+ * into the small representation (i.e. strlen("2147483647") or
+ * strlen("4611686018427387903")). Otherwise, let IMath parse it.
  */
 void isl_sioimath_read(isl_sioimath_ptr dst, const char *str)
 {
-	int32_t small;
+	isl_sioimath_small_t small;
 
-	if (strlen(str) < 10) {
+	if (strlen(str) < ISL_SIOIMATH_SMALL_DIGITS) {
 		small = strtol(str, NULL, 10);
 		isl_sioimath_set_small(dst, small);
 		return;
@@ -196,12 +460,12 @@ extern void isl_sioimath_print(FILE *out, isl_sioimath_src i, int width);
 void isl_sioimath_print(FILE *out, isl_sioimath_src i, int width)
 {
 	size_t len;
-	int32_t small;
+	isl_sioimath_small_t small;
 	mp_int big;
 	char *buf;
 
 	if (isl_sioimath_decode_small(i, &small)) {
-		fprintf(out, "%*" PRIi32, width, small);
+		fprintf(out, "%*" PRIi64, width, (int64_t) small);
 		return;
 	}
 
@@ -16,7 +16,7 @@
 #include <stdlib.h>
 
 #include <isl_imath.h>
-#include <isl/hash.h>
+#include <isl_hash_private.h>
 
 #define ARRAY_SIZE(array) (sizeof(array)/sizeof(*array))
 
@@ -55,15 +55,29 @@
  * On 32 bit machines isl_sioimath type is blown up to 8 bytes, i.e.
  * isl_sioimath is guaranteed to be at least 8 bytes. This is to ensure the
  * int32_t can be hidden in that type without data loss. In the future we might
- * optimize this to use 31 hidden bits in a 32 bit pointer. We may also use 63
- * bits on 64 bit machines, but this comes with the cost of additional overflow
- * checks because there is no standardized 128 bit integer we could expand to.
+ * optimize this to use 31 hidden bits in a 32 bit pointer.
+ *
+ * If USE_SMALL_INT_OPT_64 is defined (--with-int=imath-64), then the small
+ * representation instead uses the 63 most significant bits to store
+ * an int64_t shifted left by one, i.e., the discriminator bit is kept
+ * in the least significant bit.
+ *
+ * Small representation (USE_SMALL_INT_OPT_64):
+ * MSB                                                          LSB
+ * |--------------------------------------------------------------1
+ * |                       int64_t << 1                           |
+ * |       4611686018427387903 ... -4611686018427387903           |
+ *
+ * Intermediate results of operations on small values are computed
+ * in isl_sioimath_wide_t, which is large enough to hold the sum of
+ * two products of small values, i.e., an int64_t for 32 bit small values
+ * and an __int128 for 63 bit small values.
  *
  * We use native integer types and avoid union structures to avoid assumptions
  * on the machine's endianness.
  *
  * This implementation makes the following assumptions:
- * - long can represent any int32_t
+ * - long can represent any value in small representation
  * - mp_small is signed long
  * - mp_usmall is unsigned long
  * - adresses returned by malloc are aligned to 2-byte boundaries (leastmost
@@ -86,11 +100,57 @@ typedef uintptr_t isl_sioimath;
  * To avoid checking these cases, we exclude INT32_MIN from small
  * representation.
  */
+#ifdef USE_SMALL_INT_OPT_64
+/* The type of values in small representation. */
+typedef int64_t isl_sioimath_small_t;
+/* The type of absolute values of values in small representation. */
+typedef uint64_t isl_sioimath_usmall_t;
+/* The type used for intermediate results of operations on small values. */
+typedef __int128 isl_sioimath_wide_t;
+/* The type of absolute values of intermediate results. */
+typedef unsigned __int128 isl_sioimath_uwide_t;
+
+/* As in the 32 bit case, the smallest 63 bit number is excluded
+ * from small representation.
+ */
+#define ISL_SIOIMATH_SMALL_MIN (-(INT64_MAX >> 1))
+
+/* Largest possible number in small representation */
+#define ISL_SIOIMATH_SMALL_MAX (INT64_MAX >> 1)
+
+/* Number of bits (including the sign bit) in small representation */
+#define ISL_SIOIMATH_SMALL_BITS 63
+
+/* Number of decimal digits of ISL_SIOIMATH_SMALL_MAX */
+#define ISL_SIOIMATH_SMALL_DIGITS 19
+
+/* Largest unsigned long that can be multiplied by a value
+ * in small representation without overflowing isl_sioimath_wide_t.
+ */
+#define ISL_SIOIMATH_SMALL_FACTOR_MAX ULONG_MAX
+#else
+typedef int32_t isl_sioimath_small_t;
+typedef uint32_t isl_sioimath_usmall_t;
+typedef int64_t isl_sioimath_wide_t;
+typedef uint64_t isl_sioimath_uwide_t;
+
 #define ISL_SIOIMATH_SMALL_MIN (-INT32_MAX)
 
 /* Largest possible number in small representation */
 #define ISL_SIOIMATH_SMALL_MAX INT32_MAX
 
+/* Number of bits (including the sign bit) in small representation */
+#define ISL_SIOIMATH_SMALL_BITS 32
+
+/* Number of decimal digits of ISL_SIOIMATH_SMALL_MAX */
+#define ISL_SIOIMATH_SMALL_DIGITS 10
+
+/* Largest unsigned long that can be multiplied by a value
+ * in small representation without overflowing isl_sioimath_wide_t.
+ */
+#define ISL_SIOIMATH_SMALL_FACTOR_MAX UINT32_MAX
+#endif
+
 /* Used for function parameters the function modifies. */
 typedef isl_sioimath *isl_sioimath_ptr;
 
@@ -111,13 +171,25 @@ inline int isl_sioimath_is_big(isl_sioimath val)
 	return !isl_sioimath_is_small(val);
 }
 
+#ifdef USE_SMALL_INT_OPT_64
+/* Get the number of an isl_int in small representation. Result is undefined if
+ * val is not stored in that format.
+ *
+ * The arithmetic right shift restores the sign.
+ */
+inline isl_sioimath_small_t isl_sioimath_get_small(isl_sioimath val)
+{
+	return (int64_t) val >> 1;
+}
+#else
 /* Get the number of an isl_int in small representation. Result is undefined if
  * val is not stored in that format.
  */
-inline int32_t isl_sioimath_get_small(isl_sioimath val)
+inline isl_sioimath_small_t isl_sioimath_get_small(isl_sioimath val)
 {
 	return val >> 32;
 }
+#endif
 
 /* Get the number of an in isl_int in big representation. Result is undefined if
  * val is not stored in that format.
@@ -133,7 +205,8 @@ inline mp_int isl_sioimath_get_big(isl_sioimath val)
  * representation. If there is no such branch, then a single shift is still
  * cheaper than introducing branching code.
  */
-inline int isl_sioimath_decode_small(isl_sioimath val, int32_t *small)
+inline int isl_sioimath_decode_small(isl_sioimath val,
+	isl_sioimath_small_t *small)
 {
 	*small = isl_sioimath_get_small(val);
 	return isl_sioimath_is_small(val);
@@ -147,12 +220,21 @@ inline int isl_sioimath_decode_big(isl_sioimath val, mp_int *big)
 	return isl_sioimath_is_big(val);
 }
 
+#ifdef USE_SMALL_INT_OPT_64
+/* Encode a small representation into an isl_int.
+ */
+inline isl_sioimath isl_sioimath_encode_small(isl_sioimath_small_t val)
+{
+	return ((isl_sioimath) val) << 1 | 0x00000001;
+}
+#else
 /* Encode a small representation into an isl_int.
  */
-inline isl_sioimath isl_sioimath_encode_small(int32_t val)
+inline isl_sioimath isl_sioimath_encode_small(isl_sioimath_small_t val)
 {
 	return ((isl_sioimath) val) << 32 | 0x00000001;
 }
+#endif
 
 /* Encode a big representation.
  */
@@ -185,7 +267,7 @@ inline isl_sioimath isl_sioimath_encode_big(mp_int val)
  */
 typedef struct {
 	mpz_t big;
-	mp_digit digits[(sizeof(uintmax_t) + sizeof(mp_digit) - 1) /
+	mp_digit digits[(sizeof(isl_sioimath_uwide_t) + sizeof(mp_digit) - 1) /
 	                sizeof(mp_digit)];
 } isl_sioimath_scratchspace_t;
 
@@ -235,6 +317,18 @@ inline void isl_siomath_uint64_to_digits(uint64_t num, mp_digit *digits,
 	ISL_SIOIMATH_TO_DIGITS(num, digits, *used);
 }
 
+inline void isl_siomath_usmall_to_digits(isl_sioimath_usmall_t num,
+	mp_digit *digits, mp_size *used)
+{
+	ISL_SIOIMATH_TO_DIGITS(num, digits, *used);
+}
+
+inline void isl_siomath_uwide_to_digits(isl_sioimath_uwide_t num,
+	mp_digit *digits, mp_size *used)
+{
+	ISL_SIOIMATH_TO_DIGITS(num, digits, *used);
+}
+
 /* Get the IMath representation of an isl_int without modifying it.
  * For the case it is not in big representation yet, pass some scratch space we
  * can use to store the big representation in.
@@ -248,8 +342,8 @@ inline mp_int isl_sioimath_bigarg_src(isl_sioimath arg,
 	isl_sioimath_scratchspace_t *scratch)
 {
 	mp_int big;
-	int32_t small;
-	uint32_t num;
+	isl_sioimath_small_t small;
+	isl_sioimath_usmall_t num;
 
 	if (isl_sioimath_decode_big(arg, &big))
 		return big;
@@ -265,7 +359,7 @@ inline mp_int isl_sioimath_bigarg_src(isl_sioimath arg,
 		num = -small;
 	}
 
-	isl_siomath_uint32_to_digits(num, scratch->digits, &scratch->big.used);
+	isl_siomath_usmall_to_digits(num, scratch->digits, &scratch->big.used);
 	return &scratch->big;
 }
 
@@ -311,6 +405,29 @@ inline mp_int isl_sioimath_si64arg_src(int64_t arg,
 	return &scratch->big;
 }
 
+/* Create a temporary IMath mp_int for an isl_sioimath_wide_t.
+ * The absolute value is computed on the unsigned type such that
+ * the smallest value does not need to be special-cased.
+ */
+inline mp_int isl_sioimath_widearg_src(isl_sioimath_wide_t arg,
+	isl_sioimath_scratchspace_t *scratch)
+{
+	isl_sioimath_uwide_t num;
+
+	scratch->big.digits = scratch->digits;
+	scratch->big.alloc = ARRAY_SIZE(scratch->digits);
+	if (arg >= 0) {
+		scratch->big.sign = MP_ZPOS;
+		num = arg;
+	} else {
+		scratch->big.sign = MP_NEG;
+		num = (isl_sioimath_uwide_t) 0 - (isl_sioimath_uwide_t) arg;
+	}
+
+	isl_siomath_uwide_to_digits(num, scratch->digits, &scratch->big.used);
+	return &scratch->big;
+}
+
 /* Create a temporary IMath mp_int for an unsigned long.
  */
 inline mp_int isl_sioimath_uiarg_src(unsigned long arg,
@@ -337,7 +454,8 @@ inline mp_int isl_sioimath_reinit_big(isl_sioimath_ptr ptr)
 
 /* Set ptr to a number in small representation.
  */
-inline void isl_sioimath_set_small(isl_sioimath_ptr ptr, int32_t val)
+inline void isl_sioimath_set_small(isl_sioimath_ptr ptr,
+	isl_sioimath_small_t val)
 {
 	if (isl_sioimath_is_big(*ptr))
 		mp_int_free(isl_sioimath_get_big(*ptr));
@@ -370,11 +488,28 @@ inline void isl_sioimath_set_int64(isl_sioimath_ptr ptr, int64_t val)
 	    isl_sioimath_reinit_big(ptr));
 }
 
+/* Assign an intermediate result of an operation on small values,
+ * using small representation if possible.
+ */
+inline void isl_sioimath_set_wide(isl_sioimath_ptr ptr,
+	isl_sioimath_wide_t val)
+{
+	isl_sioimath_scratchspace_t scratch;
+
+	if (ISL_SIOIMATH_SMALL_MIN <= val && val <= ISL_SIOIMATH_SMALL_MAX) {
+		isl_sioimath_set_small(ptr, val);
+		return;
+	}
+
+	mp_int_copy(isl_sioimath_widearg_src(val, &scratch),
+	    isl_sioimath_reinit_big(ptr));
+}
+
 /* Convert to big representation while preserving the current number.
  */
 inline void isl_sioimath_promote(isl_sioimath_ptr dst)
 {
-	int32_t small;
+	isl_sioimath_small_t small;
 
 	if (isl_sioimath_is_big(*dst))
 		return;
@@ -529,16 +664,17 @@ inline double isl_sioimath_get_d(isl_sioimath_src val)
 
 /* Format a number as decimal string.
  *
- * The largest possible string from small representation is 12 characters
- * ("-2147483647").
+ * The largest possible string from small representation is 21 characters
+ * ("-4611686018427387903") including the null terminator.
  */
 inline char *isl_sioimath_get_str(isl_sioimath_src val)
 {
 	char *result;
 
 	if (isl_sioimath_is_small(val)) {
-		result = malloc(12);
-		snprintf(result, 12, "%" PRIi32, isl_sioimath_get_small(val));
+		result = malloc(21);
+		snprintf(result, 21, "%" PRIi64,
+		    (int64_t) isl_sioimath_get_small(val));
 		return result;
 	}
 
@@ -589,7 +725,7 @@ inline void isl_sioimath_swap(isl_sioimath_ptr lhs, isl_sioimath_ptr rhs)
 inline void isl_sioimath_add_ui(isl_sioimath_ptr dst, isl_sioimath lhs,
 	unsigned long rhs)
 {
-	int32_t smalllhs;
+	isl_sioimath_small_t smalllhs;
 	isl_sioimath_scratchspace_t lhsscratch;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
@@ -607,17 +743,19 @@ inline void isl_sioimath_add_ui(isl_sioimath_ptr dst, isl_sioimath lhs,
  *
  * On LP64 unsigned long exceeds the range of an int64_t.  If
  * ISL_SIOIMATH_SMALL_MIN-rhs>=INT64_MIN we can do the calculation using int64_t
- * without risking an overflow.
+ * without risking an overflow.  Since ISL_SIOIMATH_SMALL_MIN is equal to
+ * -ISL_SIOIMATH_SMALL_MAX, this is the same condition as in
+ * isl_sioimath_add_ui.
  */
 inline void isl_sioimath_sub_ui(isl_sioimath_ptr dst, isl_sioimath lhs,
 				unsigned long rhs)
 {
-	int32_t smalllhs;
+	isl_sioimath_small_t smalllhs;
 	isl_sioimath_scratchspace_t lhsscratch;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
-	    (rhs < (uint64_t) INT64_MIN - (uint64_t) ISL_SIOIMATH_SMALL_MIN)) {
-		isl_sioimath_set_int64(dst, (int64_t) smalllhs - rhs);
+	    (rhs <= (uint64_t) INT64_MAX - (uint64_t) ISL_SIOIMATH_SMALL_MAX)) {
+		isl_sioimath_set_int64(dst, (int64_t) smalllhs - (int64_t) rhs);
 		return;
 	}
 
@@ -632,12 +770,12 @@ inline void isl_sioimath_add(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs, smallrhs;
+	isl_sioimath_small_t smalllhs, smallrhs;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
 	    isl_sioimath_decode_small(rhs, &smallrhs)) {
-		isl_sioimath_set_int64(
-		    dst, (int64_t) smalllhs + (int64_t) smallrhs);
+		isl_sioimath_set_wide(dst, (isl_sioimath_wide_t) smalllhs +
+		    (isl_sioimath_wide_t) smallrhs);
 		return;
 	}
 
@@ -653,12 +791,12 @@ inline void isl_sioimath_sub(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs, smallrhs;
+	isl_sioimath_small_t smalllhs, smallrhs;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
 	    isl_sioimath_decode_small(rhs, &smallrhs)) {
-		isl_sioimath_set_int64(
-		    dst, (int64_t) smalllhs - (int64_t) smallrhs);
+		isl_sioimath_set_wide(dst, (isl_sioimath_wide_t) smalllhs -
+		    (isl_sioimath_wide_t) smallrhs);
 		return;
 	}
 
@@ -674,12 +812,12 @@ inline void isl_sioimath_mul(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs, smallrhs;
+	isl_sioimath_small_t smalllhs, smallrhs;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
 	    isl_sioimath_decode_small(rhs, &smallrhs)) {
-		isl_sioimath_set_int64(
-		    dst, (int64_t) smalllhs * (int64_t) smallrhs);
+		isl_sioimath_set_wide(dst, (isl_sioimath_wide_t) smalllhs *
+		    (isl_sioimath_wide_t) smallrhs);
 		return;
 	}
 
@@ -691,15 +829,22 @@ inline void isl_sioimath_mul(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 
 /* Shift lhs by rhs bits to the left and store the result in dst. Effectively,
  * this operation computes 'lhs * 2^rhs'.
+ *
+ * The shift is performed on the absolute value since shifting
+ * a negative value to the left is undefined.
  */
 inline void isl_sioimath_mul_2exp(isl_sioimath_ptr dst, isl_sioimath lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs;
-	int32_t smalllhs;
+	isl_sioimath_small_t smalllhs;
+	isl_sioimath_wide_t shifted;
 
-	if (isl_sioimath_decode_small(lhs, &smalllhs) && (rhs <= 32ul)) {
-		isl_sioimath_set_int64(dst, ((int64_t) smalllhs) << rhs);
+	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
+	    (rhs <= ISL_SIOIMATH_SMALL_BITS)) {
+		shifted = (isl_sioimath_wide_t) (smalllhs < 0 ? -smalllhs : smalllhs)
+		    << rhs;
+		isl_sioimath_set_wide(dst, smalllhs < 0 ? -shifted : shifted);
 		return;
 	}
 
@@ -713,11 +858,12 @@ inline void isl_sioimath_mul_si(isl_sioimath_ptr dst, isl_sioimath lhs,
 	signed long rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs;
+	isl_sioimath_small_t smalllhs;
 
 	if (isl_sioimath_decode_small(lhs, &smalllhs) && (rhs > LONG_MIN) &&
-	    (labs(rhs) <= UINT32_MAX)) {
-		isl_sioimath_set_int64(dst, (int64_t) smalllhs * (int64_t) rhs);
+	    (labs(rhs) <= ISL_SIOIMATH_SMALL_FACTOR_MAX)) {
+		isl_sioimath_set_wide(dst,
+		    (isl_sioimath_wide_t) smalllhs * (isl_sioimath_wide_t) rhs);
 		return;
 	}
 
@@ -733,10 +879,12 @@ inline void isl_sioimath_mul_ui(isl_sioimath_ptr dst, isl_sioimath lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs;
+	isl_sioimath_small_t smalllhs;
 
-	if (isl_sioimath_decode_small(lhs, &smalllhs) && (rhs <= UINT32_MAX)) {
-		isl_sioimath_set_int64(dst, (int64_t) smalllhs * (int64_t) rhs);
+	if (isl_sioimath_decode_small(lhs, &smalllhs) &&
+	    (rhs <= ISL_SIOIMATH_SMALL_FACTOR_MAX)) {
+		isl_sioimath_set_wide(dst,
+		    (isl_sioimath_wide_t) smalllhs * (isl_sioimath_wide_t) rhs);
 		return;
 	}
 
@@ -755,7 +903,7 @@ inline void isl_sioimath_pow_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t scratchlhs, scratchrhs;
-	int32_t smalllhs;
+	isl_sioimath_small_t smalllhs;
 
 	switch (rhs) {
 	case 0:
@@ -798,11 +946,24 @@ inline void isl_sioimath_pow_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 }
 
 /* Fused multiply-add.
+ *
+ * If all arguments are in small representation, then the result
+ * is computed in isl_sioimath_wide_t without any temporary isl_int.
  */
 inline void isl_sioimath_addmul(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath tmp;
+	isl_sioimath_small_t smalldst, smalllhs, smallrhs;
+
+	if (isl_sioimath_decode_small(*dst, &smalldst) &&
+	    isl_sioimath_decode_small(lhs, &smalllhs) &&
+	    isl_sioimath_decode_small(rhs, &smallrhs)) {
+		isl_sioimath_set_wide(dst, (isl_sioimath_wide_t) smalldst +
+		    (isl_sioimath_wide_t) smalllhs * smallrhs);
+		return;
+	}
+
 	isl_sioimath_init(&tmp);
 	isl_sioimath_mul(&tmp, lhs, rhs);
 	isl_sioimath_add(dst, *dst, tmp);
@@ -822,11 +983,24 @@ inline void isl_sioimath_addmul_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 }
 
 /* Fused multiply-subtract.
+ *
+ * If all arguments are in small representation, then the result
+ * is computed in isl_sioimath_wide_t without any temporary isl_int.
  */
 inline void isl_sioimath_submul(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath tmp;
+	isl_sioimath_small_t smalldst, smalllhs, smallrhs;
+
+	if (isl_sioimath_decode_small(*dst, &smalldst) &&
+	    isl_sioimath_decode_small(lhs, &smalllhs) &&
+	    isl_sioimath_decode_small(rhs, &smallrhs)) {
+		isl_sioimath_set_wide(dst, (isl_sioimath_wide_t) smalldst -
+		    (isl_sioimath_wide_t) smalllhs * smallrhs);
+		return;
+	}
+
 	isl_sioimath_init(&tmp);
 	isl_sioimath_mul(&tmp, lhs, rhs);
 	isl_sioimath_sub(dst, *dst, tmp);
@@ -850,13 +1024,27 @@ void isl_sioimath_gcd(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 void isl_sioimath_lcm(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 		      isl_sioimath_src rhs);
 
+int isl_sioimath_seq_addmul_small(isl_sioimath *dst, isl_sioimath_src f,
+	isl_sioimath *src, unsigned len);
+int isl_sioimath_seq_submul_small(isl_sioimath *dst, isl_sioimath_src f,
+	isl_sioimath *src, unsigned len);
+int isl_sioimath_seq_scale_small(isl_sioimath *dst, isl_sioimath *src,
+	isl_sioimath_src m, unsigned len);
+int isl_sioimath_seq_scale_down_small(isl_sioimath *dst, isl_sioimath *src,
+	isl_sioimath_src m, unsigned len);
+int isl_sioimath_seq_combine_small(isl_sioimath *dst, isl_sioimath_src m1,
+	isl_sioimath *src1, isl_sioimath_src m2, isl_sioimath *src2,
+	unsigned len);
+int isl_sioimath_seq_gcd_small(isl_sioimath *p, unsigned len,
+	isl_sioimath_ptr gcd);
+
 /* Divide lhs by rhs, rounding to zero (Truncate).
  */
 inline void isl_sioimath_tdiv_q(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
+	isl_sioimath_small_t lhssmall, rhssmall;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall)) {
@@ -877,11 +1065,13 @@ inline void isl_sioimath_tdiv_q_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall;
+	isl_sioimath_small_t lhssmall;
 
-	if (isl_sioimath_is_small(lhs) && (rhs <= (unsigned long) INT32_MAX)) {
+	if (isl_sioimath_is_small(lhs) &&
+	    (rhs <= (unsigned long) ISL_SIOIMATH_SMALL_MAX)) {
 		lhssmall = isl_sioimath_get_small(lhs);
-		isl_sioimath_set_small(dst, lhssmall / (int32_t) rhs);
+		isl_sioimath_set_small(dst,
+		    lhssmall / (isl_sioimath_small_t) rhs);
 		return;
 	}
 
@@ -903,18 +1093,18 @@ inline void isl_sioimath_tdiv_q_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 inline void isl_sioimath_cdiv_q(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
-	int32_t lhssmall, rhssmall;
+	isl_sioimath_small_t lhssmall, rhssmall;
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t q;
+	isl_sioimath_small_t q;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall)) {
 		if ((lhssmall >= 0) && (rhssmall >= 0))
-			q = ((int64_t) lhssmall + (int64_t) rhssmall - 1) /
-			    rhssmall;
+			q = ((isl_sioimath_wide_t) lhssmall +
+			    (isl_sioimath_wide_t) rhssmall - 1) / rhssmall;
 		else if ((lhssmall < 0) && (rhssmall < 0))
-			q = ((int64_t) lhssmall + (int64_t) rhssmall + 1) /
-			    rhssmall;
+			q = ((isl_sioimath_wide_t) lhssmall +
+			    (isl_sioimath_wide_t) rhssmall + 1) / rhssmall;
 		else
 			q = lhssmall / rhssmall;
 		isl_sioimath_set_small(dst, q);
@@ -933,17 +1123,17 @@ inline void isl_sioimath_fdiv_q(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
-	int32_t q;
+	isl_sioimath_small_t lhssmall, rhssmall;
+	isl_sioimath_small_t q;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall)) {
 		if ((lhssmall < 0) && (rhssmall >= 0))
-			q = ((int64_t) lhssmall - ((int64_t) rhssmall - 1)) /
-			    rhssmall;
+			q = ((isl_sioimath_wide_t) lhssmall -
+			    ((isl_sioimath_wide_t) rhssmall - 1)) / rhssmall;
 		else if ((lhssmall >= 0) && (rhssmall < 0))
-			q = ((int64_t) lhssmall - ((int64_t) rhssmall + 1)) /
-			    rhssmall;
+			q = ((isl_sioimath_wide_t) lhssmall -
+			    ((isl_sioimath_wide_t) rhssmall + 1)) / rhssmall;
 		else
 			q = lhssmall / rhssmall;
 		isl_sioimath_set_small(dst, q);
@@ -963,14 +1153,16 @@ inline void isl_sioimath_fdiv_q_ui(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	unsigned long rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, q;
+	isl_sioimath_small_t lhssmall, q;
 
-	if (isl_sioimath_decode_small(lhs, &lhssmall) && (rhs <= INT32_MAX)) {
+	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
+	    (rhs <= ISL_SIOIMATH_SMALL_MAX)) {
 		if (lhssmall >= 0)
-			q = (uint32_t) lhssmall / rhs;
+			q = (isl_sioimath_usmall_t) lhssmall / rhs;
 		else
-			q = ((int64_t) lhssmall - ((int64_t) rhs - 1)) /
-			    (int64_t) rhs;
+			q = ((isl_sioimath_wide_t) lhssmall -
+			    ((isl_sioimath_wide_t) rhs - 1)) /
+			    (isl_sioimath_wide_t) rhs;
 		isl_sioimath_set_small(dst, q);
 		return;
 	}
@@ -988,8 +1180,8 @@ inline void isl_sioimath_fdiv_r(isl_sioimath_ptr dst, isl_sioimath_src lhs,
 	isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int64_t lhssmall, rhssmall;
-	int32_t r;
+	isl_sioimath_wide_t lhssmall, rhssmall;
+	isl_sioimath_small_t r;
 
 	if (isl_sioimath_is_small(lhs) && isl_sioimath_is_small(rhs)) {
 		lhssmall = isl_sioimath_get_small(lhs);
@@ -1014,7 +1206,7 @@ void isl_sioimath_read(isl_sioimath_ptr dst, const char *str);
  */
 inline int isl_sioimath_sgn(isl_sioimath_src arg)
 {
-	int32_t small;
+	isl_sioimath_small_t small;
 
 	if (isl_sioimath_decode_small(arg, &small))
 		return (small > 0) - (small < 0);
@@ -1030,7 +1222,7 @@ inline int isl_sioimath_sgn(isl_sioimath_src arg)
 inline int isl_sioimath_cmp(isl_sioimath_src lhs, isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
+	isl_sioimath_small_t lhssmall, rhssmall;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall))
@@ -1052,7 +1244,7 @@ inline int isl_sioimath_cmp(isl_sioimath_src lhs, isl_sioimath_src rhs)
  */
 inline int isl_sioimath_cmp_si(isl_sioimath_src lhs, signed long rhs)
 {
-	int32_t lhssmall;
+	isl_sioimath_small_t lhssmall;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall))
 		return (lhssmall > rhs) - (lhssmall < rhs);
@@ -1068,7 +1260,7 @@ inline int isl_sioimath_cmp_si(isl_sioimath_src lhs, signed long rhs)
 inline int isl_sioimath_abs_cmp(isl_sioimath_src lhs, isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
+	isl_sioimath_small_t lhssmall, rhssmall;
 
 	if (isl_sioimath_decode_small(lhs, &lhssmall) &&
 	    isl_sioimath_decode_small(rhs, &rhssmall)) {
@@ -1088,7 +1280,7 @@ inline int isl_sioimath_is_divisible_by(isl_sioimath_src lhs,
 					isl_sioimath_src rhs)
 {
 	isl_sioimath_scratchspace_t lhsscratch, rhsscratch;
-	int32_t lhssmall, rhssmall;
+	isl_sioimath_small_t lhssmall, rhssmall;
 	mpz_t rem;
 	int cmp;
 
@@ -1111,25 +1303,15 @@ inline int isl_sioimath_is_divisible_by(isl_sioimath_src lhs,
 /* Return a hash code of an isl_sioimath.
  * The hash code for a number in small and big representation must be identical
  * on the same machine because small representation if not obligatory if fits.
+ * A small value is hashed directly as a (sign extended) machine word,
+ * which is also what isl_imath_hash does for values that fit in 64 bits.
  */
 inline uint32_t isl_sioimath_hash(isl_sioimath_src arg, uint32_t hash)
 {
-	int32_t small;
-	int i;
-	uint32_t num;
-	mp_digit digits[(sizeof(uint32_t) + sizeof(mp_digit) - 1) /
-	                sizeof(mp_digit)];
-	mp_size used;
-	const unsigned char *digitdata = (const unsigned char *) &digits;
+	isl_sioimath_small_t small;
 
 	if (isl_sioimath_decode_small(arg, &small)) {
-		if (small < 0)
-			isl_hash_byte(hash, 0xFF);
-		num = labs(small);
-
-		isl_siomath_uint32_to_digits(num, digits, &used);
-		for (i = 0; i < used * sizeof(mp_digit); i += 1)
-			isl_hash_byte(hash, digitdata[i]);
+		isl_hash_word(hash, (int64_t) small);
 		return hash;
 	}
 
@@ -1145,10 +1327,10 @@ inline uint32_t isl_sioimath_hash(isl_sioimath_src arg, uint32_t hash)
  */
 inline size_t isl_sioimath_sizeinbase(isl_sioimath_src arg, int base)
 {
-	int32_t small;
+	isl_sioimath_small_t small;
 
 	if (isl_sioimath_decode_small(arg, &small))
-		return sizeof(int32_t) * CHAR_BIT - 1;
+		return ISL_SIOIMATH_SMALL_BITS - 1;
 
 	return impz_sizeinbase(isl_sioimath_get_big(arg), base);
 }
@@ -1217,6 +1399,24 @@ typedef isl_sioimath isl_int[1];
 #define isl_int_is_divisible_by(i, j)	isl_sioimath_is_divisible_by(*(i), *(j))
 
 #define isl_int_hash(v, h)		isl_sioimath_hash(*(v), h)
+
+#define isl_int_seq_addmul_small(dst, f, src, len)			\
+	isl_sioimath_seq_addmul_small((isl_sioimath *) (dst), *(f),	\
+	    (isl_sioimath *) (src), len)
+#define isl_int_seq_submul_small(dst, f, src, len)			\
+	isl_sioimath_seq_submul_small((isl_sioimath *) (dst), *(f),	\
+	    (isl_sioimath *) (src), len)
+#define isl_int_seq_scale_small(dst, src, m, len)			\
+	isl_sioimath_seq_scale_small((isl_sioimath *) (dst),		\
+	    (isl_sioimath *) (src), *(m), len)
+#define isl_int_seq_scale_down_small(dst, src, m, len)			\
+	isl_sioimath_seq_scale_down_small((isl_sioimath *) (dst),	\
+	    (isl_sioimath *) (src), *(m), len)
+#define isl_int_seq_combine_small(dst, m1, src1, m2, src2, len)		\
+	isl_sioimath_seq_combine_small((isl_sioimath *) (dst), *(m1),	\
+	    (isl_sioimath *) (src1), *(m2), (isl_sioimath *) (src2), len)
+#define isl_int_seq_gcd_small(p, len, gcd)				\
+	isl_sioimath_seq_gcd_small((isl_sioimath *) (p), len, *(gcd))
 #define isl_int_free_str(s)		free(s)
 #define isl_int_print(out, i, width)	isl_sioimath_print(out, *(i), width)
 
@@ -20,6 +20,7 @@
 #include <isl_ctx_private.h>
 #include <isl_map_private.h>
 #include <isl_blk.h>
+#include <isl_basic_map_cache.h>
 #include <isl/constraint.h>
 #include "isl_space_private.h"
 #include "isl_equalities.h"
@@ -1079,26 +1080,62 @@ struct isl_basic_map *isl_basic_map_alloc(struct isl_ctx *ctx,
 	return bmap;
 }
 
-static void dup_constraints(
-		struct isl_basic_map *dst, struct isl_basic_map *src)
+/* Are the "n" rows "row" of length "len" stored consecutively
+ * (and in order) in memory?
+ */
+static int rows_are_consecutive(isl_int **row, int n, unsigned len)
 {
 	int i;
-	unsigned total = isl_basic_map_total_dim(src);
 
-	for (i = 0; i < src->n_eq; ++i) {
-		int j = isl_basic_map_alloc_equality(dst);
-		isl_seq_cpy(dst->eq[j], src->eq[i], 1+total);
-	}
+	for (i = 1; i < n; ++i)
+		if (row[i] != row[0] + i * len)
+			return 0;
 
-	for (i = 0; i < src->n_ineq; ++i) {
-		int j = isl_basic_map_alloc_inequality(dst);
-		isl_seq_cpy(dst->ineq[j], src->ineq[i], 1+total);
-	}
+	return 1;
+}
 
-	for (i = 0; i < src->n_div; ++i) {
-		int j = isl_basic_map_alloc_div(dst);
-		isl_seq_cpy(dst->div[j], src->div[i], 1+1+total);
+/* Copy the "n" rows "src" of length "len" to the "n" rows "dst".
+ *
+ * The rows of a basic map are stored in a single block,
+ * but they may get permuted by exchanging the row pointers.
+ * If the rows are stored consecutively in both "dst" and "src"
+ * (with no extra room between them), then they are copied
+ * as a single sequence.
+ */
+static void copy_rows(isl_int **dst, isl_int **src, int n, unsigned len)
+{
+	int i;
+
+	if (n == 0)
+		return;
+	if (rows_are_consecutive(dst, n, len) &&
+	    rows_are_consecutive(src, n, len)) {
+		isl_seq_cpy(dst[0], src[0], n * len);
+		return;
 	}
+
+	for (i = 0; i < n; ++i)
+		isl_seq_cpy(dst[i], src[i], len);
+}
+
+/* Copy the constraints and integer divisions of "src" to "dst",
+ * where "dst" is a freshly allocated basic map with room
+ * for exactly the constraints and integer divisions of "src".
+ * Since "dst" has room for exactly "src->n_div" integer divisions,
+ * its rows have the same length as the part of the rows of "src"
+ * that is in use.
+ */
+static void dup_constraints(
+		struct isl_basic_map *dst, struct isl_basic_map *src)
+{
+	unsigned total = isl_basic_map_total_dim(src);
+
+	dst->n_eq = src->n_eq;
+	dst->n_ineq = src->n_ineq;
+	dst->n_div = src->n_div;
+	copy_rows(dst->eq, src->eq, src->n_eq, 1 + total);
+	copy_rows(dst->ineq, src->ineq, src->n_ineq, 1 + total);
+	copy_rows(dst->div, src->div, src->n_div, 1 + 1 + total);
 	ISL_F_SET(dst, ISL_BASIC_SET_FINAL);
 }
 
@@ -6179,6 +6216,10 @@ error:
  * update both "res" and "todo".
  * If "empty" is NULL, then the todo sets are not needed and therefore
  * also not computed.
+ *
+ * Since the problems for the different basic maps are often
+ * defined over the same domains, the context tableaus constructed
+ * for these domains are shared among the problems.
  */
 static __isl_give isl_pw_multi_aff *isl_map_partial_lexopt_aligned_pw_multi_aff(
 	__isl_take isl_map *map, __isl_take isl_set *dom,
@@ -6201,6 +6242,9 @@ static __isl_give isl_pw_multi_aff *isl_map_partial_lexopt_aligned_pw_multi_aff(
 		return isl_pw_multi_aff_from_map(map);
 	}
 
+	if (isl_tab_shared_contexts_start(map->ctx) < 0)
+		goto error;
+
 	res = basic_map_partial_lexopt_pw_multi_aff(
 					    isl_basic_map_copy(map->p[0]),
 					    isl_set_copy(dom), empty, flags);
@@ -6223,6 +6267,7 @@ static __isl_give isl_pw_multi_aff *isl_map_partial_lexopt_aligned_pw_multi_aff(
 			todo = isl_set_intersect(todo, *empty);
 	}
 
+	isl_tab_shared_contexts_finish(map->ctx);
 	isl_set_free(dom);
 	isl_map_free(map);
 
@@ -7840,16 +7885,16 @@ isl_bool isl_set_is_equal(__isl_keep isl_set *set1, __isl_keep isl_set *set2)
 	return isl_map_is_equal((struct isl_map *)set1, (struct isl_map *)set2);
 }
 
-isl_bool isl_basic_map_is_subset(__isl_keep isl_basic_map *bmap1,
+/* Is "bmap1" a subset of "bmap2"?
+ * Check this on the corresponding maps.
+ */
+static isl_bool basic_map_is_subset(__isl_keep isl_basic_map *bmap1,
 	__isl_keep isl_basic_map *bmap2)
 {
 	int is_subset;
 	struct isl_map *map1;
 	struct isl_map *map2;
 
-	if (!bmap1 || !bmap2)
-		return isl_bool_error;
-
 	map1 = isl_map_from_basic_map(isl_basic_map_copy(bmap1));
 	map2 = isl_map_from_basic_map(isl_basic_map_copy(bmap2));
 
@@ -7861,6 +7906,19 @@ isl_bool isl_basic_map_is_subset(__isl_keep isl_basic_map *bmap1,
 	return is_subset;
 }
 
+/* Is "bmap1" a subset of "bmap2"?
+ *
+ * The result may be taken from the basic map cache.
+ */
+isl_bool isl_basic_map_is_subset(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2)
+{
+	if (!bmap1 || !bmap2)
+		return isl_bool_error;
+
+	return isl_basic_map_cache_test(bmap1, bmap2, &basic_map_is_subset);
+}
+
 isl_bool isl_basic_set_is_subset(__isl_keep isl_basic_set *bset1,
 	__isl_keep isl_basic_set *bset2)
 {
@@ -8094,10 +8152,41 @@ isl_bool isl_set_plain_is_universe(__isl_keep isl_set *set)
 	return isl_map_plain_is_universe((isl_map *) set);
 }
 
+/* Is "bmap" empty?  Look for an integer point in "bmap" and
+ * keep track of it in bmap->sample, if there is any.
+ * "unused" is only present such that this function
+ * can be passed to isl_basic_map_cache_test.
+ */
+static isl_bool basic_map_sample_is_empty(__isl_keep isl_basic_map *bmap,
+	__isl_keep isl_basic_map *unused)
+{
+	struct isl_basic_set *bset;
+	struct isl_vec *sample;
+	isl_bool empty;
+
+	isl_vec_free(bmap->sample);
+	bmap->sample = NULL;
+	bset = isl_basic_map_underlying_set(isl_basic_map_copy(bmap));
+	if (!bset)
+		return isl_bool_error;
+	sample = isl_basic_set_sample_vec(bset);
+	if (!sample)
+		return isl_bool_error;
+	empty = sample->size == 0;
+	isl_vec_free(bmap->sample);
+	bmap->sample = sample;
+
+	return empty;
+}
+
+/* Is "bmap" empty?
+ *
+ * If this cannot be determined from the cached information,
+ * then look for an integer point in basic_map_sample_is_empty,
+ * possibly taking the result from the basic map cache instead.
+ */
 isl_bool isl_basic_map_is_empty(__isl_keep isl_basic_map *bmap)
 {
-	struct isl_basic_set *bset = NULL;
-	struct isl_vec *sample = NULL;
 	isl_bool empty, non_empty;
 
 	if (!bmap)
@@ -8122,18 +8211,9 @@ isl_bool isl_basic_map_is_empty(__isl_keep isl_basic_map *bmap)
 		return isl_bool_error;
 	if (non_empty)
 		return isl_bool_false;
-	isl_vec_free(bmap->sample);
-	bmap->sample = NULL;
-	bset = isl_basic_map_underlying_set(isl_basic_map_copy(bmap));
-	if (!bset)
-		return isl_bool_error;
-	sample = isl_basic_set_sample_vec(bset);
-	if (!sample)
-		return isl_bool_error;
-	empty = sample->size == 0;
-	isl_vec_free(bmap->sample);
-	bmap->sample = sample;
-	if (empty)
+	empty = isl_basic_map_cache_test(bmap, NULL,
+					&basic_map_sample_is_empty);
+	if (empty == isl_bool_true)
 		ISL_F_SET(bmap, ISL_BASIC_MAP_EMPTY);
 
 	return empty;
@@ -10022,24 +10102,24 @@ uint32_t isl_basic_map_get_hash(__isl_keep isl_basic_map *bmap)
 	if (!bmap)
 		return 0;
 	total = isl_basic_map_total_dim(bmap);
-	isl_hash_byte(hash, bmap->n_eq & 0xFF);
+	isl_hash_word(hash, bmap->n_eq);
 	for (i = 0; i < bmap->n_eq; ++i) {
 		uint32_t c_hash;
 		c_hash = isl_seq_get_hash(bmap->eq[i], 1 + total);
 		isl_hash_hash(hash, c_hash);
 	}
-	isl_hash_byte(hash, bmap->n_ineq & 0xFF);
+	isl_hash_word(hash, bmap->n_ineq);
 	for (i = 0; i < bmap->n_ineq; ++i) {
 		uint32_t c_hash;
 		c_hash = isl_seq_get_hash(bmap->ineq[i], 1 + total);
 		isl_hash_hash(hash, c_hash);
 	}
-	isl_hash_byte(hash, bmap->n_div & 0xFF);
+	isl_hash_word(hash, bmap->n_div);
 	for (i = 0; i < bmap->n_div; ++i) {
 		uint32_t c_hash;
 		if (isl_int_is_zero(bmap->div[i][0]))
 			continue;
-		isl_hash_byte(hash, i & 0xFF);
+		isl_hash_word(hash, i);
 		c_hash = isl_seq_get_hash(bmap->div[i], 1 + 1 + total);
 		isl_hash_hash(hash, c_hash);
 	}
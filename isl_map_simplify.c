@@ -319,16 +319,20 @@ struct isl_basic_map *isl_basic_map_normalize_constraints(
 	struct isl_basic_map *bmap)
 {
 	int i;
-	isl_int gcd;
+	isl_int *gcd;
+	isl_ctx *ctx;
 	unsigned total = isl_basic_map_total_dim(bmap);
 
 	if (!bmap)
 		return NULL;
 
-	isl_int_init(gcd);
+	ctx = isl_basic_map_get_ctx(bmap);
+	gcd = isl_ctx_scratch_acquire(ctx, 1);
+	if (!gcd)
+		return isl_basic_map_free(bmap);
 	for (i = bmap->n_eq - 1; i >= 0; --i) {
-		isl_seq_gcd(bmap->eq[i]+1, total, &gcd);
-		if (isl_int_is_zero(gcd)) {
+		isl_seq_gcd(bmap->eq[i]+1, total, gcd);
+		if (isl_int_is_zero(*gcd)) {
 			if (!isl_int_is_zero(bmap->eq[i][0])) {
 				bmap = isl_basic_map_set_to_empty(bmap);
 				break;
@@ -337,19 +341,19 @@ struct isl_basic_map *isl_basic_map_normalize_constraints(
 			continue;
 		}
 		if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
-			isl_int_gcd(gcd, gcd, bmap->eq[i][0]);
-		if (isl_int_is_one(gcd))
+			isl_int_gcd(*gcd, *gcd, bmap->eq[i][0]);
+		if (isl_int_is_one(*gcd))
 			continue;
-		if (!isl_int_is_divisible_by(bmap->eq[i][0], gcd)) {
+		if (!isl_int_is_divisible_by(bmap->eq[i][0], *gcd)) {
 			bmap = isl_basic_map_set_to_empty(bmap);
 			break;
 		}
-		isl_seq_scale_down(bmap->eq[i], bmap->eq[i], gcd, 1+total);
+		isl_seq_scale_down(bmap->eq[i], bmap->eq[i], *gcd, 1+total);
 	}
 
 	for (i = bmap->n_ineq - 1; i >= 0; --i) {
-		isl_seq_gcd(bmap->ineq[i]+1, total, &gcd);
-		if (isl_int_is_zero(gcd)) {
+		isl_seq_gcd(bmap->ineq[i]+1, total, gcd);
+		if (isl_int_is_zero(*gcd)) {
 			if (isl_int_is_neg(bmap->ineq[i][0])) {
 				bmap = isl_basic_map_set_to_empty(bmap);
 				break;
@@ -358,13 +362,14 @@ struct isl_basic_map *isl_basic_map_normalize_constraints(
 			continue;
 		}
 		if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
-			isl_int_gcd(gcd, gcd, bmap->ineq[i][0]);
-		if (isl_int_is_one(gcd))
+			isl_int_gcd(*gcd, *gcd, bmap->ineq[i][0]);
+		if (isl_int_is_one(*gcd))
 			continue;
-		isl_int_fdiv_q(bmap->ineq[i][0], bmap->ineq[i][0], gcd);
-		isl_seq_scale_down(bmap->ineq[i]+1, bmap->ineq[i]+1, gcd, total);
+		isl_int_fdiv_q(bmap->ineq[i][0], bmap->ineq[i][0], *gcd);
+		isl_seq_scale_down(bmap->ineq[i]+1, bmap->ineq[i]+1,
+				    *gcd, total);
 	}
-	isl_int_clear(gcd);
+	isl_ctx_scratch_release(ctx, gcd, 1);
 
 	return bmap;
 }
@@ -1699,8 +1704,37 @@ static struct isl_basic_map *remove_dependent_vars(struct isl_basic_map *bmap,
 	return bmap;
 }
 
+/* Return an array with the signs of the coefficients in column "col"
+ * of the inequality constraints of "bmap", with room for "extra"
+ * additional inequality constraints.
+ *
+ * The column is read once and the signs are then stored consecutively,
+ * rather than reading the column from the (scattered) rows of "bmap"
+ * for each pair of constraints that is considered.
+ */
+static int *column_signs(__isl_keep isl_basic_map *bmap, unsigned col,
+	unsigned extra)
+{
+	int i;
+	int *sgn;
+
+	sgn = isl_alloc_array(bmap->ctx, int, bmap->n_ineq + extra);
+	if (!sgn)
+		return NULL;
+	for (i = 0; i < bmap->n_ineq; ++i)
+		sgn[i] = isl_int_sgn(bmap->ineq[i][col]);
+
+	return sgn;
+}
+
 /* Eliminate the specified variables from the constraints using
  * Fourier-Motzkin.  The variables themselves are not removed.
+ *
+ * The signs of the coefficients of the variable that is being eliminated
+ * are kept in a separate array "sgn", which follows the permutations
+ * of the inequality constraints performed by
+ * isl_basic_map_drop_inequality.  The newly added constraints
+ * do not involve the variable.
  */
 struct isl_basic_map *isl_basic_map_eliminate_vars(
 	struct isl_basic_map *bmap, unsigned pos, unsigned n)
@@ -1709,6 +1743,7 @@ struct isl_basic_map *isl_basic_map_eliminate_vars(
 	int i, j, k;
 	unsigned total;
 	int need_gauss = 0;
+	int *sgn = NULL;
 
 	if (n == 0)
 		return bmap;
@@ -1751,17 +1786,19 @@ struct isl_basic_map *isl_basic_map_eliminate_vars(
 				0, n_lower * n_upper);
 		if (!bmap)
 			goto error;
+		sgn = column_signs(bmap, 1 + d, n_lower * n_upper);
+		if (bmap->n_ineq > 0 && !sgn)
+			goto error;
 		for (i = bmap->n_ineq - 1; i >= 0; --i) {
 			int last;
-			if (isl_int_is_zero(bmap->ineq[i][1+d]))
+			if (sgn[i] == 0)
 				continue;
 			last = -1;
 			for (j = 0; j < i; ++j) {
-				if (isl_int_is_zero(bmap->ineq[j][1+d]))
+				if (sgn[j] == 0)
 					continue;
 				last = j;
-				if (isl_int_sgn(bmap->ineq[i][1+d]) ==
-				    isl_int_sgn(bmap->ineq[j][1+d]))
+				if (sgn[i] == sgn[j])
 					continue;
 				k = isl_basic_map_alloc_inequality(bmap);
 				if (k < 0)
@@ -1770,10 +1807,14 @@ struct isl_basic_map *isl_basic_map_eliminate_vars(
 						1+total);
 				isl_seq_elim(bmap->ineq[k], bmap->ineq[j],
 						1+d, 1+total, NULL);
+				sgn[k] = 0;
 			}
+			sgn[i] = sgn[bmap->n_ineq - 1];
 			isl_basic_map_drop_inequality(bmap, i);
 			i = last + 1;
 		}
+		free(sgn);
+		sgn = NULL;
 		if (n_lower > 0 && n_upper > 0) {
 			bmap = isl_basic_map_normalize_constraints(bmap);
 			bmap = isl_basic_map_remove_duplicate_constraints(bmap,
@@ -1792,6 +1833,7 @@ struct isl_basic_map *isl_basic_map_eliminate_vars(
 		bmap = isl_basic_map_gauss(bmap, NULL);
 	return bmap;
 error:
+	free(sgn);
 	isl_basic_map_free(bmap);
 	return NULL;
 }
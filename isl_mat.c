@@ -35,8 +35,8 @@ uint32_t isl_mat_get_hash(__isl_keep isl_mat *mat)
 		return 0;
 
 	hash = isl_hash_init();
-	isl_hash_byte(hash, mat->n_row & 0xFF);
-	isl_hash_byte(hash, mat->n_col & 0xFF);
+	isl_hash_word(hash, mat->n_row);
+	isl_hash_word(hash, mat->n_col);
 	for (i = 0; i < mat->n_row; ++i) {
 		uint32_t row_hash;
 
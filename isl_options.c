@@ -55,6 +55,22 @@ static struct isl_arg_choice isl_schedule_algorithm_choice[] = {
 	{0}
 };
 
+static struct isl_arg_choice pip_split[] = {
+	{"redundant",	ISL_PIP_SPLIT_REDUNDANT},
+	{"divs",	ISL_PIP_SPLIT_DIVS},
+	{"constrained",	ISL_PIP_SPLIT_CONSTRAINED},
+	{"lookahead",	ISL_PIP_SPLIT_LOOKAHEAD},
+	{0}
+};
+
+static struct isl_arg_choice tab_pricing[] = {
+	{"bland",		ISL_TAB_PRICING_BLAND},
+	{"devex",		ISL_TAB_PRICING_DEVEX},
+	{"steepest-edge",	ISL_TAB_PRICING_STEEPEST_EDGE},
+	{"random",		ISL_TAB_PRICING_RANDOM},
+	{0}
+};
+
 static struct isl_arg_flags bernstein_recurse[] = {
 	{"none",	ISL_BERNSTEIN_FACTORS | ISL_BERNSTEIN_INTERVALS, 0},
 	{"factors",	ISL_BERNSTEIN_FACTORS | ISL_BERNSTEIN_INTERVALS,
@@ -119,6 +135,35 @@ ISL_ARG_CHOICE(struct isl_options, closure, 0, "closure", \
 	"closure operation to use")
 ISL_ARG_BOOL(struct isl_options, gbr_only_first, 0, "gbr-only-first", 0,
 	"only perform basis reduction in first direction")
+ISL_ARG_BOOL(struct isl_options, gbr_warm_start, 0, "gbr-warm-start", 0,
+	"start integer sampling from the most recently computed reduced basis")
+ISL_ARG_INT(struct isl_options, sample_threads, 0, "sample-threads",
+	"number", 0, "number of threads used for looking for integer points "
+	"in bounded sets (0 or 1 means a sequential search)")
+ISL_ARG_INT(struct isl_options, sample_cut_rounds, 0, "sample-cut-rounds",
+	"number", 0, "number of rounds of Chvatal-Gomory cuts to add "
+	"before looking for integer points in bounded sets")
+ISL_ARG_INT(struct isl_options, pip_threads, 0, "pip-threads",
+	"number", 0, "number of threads used for exploring parts of the "
+	"context in parametric integer programming (0 or 1 means "
+	"a sequential exploration)")
+ISL_ARG_CHOICE(struct isl_options, pip_split, 0, "pip-split",
+	pip_split, ISL_PIP_SPLIT_REDUNDANT,
+	"heuristic for selecting the row on which to split the context "
+	"in parametric integer programming")
+ISL_ARG_CHOICE(struct isl_options, tab_pricing, 0, "tab-pricing",
+	tab_pricing, ISL_TAB_PRICING_BLAND,
+	"pricing rule for selecting the entering column of a primal pivot")
+ISL_ARG_BOOL(struct isl_options, tab_float_filter, 0, "tab-float-filter", 0,
+	"look for an optimal basis in floating point before "
+	"solving an LP exactly")
+ISL_ARG_BOOL(struct isl_options, tab_presolve, 0, "tab-presolve", 0,
+	"remove fixed variables and redundant constraints from "
+	"lexmin and ILP problems before solving them")
+ISL_ARG_INT(struct isl_options, tab_sparse_density, 0, "tab-sparse-density",
+	"percentage", 25, "update the tableau in a sparse way during a pivot "
+	"if the percentage of non-zero entries in the pivot row is smaller "
+	"than this value")
 ISL_ARG_CHOICE(struct isl_options, bound, 0, "bound", bound,
 	ISL_BOUND_BERNSTEIN, "algorithm to use for computing bounds")
 ISL_ARG_CHOICE(struct isl_options, on_error, 0, "on-error", on_error,
@@ -214,6 +259,13 @@ ISL_ARG_BOOL(struct isl_options, print_stats, 0, "print-stats", 0,
 	"print statistics for every isl_ctx")
 ISL_ARG_ULONG(struct isl_options, max_operations, 0,
 	"max-operations", 0, "default number of maximal operations per isl_ctx")
+ISL_ARG_ULONG(struct isl_options, block_cache_size, 0,
+	"block-cache-size", 65536,
+	"default maximal number of cached integers per isl_ctx")
+ISL_ARG_ULONG(struct isl_options, basic_map_cache_size, 0,
+	"basic-map-cache-size", 0,
+	"default maximal number of cached emptiness and subset test results "
+	"on basic maps per isl_ctx")
 ISL_ARG_VERSION(print_version)
 ISL_ARGS_END
 
@@ -234,6 +286,26 @@ ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	pip_symmetry)
 
+ISL_CTX_SET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	tab_pricing)
+ISL_CTX_GET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	tab_pricing)
+
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	tab_float_filter)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	tab_float_filter)
+
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	tab_presolve)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	tab_presolve)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	tab_sparse_density)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	tab_sparse_density)
+
 ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	coalesce_bounded_wrapping)
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
@@ -244,6 +316,31 @@ ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	gbr_only_first)
 
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	gbr_warm_start)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	gbr_warm_start)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	sample_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	sample_threads)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	sample_cut_rounds)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	sample_cut_rounds)
+
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	pip_threads)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	pip_threads)
+
+ISL_CTX_SET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	pip_split)
+ISL_CTX_GET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	pip_split)
+
 ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
 	schedule_max_coefficient)
 ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
@@ -13,6 +13,16 @@ struct isl_options {
 	#define			ISL_GBR_ALWAYS	2
 	unsigned		gbr;
 	unsigned		gbr_only_first;
+	int			gbr_warm_start;
+	int			sample_threads;
+	int			sample_cut_rounds;
+	int			pip_threads;
+	unsigned		pip_split;
+
+	unsigned		tab_pricing;
+	int			tab_float_filter;
+	int			tab_presolve;
+	int			tab_sparse_density;
 
 	#define			ISL_CLOSURE_ISL		0
 	#define			ISL_CLOSURE_BOX		1
@@ -67,6 +77,8 @@ struct isl_options {
 
 	int			print_stats;
 	unsigned long		max_operations;
+	unsigned long		block_cache_size;
+	unsigned long		basic_map_cache_size;
 };
 
 #endif
@@ -0,0 +1,627 @@
+/*
+ * Copyright 2016      Sven Verdoolaege
+ *
+ * Use of this software is governed by the MIT license
+ *
+ * Written by Sven Verdoolaege
+ */
+
+#include <isl_ctx_private.h>
+#include <isl_map_private.h>
+#include <isl_mat_private.h>
+#include <isl_vec_private.h>
+#include <isl_seq.h>
+#include <isl_presolve.h>
+
+/* Internal data structure for isl_basic_set_presolve.
+ *
+ * "bset" is the (modified) copy of the input.
+ * "total" is the number of variables of "bset".
+ * "non_neg" is set if all variables are known to be non-negative.
+ * "eliminate" is set if fixed variables may be eliminated.
+ * "fixed" marks the variables that have been fixed,
+ * "val" contains their values and "n_fixed" is their number.
+ * "drop_eq" and "drop_ineq" mark the constraints that have been removed.
+ * "empty" is set if "bset" has been found to be empty.
+ * "progress" is set if anything changed during the current round.
+ * "changed" is set if anything changed at all.
+ */
+struct isl_presolve_data {
+	isl_basic_set *bset;
+	unsigned total;
+	int non_neg;
+	int eliminate;
+	int *fixed;
+	isl_vec *val;
+	int n_fixed;
+	int *drop_eq;
+	int *drop_ineq;
+	int empty;
+	int progress;
+	int changed;
+};
+
+/* Record that "data->bset" is empty, provided fixed variables
+ * may be eliminated.
+ * Otherwise, the caller is only allowed to drop redundant constraints
+ * and the constraint that proves the emptiness is simply kept.
+ */
+static void mark_empty(struct isl_presolve_data *data)
+{
+	if (data->eliminate)
+		data->empty = 1;
+}
+
+/* Remove equality constraint "k".
+ */
+static void drop_eq(struct isl_presolve_data *data, int k)
+{
+	data->drop_eq[k] = 1;
+	data->progress = 1;
+}
+
+/* Remove inequality constraint "k".
+ */
+static void drop_ineq(struct isl_presolve_data *data, int k)
+{
+	data->drop_ineq[k] = 1;
+	data->progress = 1;
+}
+
+/* Fix variable "pos" to "v" and plug in this value
+ * in all remaining constraints.
+ */
+static void fix_var(struct isl_presolve_data *data, int pos, isl_int v)
+{
+	int i;
+	isl_basic_set *bset = data->bset;
+
+	data->fixed[pos] = 1;
+	data->n_fixed++;
+	isl_int_set(data->val->el[pos], v);
+	for (i = 0; i < bset->n_eq; ++i) {
+		if (data->drop_eq[i])
+			continue;
+		isl_int_addmul(bset->eq[i][0], bset->eq[i][1 + pos], v);
+		isl_int_set_si(bset->eq[i][1 + pos], 0);
+	}
+	for (i = 0; i < bset->n_ineq; ++i) {
+		if (data->drop_ineq[i])
+			continue;
+		isl_int_addmul(bset->ineq[i][0], bset->ineq[i][1 + pos], v);
+		isl_int_set_si(bset->ineq[i][1 + pos], 0);
+	}
+	bset->ctx->stats->presolve_fixed_vars++;
+	data->progress = 1;
+}
+
+/* Can the equality a x + c = 0 in "row", with "pos" the position of x,
+ * be used to fix x?
+ * The value of x needs to be integral for it to be representable
+ * in the transformation matrix and it needs to be non-negative
+ * if the variables are known to be non-negative.
+ * In the latter case, the set is marked empty instead.
+ */
+static int can_fix(struct isl_presolve_data *data, isl_int *row, int pos)
+{
+	if (!data->eliminate)
+		return 0;
+	if (!isl_int_is_divisible_by(row[0], row[1 + pos]))
+		return 0;
+	if (data->non_neg &&
+	    isl_int_sgn(row[0]) == isl_int_sgn(row[1 + pos])) {
+		mark_empty(data);
+		return 0;
+	}
+	return 1;
+}
+
+/* Fix the variable at position "pos" according to the equality
+ * a x + c = 0 in "row".  The caller has already removed "row"
+ * from the set of remaining constraints.
+ */
+static void fix_from_row(struct isl_presolve_data *data, isl_int *row,
+	int pos)
+{
+	isl_int v;
+
+	isl_int_init(v);
+	isl_int_divexact(v, row[0], row[1 + pos]);
+	isl_int_neg(v, v);
+	fix_var(data, pos, v);
+	isl_int_clear(v);
+}
+
+/* Is "row" a singleton constraint on the variable at position "pos",
+ * the first variable with a non-zero coefficient?
+ */
+static int is_singleton(struct isl_presolve_data *data, isl_int *row, int pos)
+{
+	return isl_seq_first_non_zero(row + 1 + pos + 1,
+					data->total - pos - 1) == -1;
+}
+
+/* Presolve equality constraint "k".
+ *
+ * An equality that does not involve any variables is either
+ * trivially satisfied or shows that the set is empty.
+ * An equality that only involves a single variable fixes
+ * the value of this variable.
+ */
+static void presolve_eq(struct isl_presolve_data *data, int k)
+{
+	int pos;
+	isl_int *eq = data->bset->eq[k];
+
+	pos = isl_seq_first_non_zero(eq + 1, data->total);
+	if (pos < 0) {
+		if (!isl_int_is_zero(eq[0])) {
+			mark_empty(data);
+			return;
+		}
+		drop_eq(data, k);
+		data->bset->ctx->stats->presolve_trivial_rows++;
+		return;
+	}
+	if (!is_singleton(data, eq, pos) || !can_fix(data, eq, pos))
+		return;
+	drop_eq(data, k);
+	data->bset->ctx->stats->presolve_singleton_rows++;
+	fix_from_row(data, eq, pos);
+}
+
+/* Presolve inequality constraint "k".
+ *
+ * An inequality that does not involve any variables is either
+ * trivially satisfied or shows that the set is empty.
+ * If the variables are known to be non-negative, then a lower bound
+ * a x + c >= 0 with c >= 0 is redundant, while an upper bound
+ * -a x + c >= 0 (with a > 0) shows that the set is empty if c < 0
+ * and fixes x to zero if c = 0.
+ */
+static void presolve_ineq(struct isl_presolve_data *data, int k)
+{
+	int pos;
+	isl_int *ineq = data->bset->ineq[k];
+	isl_ctx *ctx = data->bset->ctx;
+
+	pos = isl_seq_first_non_zero(ineq + 1, data->total);
+	if (pos < 0) {
+		if (isl_int_is_neg(ineq[0])) {
+			mark_empty(data);
+			return;
+		}
+		drop_ineq(data, k);
+		ctx->stats->presolve_trivial_rows++;
+		return;
+	}
+	if (!data->non_neg || !is_singleton(data, ineq, pos))
+		return;
+	if (isl_int_is_pos(ineq[1 + pos])) {
+		if (isl_int_is_neg(ineq[0]))
+			return;
+		drop_ineq(data, k);
+		ctx->stats->presolve_singleton_rows++;
+		return;
+	}
+	if (isl_int_is_pos(ineq[0]))
+		return;
+	if (isl_int_is_neg(ineq[0])) {
+		mark_empty(data);
+		return;
+	}
+	if (!data->eliminate)
+		return;
+	drop_ineq(data, k);
+	ctx->stats->presolve_singleton_rows++;
+	fix_var(data, pos, ctx->zero);
+}
+
+/* Hash table of the remaining inequalities of "bset",
+ * hashed on their coefficients, excepting the constant term.
+ * "index" contains one more than the positions of the inequalities,
+ * or zero for an unused entry.
+ * "size" is a power of two and "bits" is its logarithm.
+ */
+struct isl_presolve_index {
+	unsigned size;
+	int bits;
+	int *index;
+};
+
+/* Return the position in ci->index that contains an inequality
+ * other than "row" with the same coefficients as "row" (not counting
+ * the constant term) or the position where such an inequality
+ * should be inserted if there is no such inequality.
+ */
+static int hash_index(struct isl_presolve_index *ci,
+	struct isl_presolve_data *data, isl_int *row)
+{
+	int h;
+	isl_int **ineq = data->bset->ineq;
+	uint32_t hash = isl_seq_get_hash_bits(row + 1, data->total, ci->bits);
+
+	for (h = hash; ci->index[h]; h = (h + 1) % ci->size) {
+		isl_int *other = ineq[ci->index[h] - 1];
+		if (other != row &&
+		    isl_seq_eq(row + 1, other + 1, data->total))
+			break;
+	}
+	return h;
+}
+
+/* Divide inequality "k" by the greatest common divisor
+ * of all its coefficients, including the constant term,
+ * such that parallel constraints are more likely to have
+ * identical coefficients.
+ * The constant term is not rounded since "bset" may be
+ * used to solve a linear program over the rationals.
+ */
+static void normalize_ineq(struct isl_presolve_data *data, int k, isl_int *g)
+{
+	isl_int *ineq = data->bset->ineq[k];
+
+	isl_seq_gcd(ineq, 1 + data->total, g);
+	if (isl_int_is_zero(*g) || isl_int_is_one(*g))
+		return;
+	isl_seq_scale_down(ineq, ineq, *g, 1 + data->total);
+}
+
+/* Look for a pair of opposite inequalities a x + c >= 0 and
+ * -a x - c' >= 0, using the hash table "ci" of remaining inequalities.
+ * If c < c', then the set is empty.
+ * If c = c' and x is a single variable, then x is fixed by the pair.
+ * Since fixing a variable modifies the constraints and therefore
+ * invalidates "ci", at most one variable is fixed.
+ */
+static void detect_opposite(struct isl_presolve_data *data,
+	struct isl_presolve_index *ci)
+{
+	int k, l, h, pos;
+	isl_basic_set *bset = data->bset;
+	isl_int sum;
+
+	isl_int_init(sum);
+	for (k = 0; k < bset->n_ineq && !data->empty; ++k) {
+		isl_int *ineq = bset->ineq[k];
+
+		if (data->drop_ineq[k])
+			continue;
+		isl_seq_neg(ineq + 1, ineq + 1, data->total);
+		h = hash_index(ci, data, ineq);
+		isl_seq_neg(ineq + 1, ineq + 1, data->total);
+		if (!ci->index[h])
+			continue;
+		l = ci->index[h] - 1;
+		isl_int_add(sum, ineq[0], bset->ineq[l][0]);
+		if (isl_int_is_pos(sum))
+			continue;
+		if (isl_int_is_neg(sum)) {
+			mark_empty(data);
+			continue;
+		}
+		pos = isl_seq_first_non_zero(ineq + 1, data->total);
+		if (pos < 0 || !is_singleton(data, ineq, pos) ||
+		    !can_fix(data, ineq, pos))
+			continue;
+		drop_ineq(data, k);
+		drop_ineq(data, l);
+		bset->ctx->stats->presolve_singleton_rows += 2;
+		fix_from_row(data, ineq, pos);
+		break;
+	}
+	isl_int_clear(sum);
+}
+
+/* Remove the remaining inequalities that are parallel
+ * to another remaining inequality and implied by it.
+ * That is, of two inequalities that only differ in their constant term,
+ * the one with the larger constant term is removed.
+ * If the constant terms are also the same, then the inequalities
+ * are duplicates.
+ * Afterwards, look for opposite inequalities.
+ */
+static isl_stat remove_parallel(struct isl_presolve_data *data)
+{
+	int k, l, h;
+	isl_basic_set *bset = data->bset;
+	struct isl_presolve_index ci;
+	isl_int g;
+
+	if (bset->n_ineq == 0)
+		return isl_stat_ok;
+
+	isl_int_init(g);
+	for (k = 0; k < bset->n_ineq; ++k)
+		if (!data->drop_ineq[k])
+			normalize_ineq(data, k, &g);
+	isl_int_clear(g);
+
+	ci.bits = 0;
+	for (ci.size = 1; ci.size < 4 * (bset->n_ineq + 1) / 3; ci.size <<= 1)
+		ci.bits++;
+	ci.index = isl_calloc_array(bset->ctx, int, ci.size);
+	if (!ci.index)
+		return isl_stat_error;
+
+	for (k = 0; k < bset->n_ineq; ++k) {
+		if (data->drop_ineq[k])
+			continue;
+		h = hash_index(&ci, data, bset->ineq[k]);
+		if (!ci.index[h]) {
+			ci.index[h] = 1 + k;
+			continue;
+		}
+		l = ci.index[h] - 1;
+		if (isl_int_eq(bset->ineq[k][0], bset->ineq[l][0])) {
+			bset->ctx->stats->presolve_duplicate_rows++;
+			drop_ineq(data, k);
+			continue;
+		}
+		bset->ctx->stats->presolve_dominated_rows++;
+		if (isl_int_lt(bset->ineq[k][0], bset->ineq[l][0])) {
+			drop_ineq(data, l);
+			ci.index[h] = 1 + k;
+		} else
+			drop_ineq(data, k);
+	}
+
+	detect_opposite(data, &ci);
+
+	free(ci.index);
+	return isl_stat_ok;
+}
+
+/* Return an array mapping each constraint of "bset" to itself,
+ * with the equalities numbered before the inequalities.
+ */
+static int *identity_row_map(__isl_keep isl_basic_set *bset)
+{
+	int i;
+	int n = bset->n_eq + bset->n_ineq;
+	int *row_map;
+
+	row_map = isl_alloc_array(bset->ctx, int, n);
+	if (n && !row_map)
+		return NULL;
+	for (i = 0; i < n; ++i)
+		row_map[i] = i;
+	return row_map;
+}
+
+/* Return "bset" itself, along with the identity transformation
+ * and the identity row map, if requested.
+ */
+static __isl_give isl_basic_set *unchanged(__isl_take isl_basic_set *bset,
+	__isl_give isl_mat **T, int **row_map)
+{
+	if (!bset)
+		return NULL;
+	if (T) {
+		*T = isl_mat_identity(bset->ctx,
+					1 + isl_basic_set_total_dim(bset));
+		if (!*T)
+			return isl_basic_set_free(bset);
+	}
+	if (row_map) {
+		*row_map = identity_row_map(bset);
+		if (!*row_map)
+			return isl_basic_set_free(bset);
+	}
+	return bset;
+}
+
+/* Copy the constraint "src" of data->bset to "dst",
+ * skipping the coefficients of the fixed variables.
+ */
+static void copy_row(struct isl_presolve_data *data, isl_int *dst,
+	isl_int *src)
+{
+	int i, j;
+
+	isl_int_set(dst[0], src[0]);
+	for (i = 0, j = 0; i < data->total; ++i)
+		if (!data->fixed[i])
+			isl_int_set(dst[1 + j++], src[1 + i]);
+}
+
+/* Construct the transformation matrix that maps the remaining variables
+ * back to all variables of data->bset.
+ */
+static __isl_give isl_mat *extract_transformation(
+	struct isl_presolve_data *data)
+{
+	int i, j;
+	isl_ctx *ctx = data->bset->ctx;
+	isl_mat *T;
+
+	T = isl_mat_alloc(ctx, 1 + data->total,
+				1 + data->total - data->n_fixed);
+	if (!T)
+		return NULL;
+	isl_seq_clr(T->row[0], T->n_col);
+	isl_int_set_si(T->row[0][0], 1);
+	for (i = 0, j = 0; i < data->total; ++i) {
+		isl_seq_clr(T->row[1 + i], T->n_col);
+		if (data->fixed[i])
+			isl_int_set(T->row[1 + i][0], data->val->el[i]);
+		else
+			isl_int_set_si(T->row[1 + i][1 + j++], 1);
+	}
+
+	return T;
+}
+
+/* Construct the result of isl_basic_set_presolve from "data",
+ * i.e., the remaining constraints over the remaining variables,
+ * and, if requested, the transformation matrix and the row map.
+ * The space of the result is only kept if no variables were eliminated.
+ */
+static __isl_give isl_basic_set *extract(struct isl_presolve_data *data,
+	__isl_give isl_mat **T, int **row_map)
+{
+	int i, k, n;
+	int n_eq = 0, n_ineq = 0;
+	isl_basic_set *bset = data->bset;
+	isl_basic_set *res;
+
+	for (i = 0; i < bset->n_eq; ++i)
+		if (!data->drop_eq[i])
+			n_eq++;
+	for (i = 0; i < bset->n_ineq; ++i)
+		if (!data->drop_ineq[i])
+			n_ineq++;
+
+	if (data->n_fixed == 0)
+		res = isl_basic_set_alloc_space(isl_basic_set_get_space(bset),
+						0, n_eq, n_ineq);
+	else
+		res = isl_basic_set_alloc(bset->ctx, 0,
+				data->total - data->n_fixed, 0, n_eq, n_ineq);
+	if (row_map) {
+		*row_map = isl_alloc_array(bset->ctx, int, n_eq + n_ineq);
+		if (n_eq + n_ineq && !*row_map)
+			goto error;
+	}
+	if (!res)
+		goto error;
+	if (ISL_F_ISSET(bset, ISL_BASIC_SET_RATIONAL))
+		ISL_F_SET(res, ISL_BASIC_SET_RATIONAL);
+
+	n = 0;
+	for (i = 0; i < bset->n_eq; ++i) {
+		if (data->drop_eq[i])
+			continue;
+		k = isl_basic_set_alloc_equality(res);
+		if (k < 0)
+			goto error;
+		copy_row(data, res->eq[k], bset->eq[i]);
+		if (row_map)
+			(*row_map)[n++] = i;
+	}
+	for (i = 0; i < bset->n_ineq; ++i) {
+		if (data->drop_ineq[i])
+			continue;
+		k = isl_basic_set_alloc_inequality(res);
+		if (k < 0)
+			goto error;
+		copy_row(data, res->ineq[k], bset->ineq[i]);
+		if (row_map)
+			(*row_map)[n++] = bset->n_eq + i;
+	}
+
+	if (T) {
+		*T = extract_transformation(data);
+		if (!*T)
+			goto error;
+	}
+
+	return isl_basic_set_finalize(res);
+error:
+	if (row_map) {
+		free(*row_map);
+		*row_map = NULL;
+	}
+	isl_basic_set_free(res);
+	return NULL;
+}
+
+/* Presolve the (integer or rational) linear program with constraints
+ * "bset" by removing constraints that are implied by other constraints
+ * in an obvious way and, if "T" is not NULL, by eliminating
+ * variables that have a fixed value.
+ * If "non_neg" is set, then all variables are assumed to be non-negative.
+ * The result is exact, in the sense that no constraints are tightened
+ * based on the integrality of the variables.
+ *
+ * If "T" is not NULL, then *T is set to a matrix mapping
+ * the homogeneous coordinates of a point in the result to
+ * those of the corresponding point in "bset".
+ * If no variables are eliminated, then the result lives in the same
+ * space as "bset".  Otherwise, it lives in an anonymous set space.
+ * If "T" is NULL, then the variables are kept and constraints
+ * are only removed if they are redundant.  In particular, constraints
+ * that show that "bset" is empty are not removed.
+ *
+ * If "row_map" is not NULL, then *row_map is set to an array mapping
+ * each constraint of the result to the position of the constraint
+ * of "bset" it was derived from, where the equalities are numbered
+ * before the inequalities.
+ *
+ * The numbers of removed variables and constraints are kept track of
+ * in the statistics of the isl_ctx.
+ *
+ * Basic sets with local variables are returned unchanged.
+ */
+__isl_give isl_basic_set *isl_basic_set_presolve(
+	__isl_take isl_basic_set *bset, int non_neg,
+	__isl_give isl_mat **T, int **row_map)
+{
+	int k;
+	isl_ctx *ctx;
+	struct isl_presolve_data data = { NULL };
+
+	if (T)
+		*T = NULL;
+	if (row_map)
+		*row_map = NULL;
+	if (!bset)
+		return NULL;
+	if (bset->n_div > 0 || ISL_F_ISSET(bset, ISL_BASIC_SET_EMPTY))
+		return unchanged(bset, T, row_map);
+
+	bset = isl_basic_set_cow(bset);
+	if (!bset)
+		return NULL;
+	ctx = bset->ctx;
+	data.bset = bset;
+	data.total = isl_basic_set_total_dim(bset);
+	data.non_neg = non_neg;
+	data.eliminate = T != NULL;
+	data.fixed = isl_calloc_array(ctx, int, data.total);
+	data.val = isl_vec_alloc(ctx, data.total);
+	data.drop_eq = isl_calloc_array(ctx, int, bset->n_eq);
+	data.drop_ineq = isl_calloc_array(ctx, int, bset->n_ineq);
+	if ((data.total && !data.fixed) || !data.val ||
+	    (bset->n_eq && !data.drop_eq) || (bset->n_ineq && !data.drop_ineq))
+		goto error;
+
+	do {
+		data.progress = 0;
+		for (k = 0; k < bset->n_eq && !data.empty; ++k)
+			if (!data.drop_eq[k])
+				presolve_eq(&data, k);
+		for (k = 0; k < bset->n_ineq && !data.empty; ++k)
+			if (!data.drop_ineq[k])
+				presolve_ineq(&data, k);
+		if (!data.empty && remove_parallel(&data) < 0)
+			goto error;
+		if (data.progress)
+			data.changed = 1;
+	} while (data.progress && !data.empty);
+
+	if (data.empty)
+		bset = unchanged(isl_basic_set_set_to_empty(bset), T, row_map);
+	else if (!data.changed)
+		bset = unchanged(bset, T, row_map);
+	else {
+		isl_basic_set *res;
+
+		res = extract(&data, T, row_map);
+		isl_basic_set_free(bset);
+		bset = res;
+	}
+
+	free(data.fixed);
+	isl_vec_free(data.val);
+	free(data.drop_eq);
+	free(data.drop_ineq);
+	return bset;
+error:
+	free(data.fixed);
+	isl_vec_free(data.val);
+	free(data.drop_eq);
+	free(data.drop_ineq);
+	isl_basic_set_free(bset);
+	return NULL;
+}
@@ -0,0 +1,19 @@
+#ifndef ISL_PRESOLVE_H
+#define ISL_PRESOLVE_H
+
+#include <isl/set.h>
+#include <isl/mat.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+__isl_give isl_basic_set *isl_basic_set_presolve(
+	__isl_take isl_basic_set *bset, int non_neg,
+	__isl_give isl_mat **T, int **row_map);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -7,6 +7,10 @@
  * Computerwetenschappen, Celestijnenlaan 200A, B-3001 Leuven, Belgium
  */
 
+#include <isl_config.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 #include <isl_ctx_private.h>
 #include <isl_map_private.h>
 #include "isl_sample.h"
@@ -591,15 +595,604 @@ error:
 	return NULL;
 }
 
+/* Is the bounded tableau "tab" full-dimensional?
+ */
+static int tab_is_full_dimensional(struct isl_tab *tab)
+{
+	return tab->n_var - tab->n_col + tab->n_dead == 0;
+}
+
+/* Does "bset" have all the inequality constraints in "ineq",
+ * possibly with a smaller constant term?
+ * That is, is "bset" obtained from the set described by "ineq"
+ * by adding constraints or by tightening some of the constraints?
+ */
+static int is_refinement(__isl_keep isl_mat *ineq,
+	__isl_keep isl_basic_set *bset)
+{
+	int i, j;
+	unsigned total;
+
+	total = isl_basic_set_total_dim(bset);
+	if (ineq->n_col != 1 + total || ineq->n_row > bset->n_ineq)
+		return 0;
+
+	for (i = 0; i < ineq->n_row; ++i) {
+		for (j = 0; j < bset->n_ineq; ++j)
+			if (isl_seq_eq(ineq->row[i] + 1, bset->ineq[j] + 1,
+					total) &&
+			    isl_int_le(bset->ineq[j][0], ineq->row[i][0]))
+				break;
+		if (j >= bset->n_ineq)
+			return 0;
+	}
+
+	return 1;
+}
+
+/* If the gbr-warm-start option is set and if a reduced basis
+ * was kept by a previous call to sample_bounded on a set
+ * of which "bset" is a refinement, then use it as initial basis
+ * for the full-dimensional tableau "tab" of "bset".
+ * A tableau that is not full-dimensional needs an initial basis
+ * that starts with its equalities, so it is not warm started.
+ * Any affine unimodular basis can serve as initial basis and
+ * the basis of a set that only differs in a few extra constraints
+ * is usually closer to a reduced basis than the identity matrix.
+ * Since the full-dimensional tableau does not have any equalities,
+ * there are no directions with a known fixed value.
+ */
+static isl_stat warm_start_basis(struct isl_tab *tab,
+	__isl_keep isl_basic_set *bset)
+{
+	isl_ctx *ctx = tab->mat->ctx;
+
+	if (!ctx->opt->gbr_warm_start || !ctx->gbr_basis)
+		return isl_stat_ok;
+	if (!is_refinement(ctx->gbr_ineq, bset))
+		return isl_stat_ok;
+
+	tab->basis = isl_mat_dup(ctx->gbr_basis);
+	if (!tab->basis)
+		return isl_stat_error;
+	tab->n_zero = 0;
+	tab->n_unbounded = 0;
+	ctx->stats->gbr_warm_starts++;
+
+	return isl_stat_ok;
+}
+
+/* If the gbr-warm-start option is set, then keep track
+ * of the basis computed by isl_tab_sample for the full-dimensional
+ * tableau "tab" of "bset", along with the inequality constraints
+ * of "bset", such that the basis can be used as initial basis
+ * by a subsequent call to sample_bounded on a refinement of "bset".
+ * Note that "tab" is no longer full-dimensional after isl_tab_sample
+ * since the values of the basis directions have been fixed.
+ * The tableau is about to be freed, so its basis can simply be taken.
+ */
+static isl_stat keep_basis(struct isl_tab *tab,
+	__isl_keep isl_basic_set *bset)
+{
+	isl_ctx *ctx = tab->mat->ctx;
+	isl_mat *ineq;
+
+	if (!ctx->opt->gbr_warm_start || !tab->basis)
+		return isl_stat_ok;
+
+	ineq = isl_mat_sub_alloc6(ctx, bset->ineq, 0, bset->n_ineq,
+				0, 1 + isl_basic_set_total_dim(bset));
+	isl_mat_free(ctx->gbr_ineq);
+	ctx->gbr_ineq = isl_mat_dup(ineq);
+	isl_mat_free(ineq);
+	isl_mat_free(ctx->gbr_basis);
+	ctx->gbr_basis = tab->basis;
+	tab->basis = NULL;
+	if (!ctx->gbr_ineq)
+		ctx->gbr_basis = isl_mat_free(ctx->gbr_basis);
+
+	return ctx->gbr_ineq ? isl_stat_ok : isl_stat_error;
+}
+
+/* Construct a Chvatal-Gomory cut from the row of the variable "var"
+ * of "tab", which has a non-integral sample value, and store it
+ * in "cut", expressed in terms of the variables of "tab".
+ * Return 1 if a cut was constructed, 0 if no cut could be derived
+ * from the row.
+ *
+ * If the row is given by
+ *
+ *	m x = f + \sum_i a_i y_i
+ *
+ * then the cut is
+ *
+ *	- {-f/m} + \sum_i {a_i/m} y_i >= 0
+ *
+ * as in add_cut in isl_tab_pip.c.  This cut is only valid if
+ * each of the y_i with a non-integral coefficient a_i/m
+ * is non-negative and integral in every integer point.
+ * The latter holds for both the variables and the constraints
+ * since the tracked basic set "tab->bmap" only has integer coefficients.
+ * The dead columns are fixed to zero and can therefore be ignored.
+ * Since the constraints of "tab" are not necessarily non-negative
+ * combinations of the y_i in terms of the variables,
+ * the cut is expressed in terms of the variables by plugging in
+ * the inequalities of "tab->bmap", which correspond to
+ * the constraints of "tab" since "tab->bmap" has no equalities.
+ * The cut is then further strengthened by dividing out
+ * the greatest common divisor of the variable coefficients
+ * and rounding down the constant term.
+ */
+static int gomory_cut(struct isl_tab *tab, int var, isl_int *cut)
+{
+	int j;
+	int ok = 1;
+	unsigned dim = tab->n_var;
+	unsigned off = 2 + tab->M;
+	isl_ctx *ctx = tab->mat->ctx;
+	isl_int *row = tab->mat->row[tab->var[var].index];
+	isl_int f;
+
+	isl_int_init(f);
+	isl_seq_clr(cut, 1 + dim);
+	for (j = tab->n_dead; ok && j < tab->n_col; ++j) {
+		int col_var = tab->col_var[j];
+
+		isl_int_fdiv_r(f, row[off + j], row[0]);
+		if (isl_int_is_zero(f))
+			continue;
+		if (col_var >= 0) {
+			ok = tab->var[col_var].is_nonneg;
+			isl_int_add(cut[1 + col_var], cut[1 + col_var], f);
+		} else {
+			ok = tab->con[~col_var].is_nonneg;
+			isl_seq_combine(cut, ctx->one, cut,
+					f, tab->bmap->ineq[~col_var], 1 + dim);
+		}
+	}
+	if (ok) {
+		isl_int_neg(f, row[1]);
+		isl_int_fdiv_r(f, f, row[0]);
+		isl_int_sub(cut[0], cut[0], f);
+		isl_seq_gcd(cut + 1, dim, &f);
+		if (!isl_int_is_zero(f) && !isl_int_is_one(f)) {
+			isl_seq_scale_down(cut + 1, cut + 1, f, dim);
+			isl_int_fdiv_q(cut[0], cut[0], f);
+		}
+	}
+	isl_int_clear(f);
+
+	return ok;
+}
+
+/* Add rounds of Chvatal-Gomory cuts to "tab", as specified
+ * by the sample-cut-rounds option, in an attempt to find out
+ * whether "tab" contains any integer points without
+ * having to perform a branching search.
+ * In each round, a cut is constructed from the row of each variable
+ * with a non-integral sample value, if possible, and then
+ * all these cuts are added to "tab", moving the sample value
+ * to a vertex of the strengthened tableau.
+ * Return 1 if "tab" is known to be integer infeasible
+ * or if its sample value is integral after adding the cuts and
+ * 0 if a branching search still needs to be performed.
+ *
+ * The cuts are constructed in terms of the tracked basic set
+ * "tab->bmap", so no cuts are added if the constraints of "tab"
+ * cannot be mapped to the inequalities of this basic set.
+ */
+static int add_cuts(struct isl_tab *tab)
+{
+	int i, round;
+	int n, n_cut = 0;
+	int n_round;
+	int integral;
+	isl_ctx *ctx = tab->mat->ctx;
+	isl_mat *cuts;
+
+	n_round = ctx->opt->sample_cut_rounds;
+	if (n_round <= 0 || !tab->bmap || tab->bmap->n_eq != 0)
+		return 0;
+
+	cuts = isl_mat_alloc(ctx, tab->n_var, 1 + tab->n_var);
+	if (!cuts)
+		return -1;
+	for (round = 0; round < n_round && !tab->empty; ++round) {
+		integral = isl_tab_sample_is_integer(tab);
+		if (integral < 0)
+			goto error;
+		if (integral)
+			break;
+		n = 0;
+		for (i = 0; i < tab->n_var; ++i) {
+			isl_int *row;
+
+			if (!tab->var[i].is_row)
+				continue;
+			row = tab->mat->row[tab->var[i].index];
+			if (isl_int_is_divisible_by(row[1], row[0]))
+				continue;
+			if (gomory_cut(tab, i, cuts->row[n]))
+				n++;
+		}
+		if (n == 0)
+			break;
+		if (isl_tab_extend_cons(tab, n) < 0)
+			goto error;
+		for (i = 0; i < n && !tab->empty; ++i) {
+			if (isl_tab_add_ineq(tab, cuts->row[i]) < 0)
+				goto error;
+			ctx->stats->sample_cuts++;
+			n_cut++;
+		}
+	}
+	isl_mat_free(cuts);
+
+	integral = tab->empty || isl_tab_sample_is_integer(tab);
+	if (integral > 0 && n_cut > 0)
+		ctx->stats->sample_cut_searches_avoided++;
+	return integral;
+error:
+	isl_mat_free(cuts);
+	return -1;
+}
+
+#ifdef HAVE_PTHREAD_H
+
+/* Data shared by the threads of a parallel search for an integer point
+ * in "bset" (living in the isl_ctx of the calling thread).
+ *
+ * The values of "dir" (an affine expression without constant term)
+ * over "bset" range from "min" to "max".  This range is split
+ * into "n_chunk" chunks of (at most) "size" consecutive values.
+ * "next" is the next chunk that still needs to be handed out,
+ * "found" is the smallest chunk in which an integer point has been found
+ * so far (or "n_chunk" if none has been found) and
+ * "error" is set if any of the threads ran into an error.
+ * These three fields are protected by "mutex".
+ * "sample" holds the integer point found in each of the chunks,
+ * if any, allocated in the isl_ctx of the thread that found it.
+ */
+struct isl_sample_chunks {
+	isl_basic_set *bset;
+	isl_int *dir;
+	isl_int min;
+	isl_int max;
+	isl_int size;
+	int n_chunk;
+
+	pthread_mutex_t mutex;
+	int next;
+	int found;
+	int error;
+
+	isl_vec **sample;
+};
+
+/* A thread participating in a parallel search for an integer point,
+ * with its own isl_ctx "ctx", since isl objects cannot be shared
+ * between threads.
+ */
+struct isl_sample_worker {
+	pthread_t thread;
+	isl_ctx *ctx;
+	struct isl_sample_chunks *chunks;
+};
+
+/* Construct a copy of the basic set of "chunks" in "ctx",
+ * restricted to the values of the direction of "chunks"
+ * that belong to chunk "i".
+ * The basic set of "chunks" is only read, such that
+ * this function can be called from several threads at the same time.
+ */
+static __isl_give isl_basic_set *chunk_basic_set(isl_ctx *ctx,
+	struct isl_sample_chunks *chunks, int i)
+{
+	int j, k;
+	unsigned dim;
+	isl_basic_set *src = chunks->bset;
+	isl_basic_set *bset;
+
+	dim = isl_basic_set_total_dim(src);
+	bset = isl_basic_set_alloc(ctx, 0, dim, 0, 0, src->n_ineq + 2);
+	for (j = 0; j < src->n_ineq; ++j) {
+		k = isl_basic_set_alloc_inequality(bset);
+		if (k < 0)
+			return isl_basic_set_free(bset);
+		isl_seq_cpy(bset->ineq[k], src->ineq[j], 1 + dim);
+	}
+
+	k = isl_basic_set_alloc_inequality(bset);
+	if (k < 0)
+		return isl_basic_set_free(bset);
+	isl_seq_cpy(bset->ineq[k] + 1, chunks->dir + 1, dim);
+	isl_int_mul_ui(bset->ineq[k][0], chunks->size, i);
+	isl_int_add(bset->ineq[k][0], bset->ineq[k][0], chunks->min);
+	isl_int_neg(bset->ineq[k][0], bset->ineq[k][0]);
+
+	k = isl_basic_set_alloc_inequality(bset);
+	if (k < 0)
+		return isl_basic_set_free(bset);
+	isl_seq_neg(bset->ineq[k] + 1, chunks->dir + 1, dim);
+	isl_int_sub(bset->ineq[k][0], bset->ineq[k - 1][0], chunks->size);
+	isl_int_add_ui(bset->ineq[k][0], bset->ineq[k][0], 1);
+	isl_int_neg(bset->ineq[k][0], bset->ineq[k][0]);
+	if (isl_int_gt(bset->ineq[k][0], chunks->max))
+		isl_int_set(bset->ineq[k][0], chunks->max);
+
+	bset = isl_basic_set_simplify(bset);
+	return isl_basic_set_finalize(bset);
+}
+
+/* Repeatedly take the next chunk from the shared data and
+ * look for an integer point in that chunk, until all chunks
+ * have been handed out.
+ * Chunks beyond the smallest chunk in which an integer point
+ * has already been found are skipped since their result
+ * would not be used anyway.
+ * Each chunk is searched sequentially in the isl_ctx of the worker.
+ */
+static void *sample_worker(void *user)
+{
+	struct isl_sample_worker *worker = user;
+	struct isl_sample_chunks *chunks = worker->chunks;
+
+	for (;;) {
+		int i, skip;
+		isl_basic_set *bset;
+		isl_vec *sample;
+
+		pthread_mutex_lock(&chunks->mutex);
+		i = chunks->next++;
+		skip = chunks->error || i >= chunks->n_chunk ||
+			i > chunks->found;
+		pthread_mutex_unlock(&chunks->mutex);
+		if (skip)
+			break;
+
+		bset = chunk_basic_set(worker->ctx, chunks, i);
+		sample = isl_basic_set_sample_bounded(bset);
+
+		pthread_mutex_lock(&chunks->mutex);
+		if (!sample)
+			chunks->error = 1;
+		else if (sample->size > 0) {
+			chunks->sample[i] = sample;
+			if (i < chunks->found)
+				chunks->found = i;
+			sample = NULL;
+		}
+		pthread_mutex_unlock(&chunks->mutex);
+		isl_vec_free(sample);
+	}
+
+	return NULL;
+}
+
+/* Run "n_thread" workers on "chunks" and return a copy
+ * of the integer point found in the first chunk that contains any
+ * in "ctx", or a zero-length vector if none of the chunks
+ * contains an integer point.
+ * The workers are only allocated an isl_ctx of their own
+ * (inheriting all options and the operation quota of "ctx", but
+ * searching their chunks sequentially) and started here.
+ * The shared data is only read by the workers
+ * and "ctx" is not used until all workers have finished.
+ * The operations and statistics of the workers are then added
+ * to those of "ctx" and any error in a worker is reported
+ * in "ctx" with the error code of the first failing worker.
+ * If any of the workers fails to start, then the remaining chunks
+ * are handled by the workers that did start.
+ */
+static __isl_give isl_vec *run_workers(isl_ctx *ctx,
+	struct isl_sample_chunks *chunks, int n_thread)
+{
+	int i, n_started = 0;
+	enum isl_error error = isl_error_none;
+	struct isl_sample_worker *worker;
+	isl_vec *sample = NULL;
+
+	worker = isl_calloc_array(ctx, struct isl_sample_worker, n_thread);
+	if (!worker)
+		return NULL;
+
+	for (i = 0; i < n_thread; ++i) {
+		worker[i].chunks = chunks;
+		worker[i].ctx = isl_ctx_alloc_worker(ctx);
+		if (!worker[i].ctx)
+			break;
+		worker[i].ctx->opt->sample_threads = 0;
+		if (pthread_create(&worker[i].thread, NULL,
+				    &sample_worker, &worker[i]) != 0)
+			break;
+		n_started++;
+	}
+	if (n_started == 0)
+		isl_die(ctx, isl_error_unknown,
+			"unable to start any sampling thread", goto error);
+	for (i = 0; i < n_started; ++i) {
+		pthread_join(worker[i].thread, NULL);
+		isl_ctx_merge_worker(ctx, worker[i].ctx);
+		if (error == isl_error_none)
+			error = isl_ctx_last_error(worker[i].ctx);
+	}
+
+	if (chunks->error) {
+		if (error == isl_error_none)
+			error = isl_error_unknown;
+		isl_die(ctx, error, "error in sampling thread", goto error);
+	}
+	if (chunks->found < chunks->n_chunk) {
+		isl_vec *found = chunks->sample[chunks->found];
+		sample = isl_vec_alloc(ctx, found->size);
+		if (sample)
+			isl_seq_cpy(sample->el, found->el, found->size);
+	} else
+		sample = isl_vec_alloc(ctx, 0);
+
+error:
+	for (i = 0; i < chunks->n_chunk; ++i)
+		chunks->sample[i] = isl_vec_free(chunks->sample[i]);
+	for (i = 0; i < n_thread; ++i)
+		if (worker[i].ctx)
+			isl_ctx_free(worker[i].ctx);
+	free(worker);
+	return sample;
+}
+
+/* Look for an integer point in the basic set "bset", represented
+ * by the full-dimensional bounded tableau "tab", using
+ * the number of threads specified by the sample-threads option.
+ * If this option is set to at most one, or if a parallel search
+ * does not appear to be worthwhile, then *sample is left untouched
+ * and the caller is expected to perform a sequential search instead.
+ *
+ * The range of values of the first (reduced) basis direction
+ * over "tab" is split into a few chunks per thread and
+ * the chunks are searched by the threads in order of increasing
+ * values in this direction, each thread taking the next available
+ * chunk when it is done with its previous chunk.
+ * The integer point of the first non-empty chunk is returned,
+ * so the result does not depend on the scheduling of the threads,
+ * but it may be different from the integer point found
+ * by a sequential search.
+ * If "tab" turns out to be empty, if the first basis direction
+ * has a single integer value or if the rational sample is
+ * already integral, then there is no need for a parallel search.
+ */
+static isl_stat parallel_sample(struct isl_tab *tab,
+	__isl_keep isl_basic_set *bset, __isl_give isl_vec **sample)
+{
+	int n_thread;
+	int n_chunk;
+	unsigned dim = tab->n_var;
+	unsigned gbr_only_first;
+	isl_ctx *ctx = tab->mat->ctx;
+	enum isl_lp_result res;
+	struct isl_sample_chunks chunks;
+	isl_vec *min, *max;
+	isl_stat r = isl_stat_ok;
+
+	n_thread = ctx->opt->sample_threads;
+	if (n_thread <= 1 || tab->empty)
+		return isl_stat_ok;
+
+	if (!tab->basis)
+		tab->basis = initial_basis(tab);
+	if (!tab->basis)
+		return isl_stat_error;
+	if (isl_tab_extend_cons(tab, dim + 1) < 0)
+		return isl_stat_error;
+
+	min = isl_vec_alloc(ctx, 1);
+	max = isl_vec_alloc(ctx, 1);
+	if (!min || !max)
+		goto error;
+
+	res = compute_min(ctx, tab, min, 0);
+	if (res == isl_lp_empty)
+		goto done;
+	if (res == isl_lp_ok && isl_tab_sample_is_integer(tab))
+		goto done;
+	if (res == isl_lp_ok && ctx->opt->gbr != ISL_GBR_NEVER) {
+		tab->n_zero = 0;
+		gbr_only_first = ctx->opt->gbr_only_first;
+		ctx->opt->gbr_only_first = 1;
+		tab = isl_tab_compute_reduced_basis(tab);
+		ctx->opt->gbr_only_first = gbr_only_first;
+		if (!tab || !tab->basis)
+			goto error;
+		res = compute_min(ctx, tab, min, 0);
+	}
+	if (res == isl_lp_ok)
+		res = compute_max(ctx, tab, max, 0);
+	if (res == isl_lp_error)
+		goto error;
+	if (res != isl_lp_ok)
+		isl_die(ctx, isl_error_internal,
+			"expecting bounded rational solution", goto error);
+	if (!isl_int_lt(min->el[0], max->el[0]))
+		goto done;
+
+	isl_int_init(chunks.min);
+	isl_int_init(chunks.max);
+	isl_int_init(chunks.size);
+	isl_int_set(chunks.min, min->el[0]);
+	isl_int_set(chunks.max, max->el[0]);
+	isl_int_sub(chunks.size, max->el[0], min->el[0]);
+	isl_int_add_ui(chunks.size, chunks.size, 1);
+	if (isl_int_cmp_si(chunks.size, 4 * n_thread) < 0)
+		n_chunk = isl_int_get_si(chunks.size);
+	else
+		n_chunk = 4 * n_thread;
+	isl_int_set_si(max->el[0], n_chunk);
+	isl_int_cdiv_q(max->el[0], chunks.size, max->el[0]);
+	isl_int_cdiv_q(min->el[0], chunks.size, max->el[0]);
+	isl_int_set(chunks.size, max->el[0]);
+	chunks.n_chunk = isl_int_get_si(min->el[0]);
+	if (n_thread > chunks.n_chunk)
+		n_thread = chunks.n_chunk;
+
+	chunks.bset = bset;
+	chunks.dir = tab->basis->row[1];
+	chunks.next = 0;
+	chunks.found = chunks.n_chunk;
+	chunks.error = 0;
+	chunks.sample = isl_calloc_array(ctx, isl_vec *, chunks.n_chunk);
+	if (chunks.sample && pthread_mutex_init(&chunks.mutex, NULL) == 0) {
+		ctx->stats->sample_parallel_searches++;
+		*sample = run_workers(ctx, &chunks, n_thread);
+		pthread_mutex_destroy(&chunks.mutex);
+		if (!*sample)
+			r = isl_stat_error;
+	} else
+		r = isl_stat_error;
+	free(chunks.sample);
+	isl_int_clear(chunks.min);
+	isl_int_clear(chunks.max);
+	isl_int_clear(chunks.size);
+
+done:
+	isl_vec_free(min);
+	isl_vec_free(max);
+	return r;
+error:
+	isl_vec_free(min);
+	isl_vec_free(max);
+	return isl_stat_error;
+}
+
+#else
+
+/* Without thread support, a sequential search is always performed.
+ */
+static isl_stat parallel_sample(struct isl_tab *tab,
+	__isl_keep isl_basic_set *bset, __isl_give isl_vec **sample)
+{
+	return isl_stat_ok;
+}
+
+#endif
+
 /* Given a basic set that is known to be bounded, find and return
  * an integer point in the basic set, if there is any.
  *
  * After handling some trivial cases, we construct a tableau
  * and then use isl_tab_sample to find a sample, passing it
- * the identity matrix as initial basis.
+ * the identity matrix as initial basis, unless the basis
+ * of a previous call on a less constrained set can be reused
+ * in warm_start_basis.
+ * A full-dimensional tableau may instead be handed over
+ * to parallel_sample if the sample-threads option is set.
+ * If the sample-cut-rounds option is set, then cuts are first
+ * added to the tableau, which may make the search unnecessary.
+ * Any implicit equalities introduced by these cuts are detected
+ * before the search.
  */ 
 static struct isl_vec *sample_bounded(struct isl_basic_set *bset)
 {
+	int full;
+	int resolved;
 	unsigned dim;
 	struct isl_vec *sample;
 	struct isl_tab *tab = NULL;
@@ -639,7 +1232,29 @@ static struct isl_vec *sample_bounded(struct isl_basic_set *bset)
 		if (isl_tab_detect_implicit_equalities(tab) < 0)
 			goto error;
 
-	sample = isl_tab_sample(tab);
+	resolved = add_cuts(tab);
+	if (resolved < 0)
+		goto error;
+	if (!resolved && tab->n_con > bset->n_ineq &&
+	    !ISL_F_ISSET(bset, ISL_BASIC_SET_NO_IMPLICIT))
+		if (isl_tab_detect_implicit_equalities(tab) < 0)
+			goto error;
+
+	full = !resolved && tab_is_full_dimensional(tab);
+	if (full && warm_start_basis(tab, bset) < 0)
+		goto error;
+	sample = NULL;
+	if (resolved && !tab->empty) {
+		sample = isl_tab_get_sample_value(tab);
+		if (!sample)
+			goto error;
+	}
+	if (full && parallel_sample(tab, bset, &sample) < 0)
+		goto error;
+	if (!sample)
+		sample = isl_tab_sample(tab);
+	if (full && sample && keep_basis(tab, bset) < 0)
+		sample = isl_vec_free(sample);
 	if (!sample)
 		goto error;
 
@@ -48,6 +48,9 @@ void isl_seq_cpy(isl_int *dst, isl_int *src, unsigned len)
 void isl_seq_submul(isl_int *dst, isl_int f, isl_int *src, unsigned len)
 {
 	int i;
+
+	if (isl_int_seq_submul_small(dst, f, src, len))
+		return;
 	for (i = 0; i < len; ++i)
 		isl_int_submul(dst[i], f, src[i]);
 }
@@ -55,6 +58,9 @@ void isl_seq_submul(isl_int *dst, isl_int f, isl_int *src, unsigned len)
 void isl_seq_addmul(isl_int *dst, isl_int f, isl_int *src, unsigned len)
 {
 	int i;
+
+	if (isl_int_seq_addmul_small(dst, f, src, len))
+		return;
 	for (i = 0; i < len; ++i)
 		isl_int_addmul(dst[i], f, src[i]);
 }
@@ -69,6 +75,9 @@ void isl_seq_swp_or_cpy(isl_int *dst, isl_int *src, unsigned len)
 void isl_seq_scale(isl_int *dst, isl_int *src, isl_int m, unsigned len)
 {
 	int i;
+
+	if (isl_int_seq_scale_small(dst, src, m, len))
+		return;
 	for (i = 0; i < len; ++i)
 		isl_int_mul(dst[i], src[i], m);
 }
@@ -76,6 +85,9 @@ void isl_seq_scale(isl_int *dst, isl_int *src, isl_int m, unsigned len)
 void isl_seq_scale_down(isl_int *dst, isl_int *src, isl_int m, unsigned len)
 {
 	int i;
+
+	if (isl_int_seq_scale_down_small(dst, src, m, len))
+		return;
 	for (i = 0; i < len; ++i)
 		isl_int_divexact(dst[i], src[i], m);
 }
@@ -110,10 +122,11 @@ void isl_seq_combine(isl_int *dst, isl_int m1, isl_int *src1,
 	if (dst == src1 && isl_int_is_one(m1)) {
 		if (isl_int_is_zero(m2))
 			return;
-		for (i = 0; i < len; ++i)
-			isl_int_addmul(src1[i], m2, src2[i]);
+		isl_seq_addmul(dst, m2, src2, len);
 		return;
 	}
+	if (isl_int_seq_combine_small(dst, m1, src1, m2, src2, len))
+		return;
 
 	isl_int_init(tmp);
 	for (i = 0; i < len; ++i) {
@@ -236,8 +249,12 @@ int isl_seq_abs_min_non_zero(isl_int *p, unsigned len)
 
 void isl_seq_gcd(isl_int *p, unsigned len, isl_int *gcd)
 {
-	int i, min = isl_seq_abs_min_non_zero(p, len);
+	int i, min;
 
+	if (isl_int_seq_gcd_small(p, len, gcd))
+		return;
+
+	min = isl_seq_abs_min_non_zero(p, len);
 	if (min < 0) {
 		isl_int_set_si(*gcd, 0);
 		return;
@@ -288,14 +305,19 @@ void isl_seq_inner_product(isl_int *p1, isl_int *p2, unsigned len,
 		isl_int_addmul(*prod, p1[i], p2[i]);
 }
 
+/* Update "hash" with the non-zero elements of "p" of length "len"
+ * and their positions.
+ * Each element that fits in a 64-bit word is hashed in a single step
+ * (see isl_int_hash), so the position is simply folded into the hash
+ * before the element is hashed in.
+ */
 uint32_t isl_seq_hash(isl_int *p, unsigned len, uint32_t hash)
 {
 	int i;
 	for (i = 0; i < len; ++i) {
 		if (isl_int_is_zero(p[i]))
 			continue;
-		hash *= 16777619;
-		hash ^= (i & 0xFF);
+		hash ^= i;
 		hash = isl_int_hash(p[i], hash);
 	}
 	return hash;
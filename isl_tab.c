@@ -13,6 +13,7 @@
  */
 
 #include <isl_ctx_private.h>
+#include <isl_options_private.h>
 #include <isl_mat_private.h>
 #include <isl_vec_private.h>
 #include "isl_map_private.h"
@@ -59,6 +60,7 @@ struct isl_tab *isl_tab_alloc(struct isl_ctx *ctx,
 		tab->var[i].is_redundant = 0;
 		tab->var[i].frozen = 0;
 		tab->var[i].negated = 0;
+		tab->var[i].weight = 1;
 		tab->col_var[i] = i;
 	}
 	tab->n_row = 0;
@@ -175,15 +177,79 @@ int isl_tab_extend_vars(struct isl_tab *tab, unsigned n_new)
 	return 0;
 }
 
-static void free_undo_record(struct isl_tab_undo *undo)
+/* The number of undo records in the first chunk allocated for a tableau.
+ * Each subsequent chunk is twice as large as the previous one.
+ */
+#define ISL_TAB_UNDO_CHUNK_SIZE	32
+
+/* Allocate a new chunk of undo records for "tab" and make it
+ * the current chunk.  The new chunk is appended to the current chunk,
+ * which is assumed not to have any successor.
+ */
+static struct isl_tab_undo_chunk *add_undo_chunk(struct isl_tab *tab)
+{
+	isl_ctx *ctx = tab->mat->ctx;
+	struct isl_tab_undo_chunk *chunk;
+	struct isl_tab_undo_chunk *prev = tab->undo_chunk;
+
+	chunk = isl_alloc_type(ctx, struct isl_tab_undo_chunk);
+	if (!chunk)
+		return NULL;
+	chunk->size = prev ? 2 * prev->size : ISL_TAB_UNDO_CHUNK_SIZE;
+	chunk->undo = isl_alloc_array(ctx, struct isl_tab_undo, chunk->size);
+	if (!chunk->undo) {
+		free(chunk);
+		return NULL;
+	}
+	chunk->n = 0;
+	chunk->prev = prev;
+	chunk->next = NULL;
+	if (prev)
+		prev->next = chunk;
+	tab->undo_chunk = chunk;
+
+	return chunk;
+}
+
+/* Return a pointer to a fresh undo record on top of the undo stack
+ * of "tab", taking it from the current chunk if it has any room left,
+ * from the next (unused) chunk if there is one or
+ * from a newly allocated chunk otherwise.
+ */
+static struct isl_tab_undo *alloc_undo_record(struct isl_tab *tab)
+{
+	struct isl_tab_undo_chunk *chunk = tab->undo_chunk;
+
+	if (chunk && chunk->n == chunk->size && chunk->next) {
+		chunk = chunk->next;
+		tab->undo_chunk = chunk;
+	}
+	if (!chunk || chunk->n == chunk->size)
+		chunk = add_undo_chunk(tab);
+	if (!chunk)
+		return NULL;
+
+	return &chunk->undo[chunk->n++];
+}
+
+/* Free the memory associated to the undo record "undo", which is
+ * assumed to be the top of the undo stack of "tab", and
+ * pop it off the stack.
+ * The memory of the record itself is kept in its chunk for reuse.
+ */
+static void free_undo_record(struct isl_tab *tab, struct isl_tab_undo *undo)
 {
+	struct isl_tab_undo_chunk *chunk = tab->undo_chunk;
+
 	switch (undo->type) {
 	case isl_tab_undo_saved_basis:
 		free(undo->u.col_var);
 		break;
 	default:;
 	}
-	free(undo);
+	chunk->n--;
+	if (chunk->n == 0 && chunk->prev)
+		tab->undo_chunk = chunk->prev;
 }
 
 static void free_undo(struct isl_tab *tab)
@@ -192,16 +258,37 @@ static void free_undo(struct isl_tab *tab)
 
 	for (undo = tab->top; undo && undo != &tab->bottom; undo = next) {
 		next = undo->next;
-		free_undo_record(undo);
+		free_undo_record(tab, undo);
 	}
 	tab->top = undo;
 }
 
+/* Free all chunks of undo records of "tab".
+ * The undo stack is assumed to be empty.
+ */
+static void free_undo_chunks(struct isl_tab *tab)
+{
+	struct isl_tab_undo_chunk *chunk, *next;
+
+	chunk = tab->undo_chunk;
+	if (!chunk)
+		return;
+	while (chunk->prev)
+		chunk = chunk->prev;
+	for (; chunk; chunk = next) {
+		next = chunk->next;
+		free(chunk->undo);
+		free(chunk);
+	}
+	tab->undo_chunk = NULL;
+}
+
 void isl_tab_free(struct isl_tab *tab)
 {
 	if (!tab)
 		return;
 	free_undo(tab);
+	free_undo_chunks(tab);
 	isl_mat_free(tab->mat);
 	isl_vec_free(tab->dual);
 	isl_basic_map_free(tab->bmap);
@@ -213,6 +300,7 @@ void isl_tab_free(struct isl_tab *tab)
 	isl_mat_free(tab->samples);
 	free(tab->sample_index);
 	isl_mat_free(tab->basis);
+	free(tab->nz_pos);
 	free(tab);
 }
 
@@ -682,6 +770,71 @@ static int pivot_row(struct isl_tab *tab,
 	return r;
 }
 
+/* Return a pseudo-random number based on the random state of "tab".
+ * A simple linear congruential generator is used such that the choices
+ * made by the random pricing rule are reproducible.
+ */
+static unsigned tab_random(struct isl_tab *tab)
+{
+	tab->random = tab->random * 1664525u + 1013904223u;
+	return (tab->random >> 16) & 0x7fff;
+}
+
+/* Return the squared norm of the edge direction obtained
+ * by increasing column variable "c" by one, i.e., one plus the sum
+ * of the squares of the (rational) coefficients of column "c"
+ * in the non-redundant rows.
+ * The computation is performed in floating point since the result
+ * is only used to guide the choice of the pivot column.
+ */
+static double edge_norm(struct isl_tab *tab, int c)
+{
+	int i;
+	double a, norm = 1;
+	unsigned off = 2 + tab->M;
+
+	for (i = tab->n_redundant; i < tab->n_row; ++i) {
+		if (isl_int_is_zero(tab->mat->row[i][off + c]))
+			continue;
+		a = isl_int_get_d(tab->mat->row[i][off + c]) /
+		    isl_int_get_d(tab->mat->row[i][0]);
+		norm += a * a;
+	}
+
+	return norm;
+}
+
+/* Return the score of the column "c" with coefficient "a" in the row
+ * that find_pivot is trying to move, according to pricing rule "pricing".
+ * A column with a higher score is preferred.
+ * The score is the square of the coefficient divided by a reference
+ * weight that approximates the squared norm of the edge direction.
+ * For ISL_TAB_PRICING_DEVEX, this is the Devex reference weight
+ * maintained by update_devex_weights.
+ * For ISL_TAB_PRICING_STEEPEST_EDGE, the squared norm is computed
+ * from the current tableau.
+ */
+static double column_score(struct isl_tab *tab, int pricing, isl_int a, int c)
+{
+	double d = isl_int_get_d(a);
+
+	if (pricing == ISL_TAB_PRICING_DEVEX)
+		return d * d / var_from_col(tab, c)->weight;
+	return d * d / edge_norm(tab, c);
+}
+
+/* Is row "row" of "tab" degenerate, i.e., is the sample value
+ * of the corresponding variable equal to zero?
+ * A pivot on such a row does not change the sample value
+ * of any other variable.
+ */
+static int row_is_degenerate(struct isl_tab *tab, int row)
+{
+	if (!isl_int_is_zero(tab->mat->row[row][1]))
+		return 0;
+	return !tab->M || isl_int_is_zero(tab->mat->row[row][2]);
+}
+
 /* Find a pivot (row and col) that will increase (sgn > 0) or decrease
  * (sgn < 0) the value of row variable var.
  * If not NULL, then skip_var is a row variable that should be ignored
@@ -697,12 +850,25 @@ static int pivot_row(struct isl_tab *tab,
  * If a_ri is positive, then we need to move x_i in the same direction
  * to obtain the desired effect.  Otherwise, x_i has to move in the
  * opposite direction.
+ *
+ * If there are several such columns, then the choice is determined
+ * by the tab-pricing option.  By default (ISL_TAB_PRICING_BLAND),
+ * the column with the smallest variable is taken, which, together
+ * with the choice of the row in pivot_row, is Bland's rule and
+ * prevents cycling.  ISL_TAB_PRICING_RANDOM picks a random column,
+ * while the other rules pick the column with the highest column_score.
+ * Since these other rules may cycle on degenerate pivots,
+ * the number of consecutive degenerate pivots selected by this function
+ * is kept track of and Bland's rule is used when it exceeds
+ * the number of columns, until a non-degenerate pivot is found.
  */
 static void find_pivot(struct isl_tab *tab,
 	struct isl_tab_var *var, struct isl_tab_var *skip_var,
 	int sgn, int *row, int *col)
 {
-	int j, r, c;
+	int j, r, c, n;
+	int pricing;
+	double score, best = 0;
 	isl_int *tr;
 
 	*row = *col = -1;
@@ -710,21 +876,43 @@ static void find_pivot(struct isl_tab *tab,
 	isl_assert(tab->mat->ctx, var->is_row, return);
 	tr = tab->mat->row[var->index] + 2 + tab->M;
 
+	pricing = tab->mat->ctx->opt->tab_pricing;
+	if (tab->n_degenerate > tab->n_col)
+		pricing = ISL_TAB_PRICING_BLAND;
+
 	c = -1;
+	n = 0;
 	for (j = tab->n_dead; j < tab->n_col; ++j) {
 		if (isl_int_is_zero(tr[j]))
 			continue;
 		if (isl_int_sgn(tr[j]) != sgn &&
 		    var_from_col(tab, j)->is_nonneg)
 			continue;
-		if (c < 0 || tab->col_var[j] < tab->col_var[c])
+		if (pricing == ISL_TAB_PRICING_BLAND) {
+			if (c < 0 || tab->col_var[j] < tab->col_var[c])
+				c = j;
+			continue;
+		}
+		if (pricing == ISL_TAB_PRICING_RANDOM) {
+			if (tab_random(tab) % ++n == 0)
+				c = j;
+			continue;
+		}
+		score = column_score(tab, pricing, tr[j], j);
+		if (c < 0 || score > best) {
 			c = j;
+			best = score;
+		}
 	}
 	if (c < 0)
 		return;
 
 	sgn *= isl_int_sgn(tr[c]);
 	r = pivot_row(tab, skip_var, sgn, c);
+	if (r >= 0 && row_is_degenerate(tab, r))
+		tab->n_degenerate++;
+	else if (r >= 0)
+		tab->n_degenerate = 0;
 	*row = r < 0 ? var->index : r;
 	*col = c;
 }
@@ -782,6 +970,11 @@ static void swap_rows(struct isl_tab *tab, int row1, int row2)
 	tab->row_sign[row2] = s;
 }
 
+/* Push an undo record of type "type" with value "u" onto the undo stack
+ * of "tab", if undo information needs to be kept.
+ * No records are pushed while a rollback is in progress since
+ * isl_tab_rollback would not be able to keep track of them.
+ */
 static int push_union(struct isl_tab *tab,
 	enum isl_tab_undo_type type, union isl_tab_undo_val u) WARN_UNUSED;
 static int push_union(struct isl_tab *tab,
@@ -791,10 +984,10 @@ static int push_union(struct isl_tab *tab,
 
 	if (!tab)
 		return -1;
-	if (!tab->need_undo)
+	if (!tab->need_undo || tab->in_undo)
 		return 0;
 
-	undo = isl_alloc_type(tab->mat->ctx, struct isl_tab_undo);
+	undo = alloc_undo_record(tab);
 	if (!undo)
 		return -1;
 	undo->type = type;
@@ -1055,6 +1248,159 @@ static void update_row_sign(struct isl_tab *tab, int row, int col, int row_sgn)
 	}
 }
 
+/* Update row "j" of the tableau during a pivot on row "row" and
+ * column "col", where row "row" has already been transformed
+ * into the form
+ *
+ *	s(n_rc)d_r/|n_rc|		-s(n_rc)n_ri/|n_rc|
+ *
+ * (see isl_tab_pivot), i.e., replace n_ji by n_ji |n_rc| - s(n_rc)n_jc n_ri
+ * for every column i other than "col", n_jc by s(n_rc)d_r n_jc and
+ * d_j by |n_rc| d_j.  "tmp" is used to hold a copy of n_jc.
+ *
+ * If all entries of both rows are in small representation,
+ * then all columns, including "col", are first updated at once
+ * on machine words, promoting only those entries that no longer fit.
+ * The entry in column "col" is subsequently overwritten.
+ * Otherwise, the entries are updated one by one, skipping "col".
+ */
+static void update_row(struct isl_tab *tab, int j, int row, int col,
+	isl_int tmp)
+{
+	int k;
+	unsigned off = 2 + tab->M;
+	unsigned len = off - 1 + tab->n_col;
+	isl_int *r = tab->mat->row[row];
+	isl_int *p = tab->mat->row[j];
+
+	isl_int_set(tmp, p[off + col]);
+	isl_int_mul(p[0], p[0], r[0]);
+	if (!isl_int_seq_combine_small(p + 1, r[0], p + 1, tmp, r + 1, len)) {
+		for (k = 0; k < len; ++k) {
+			if (k == off - 1 + col)
+				continue;
+			isl_int_mul(p[1 + k], p[1 + k], r[0]);
+			isl_int_addmul(p[1 + k], tmp, r[1 + k]);
+		}
+	}
+	isl_int_mul(p[off + col], tmp, r[off + col]);
+	if (!isl_int_is_one(p[0]))
+		isl_seq_normalize(tab->mat->ctx, p, off + tab->n_col);
+}
+
+/* Decide whether the pivot on row "row" and column "col" should update
+ * the other rows in a sparse way, after row "row" has been transformed
+ * (see isl_tab_pivot).
+ * This is the case if the percentage of non-zero entries in row "row",
+ * not counting the denominator and the entry in column "col",
+ * is smaller than the tab-sparse-density option.
+ * If so, the positions of these entries, relative to the constant term,
+ * are stored in tab->nz_pos and their number in *n_nz.
+ * The scan is aborted as soon as it is clear that the row is too dense.
+ *
+ * Return 1 if the update should be sparse, 0 if it should be dense and
+ * -1 on error.
+ */
+static int sparse_pivot_row(struct isl_tab *tab, int row, int col, int *n_nz)
+{
+	int k, n;
+	unsigned off = 2 + tab->M;
+	unsigned len = off - 1 + tab->n_col;
+	isl_int *r = tab->mat->row[row];
+	isl_ctx *ctx = tab->mat->ctx;
+	int density = ctx->opt->tab_sparse_density;
+
+	if (density <= 0)
+		return 0;
+	if (tab->nz_size < len) {
+		int *nz_pos;
+
+		nz_pos = isl_realloc_array(ctx, tab->nz_pos, int, len);
+		if (!nz_pos)
+			return -1;
+		tab->nz_pos = nz_pos;
+		tab->nz_size = len;
+	}
+
+	n = 0;
+	for (k = 0; k < len; ++k) {
+		if (k == off - 1 + col || isl_int_is_zero(r[1 + k]))
+			continue;
+		if (100 * (n + 1) >= density * len)
+			return 0;
+		tab->nz_pos[n++] = k;
+	}
+
+	*n_nz = n;
+	return 1;
+}
+
+/* Update row "j" of the tableau during a pivot on row "row" and
+ * column "col" in the same way as update_row, given that the "n_nz"
+ * non-zero entries of row "row" outside of column "col" are located
+ * at the positions in tab->nz_pos (see sparse_pivot_row).
+ * Only the non-zero entries of row "j" need to be multiplied
+ * by the denominator d_r of row "row" and, if d_r is one, then
+ * only the entries at the positions in tab->nz_pos and
+ * in column "col" can change.
+ */
+static void update_row_sparse(struct isl_tab *tab, int j, int row, int col,
+	isl_int tmp, int n_nz)
+{
+	int k;
+	unsigned off = 2 + tab->M;
+	unsigned len = off - 1 + tab->n_col;
+	isl_int *r = tab->mat->row[row];
+	isl_int *p = tab->mat->row[j];
+	int *pos = tab->nz_pos;
+
+	isl_int_set(tmp, p[off + col]);
+	isl_int_mul(p[0], p[0], r[0]);
+	if (!isl_int_is_one(r[0]))
+		for (k = 0; k < len; ++k)
+			if (!isl_int_is_zero(p[1 + k]))
+				isl_int_mul(p[1 + k], p[1 + k], r[0]);
+	for (k = 0; k < n_nz; ++k)
+		isl_int_addmul(p[1 + pos[k]], tmp, r[1 + pos[k]]);
+	isl_int_mul(p[off + col], tmp, r[off + col]);
+	if (!isl_int_is_one(p[0]))
+		isl_seq_normalize(tab->mat->ctx, p, off + tab->n_col);
+}
+
+/* Update the Devex reference weights of the column variables of "tab"
+ * for a pivot on row "row" and column "col", given the tableau
+ * before the pivot.
+ * Let p_j be the coefficient of column j in row "row", divided by
+ * the denominator of the row and let w_j be the weight of column j.
+ * The weight of every other column j is set to the maximum
+ * of w_j and (p_j/p_col)^2 w_col, while the variable that leaves
+ * the basis receives the weight max(w_col/p_col^2, 1).
+ */
+static void update_devex_weights(struct isl_tab *tab, int row, int col)
+{
+	int j;
+	double p, a, w;
+	unsigned off = 2 + tab->M;
+	isl_int *pr = tab->mat->row[row];
+	struct isl_tab_var *var;
+
+	p = isl_int_get_d(pr[off + col]);
+	w = var_from_col(tab, col)->weight;
+	for (j = tab->n_dead; j < tab->n_col; ++j) {
+		if (j == col || isl_int_is_zero(pr[off + j]))
+			continue;
+		a = isl_int_get_d(pr[off + j]) / p;
+		var = var_from_col(tab, j);
+		if (a * a * w > var->weight)
+			var->weight = a * a * w;
+	}
+	p /= isl_int_get_d(pr[0]);
+	var = isl_tab_var_from_row(tab, row);
+	var->weight = w / (p * p);
+	if (!(var->weight >= 1))
+		var->weight = 1;
+}
+
 /* Given a row number "row" and a column number "col", pivot the tableau
  * such that the associated variables are interchanged.
  * The given row in the tableau expresses
@@ -1104,12 +1450,20 @@ static void update_row_sign(struct isl_tab *tab, int row, int col, int row_sgn)
  * s(n_rc)d_r/|n_rc|		-s(n_rc)n_ri/|n_rc|
  * s(n_rc)d_r n_jc/(|n_rc| d_j)	(n_ji |n_rc| - s(n_rc)n_jc n_ri)/(|n_rc| d_j)
  *
+ * The other rows are updated by update_row or, if the pivot row
+ * is sparse, by update_row_sparse.
+ *
+ * Before performing the pivot, the Devex reference weights are updated
+ * if they are being used and the pivot is recorded in the statistics
+ * of the isl_ctx.
  */
 int isl_tab_pivot(struct isl_tab *tab, int row, int col)
 {
 	int i, j;
 	int sgn;
 	int t;
+	int sparse, n_nz;
+	isl_int *tmp;
 	isl_ctx *ctx;
 	struct isl_mat *mat = tab->mat;
 	struct isl_tab_var *var;
@@ -1118,6 +1472,15 @@ int isl_tab_pivot(struct isl_tab *tab, int row, int col)
 	ctx = isl_tab_get_ctx(tab);
 	if (isl_ctx_next_operation(ctx) < 0)
 		return -1;
+	tmp = isl_ctx_scratch_acquire(ctx, 1);
+	if (!tmp)
+		return -1;
+
+	if (ctx->opt->tab_pricing == ISL_TAB_PRICING_DEVEX)
+		update_devex_weights(tab, row, col);
+	ctx->stats->tab_pivots++;
+	if (row_is_degenerate(tab, row))
+		ctx->stats->tab_degenerate_pivots++;
 
 	isl_int_swap(mat->row[row][0], mat->row[row][off + col]);
 	sgn = isl_int_sgn(mat->row[row][0]);
@@ -1132,25 +1495,24 @@ int isl_tab_pivot(struct isl_tab *tab, int row, int col)
 		}
 	if (!isl_int_is_one(mat->row[row][0]))
 		isl_seq_normalize(mat->ctx, mat->row[row], off + tab->n_col);
+	sparse = sparse_pivot_row(tab, row, col, &n_nz);
+	if (sparse < 0) {
+		isl_ctx_scratch_release(ctx, tmp, 1);
+		return -1;
+	}
+	if (sparse)
+		ctx->stats->tab_sparse_pivots++;
 	for (i = 0; i < tab->n_row; ++i) {
 		if (i == row)
 			continue;
 		if (isl_int_is_zero(mat->row[i][off + col]))
 			continue;
-		isl_int_mul(mat->row[i][0], mat->row[i][0], mat->row[row][0]);
-		for (j = 0; j < off - 1 + tab->n_col; ++j) {
-			if (j == off - 1 + col)
-				continue;
-			isl_int_mul(mat->row[i][1 + j],
-				    mat->row[i][1 + j], mat->row[row][0]);
-			isl_int_addmul(mat->row[i][1 + j],
-				    mat->row[i][off + col], mat->row[row][1 + j]);
-		}
-		isl_int_mul(mat->row[i][off + col],
-			    mat->row[i][off + col], mat->row[row][off + col]);
-		if (!isl_int_is_one(mat->row[i][0]))
-			isl_seq_normalize(mat->ctx, mat->row[i], off + tab->n_col);
+		if (sparse)
+			update_row_sparse(tab, i, row, col, tmp[0], n_nz);
+		else
+			update_row(tab, i, row, col, tmp[0]);
 	}
+	isl_ctx_scratch_release(ctx, tmp, 1);
 	t = tab->row_var[row];
 	tab->row_var[row] = tab->col_var[col];
 	tab->col_var[col] = t;
@@ -1672,6 +2034,7 @@ int isl_tab_allocate_con(struct isl_tab *tab)
 	tab->con[r].is_redundant = 0;
 	tab->con[r].frozen = 0;
 	tab->con[r].negated = 0;
+	tab->con[r].weight = 1;
 	tab->row_var[tab->n_row] = ~r;
 
 	tab->n_row++;
@@ -1758,6 +2121,7 @@ int isl_tab_insert_var(struct isl_tab *tab, int r)
 	tab->var[r].is_redundant = 0;
 	tab->var[r].frozen = 0;
 	tab->var[r].negated = 0;
+	tab->var[r].weight = 1;
 	tab->col_var[tab->n_col] = r;
 
 	for (i = 0; i < tab->n_row; ++i)
@@ -1808,15 +2172,20 @@ int isl_tab_add_row(struct isl_tab *tab, isl_int *line)
 	int i;
 	int r;
 	isl_int *row;
-	isl_int a, b;
+	isl_int *t;
+	isl_ctx *ctx;
 	unsigned off = 2 + tab->M;
 
+	ctx = isl_tab_get_ctx(tab);
+	t = isl_ctx_scratch_acquire(ctx, 2);
+	if (!t)
+		return -1;
 	r = isl_tab_allocate_con(tab);
-	if (r < 0)
+	if (r < 0) {
+		isl_ctx_scratch_release(ctx, t, 2);
 		return -1;
+	}
 
-	isl_int_init(a);
-	isl_int_init(b);
 	row = tab->mat->row[tab->con[r].index];
 	isl_int_set_si(row[0], 1);
 	isl_int_set(row[1], line[0]);
@@ -1825,15 +2194,15 @@ int isl_tab_add_row(struct isl_tab *tab, isl_int *line)
 		if (tab->var[i].is_zero)
 			continue;
 		if (tab->var[i].is_row) {
-			isl_int_lcm(a,
+			isl_int_lcm(t[0],
 				row[0], tab->mat->row[tab->var[i].index][0]);
-			isl_int_swap(a, row[0]);
-			isl_int_divexact(a, row[0], a);
-			isl_int_divexact(b,
+			isl_int_swap(t[0], row[0]);
+			isl_int_divexact(t[0], row[0], t[0]);
+			isl_int_divexact(t[1],
 				row[0], tab->mat->row[tab->var[i].index][0]);
-			isl_int_mul(b, b, line[1 + i]);
-			isl_seq_combine(row + 1, a, row + 1,
-			    b, tab->mat->row[tab->var[i].index] + 1,
+			isl_int_mul(t[1], t[1], line[1 + i]);
+			isl_seq_combine(row + 1, t[0], row + 1,
+			    t[1], tab->mat->row[tab->var[i].index] + 1,
 			    1 + tab->M + tab->n_col);
 		} else
 			isl_int_addmul(row[off + tab->var[i].index],
@@ -1842,8 +2211,7 @@ int isl_tab_add_row(struct isl_tab *tab, isl_int *line)
 			isl_int_submul(row[2], line[1 + i], row[0]);
 	}
 	isl_seq_normalize(tab->mat->ctx, row, off + tab->n_col);
-	isl_int_clear(a);
-	isl_int_clear(b);
+	isl_ctx_scratch_release(ctx, t, 2);
 
 	if (tab->row_sign)
 		tab->row_sign[tab->con[r].index] = isl_tab_row_unknown;
@@ -2542,16 +2910,19 @@ struct isl_vec *isl_tab_get_sample_value(struct isl_tab *tab)
 {
 	int i;
 	struct isl_vec *vec;
-	isl_int m;
+	isl_int *m;
+	isl_ctx *ctx;
 
 	if (!tab)
 		return NULL;
 
-	vec = isl_vec_alloc(tab->mat->ctx, 1 + tab->n_var);
-	if (!vec)
-		return NULL;
-
-	isl_int_init(m);
+	ctx = isl_tab_get_ctx(tab);
+	vec = isl_vec_alloc(ctx, 1 + tab->n_var);
+	m = isl_ctx_scratch_acquire(ctx, 1);
+	if (!vec || !m) {
+		isl_ctx_scratch_release(ctx, m, 1);
+		return isl_vec_free(vec);
+	}
 
 	isl_int_set_si(vec->block.data[0], 1);
 	for (i = 0; i < tab->n_var; ++i) {
@@ -2561,15 +2932,17 @@ struct isl_vec *isl_tab_get_sample_value(struct isl_tab *tab)
 			continue;
 		}
 		row = tab->var[i].index;
-		isl_int_gcd(m, vec->block.data[0], tab->mat->row[row][0]);
-		isl_int_divexact(m, tab->mat->row[row][0], m);
-		isl_seq_scale(vec->block.data, vec->block.data, m, 1 + i);
-		isl_int_divexact(m, vec->block.data[0], tab->mat->row[row][0]);
-		isl_int_mul(vec->block.data[1 + i], m, tab->mat->row[row][1]);
+		isl_int_gcd(m[0], vec->block.data[0], tab->mat->row[row][0]);
+		isl_int_divexact(m[0], tab->mat->row[row][0], m[0]);
+		isl_seq_scale(vec->block.data, vec->block.data, m[0], 1 + i);
+		isl_int_divexact(m[0], vec->block.data[0],
+				tab->mat->row[row][0]);
+		isl_int_mul(vec->block.data[1 + i], m[0],
+				tab->mat->row[row][1]);
 	}
+	isl_ctx_scratch_release(ctx, m, 1);
 	vec = isl_vec_normalize(vec);
 
-	isl_int_clear(m);
 	return vec;
 }
 
@@ -2644,12 +3017,16 @@ static isl_stat drop_last_con_in_row(struct isl_tab *tab, int r)
  * If the new variable cannot attain non-negative values, then
  * the resulting tableau is empty.
  * Otherwise, we know the value will be zero and we close the row.
+ *
+ * Extending the constraint array may move "var", so it is
+ * looked up again from its position in the tableau afterwards.
  */
 static isl_stat cut_to_hyperplane(struct isl_tab *tab, struct isl_tab_var *var)
 {
 	unsigned r;
 	isl_int *row;
 	int sgn;
+	int is_row, index;
 	unsigned off = 2 + tab->M;
 
 	if (var->is_zero)
@@ -2659,8 +3036,14 @@ static isl_stat cut_to_hyperplane(struct isl_tab *tab, struct isl_tab_var *var)
 			"expecting non-redundant non-negative variable",
 			return isl_stat_error);
 
+	is_row = var->is_row;
+	index = var->index;
 	if (isl_tab_extend_cons(tab, 1) < 0)
 		return isl_stat_error;
+	if (is_row)
+		var = isl_tab_var_from_row(tab, index);
+	else
+		var = var_from_col(tab, index);
 
 	r = tab->n_con;
 	tab->con[r].index = tab->n_row;
@@ -2670,6 +3053,7 @@ static isl_stat cut_to_hyperplane(struct isl_tab *tab, struct isl_tab_var *var)
 	tab->con[r].is_redundant = 0;
 	tab->con[r].frozen = 0;
 	tab->con[r].negated = 0;
+	tab->con[r].weight = 1;
 	tab->row_var[tab->n_row] = ~r;
 	row = tab->mat->row[tab->n_row];
 
@@ -3189,6 +3573,291 @@ int isl_tab_is_equality(struct isl_tab *tab, int con)
 					tab->n_col - tab->n_dead) == -1;
 }
 
+/* Pivot the tableau to a state where the non-basic variables
+ * are those in "col_var".
+ * We first construct a list of variables that are currently
+ * not in the basis, but should be.  Then we iterate over all variables
+ * that should not be in the basis and for each one that is currently
+ * in the basis, we exchange it with one of the elements of the
+ * list constructed before that has a non-zero coefficient in its row.
+ * If there is no such element, then the variables in "col_var"
+ * do not correspond to a basis and 1 is returned.
+ * Otherwise, 0 is returned on success.
+ */
+static int pivot_to_basis(struct isl_tab *tab, int *col_var)
+{
+	int i, j;
+	int n_extra = 0;
+	int *extra = NULL;	/* current columns that contain bad stuff */
+	unsigned off = 2 + tab->M;
+
+	extra = isl_alloc_array(tab->mat->ctx, int, tab->n_col);
+	if (tab->n_col && !extra)
+		goto error;
+	for (i = 0; i < tab->n_col; ++i) {
+		for (j = 0; j < tab->n_col; ++j)
+			if (tab->col_var[i] == col_var[j])
+				break;
+		if (j < tab->n_col)
+			continue;
+		extra[n_extra++] = i;
+	}
+	for (i = 0; i < tab->n_col && n_extra > 0; ++i) {
+		struct isl_tab_var *var;
+		int row;
+
+		for (j = 0; j < tab->n_col; ++j)
+			if (col_var[i] == tab->col_var[j])
+				break;
+		if (j < tab->n_col)
+			continue;
+		var = var_from_index(tab, col_var[i]);
+		row = var->index;
+		for (j = 0; j < n_extra; ++j)
+			if (!isl_int_is_zero(tab->mat->row[row][off+extra[j]]))
+				break;
+		if (j >= n_extra) {
+			free(extra);
+			return 1;
+		}
+		if (isl_tab_pivot(tab, row, extra[j]) < 0)
+			goto error;
+		extra[j] = extra[--n_extra];
+	}
+
+	free(extra);
+	return 0;
+error:
+	free(extra);
+	return -1;
+}
+
+/* Absolute tolerance used in the floating point simplex
+ * of float_lp_basis.
+ */
+#define ISL_TAB_FLOAT_EPS	1e-9
+
+static double float_abs(double a)
+{
+	return a < 0 ? -a : a;
+}
+
+/* Pivot row "r" and column "c" of the floating point copy "t"
+ * of a tableau with "n_row" rows and "n_col" columns,
+ * where the first element of each row holds the constant term.
+ * The update mirrors that of isl_tab_pivot.
+ */
+static void float_pivot(double *t, int n_row, int n_col, int r, int c)
+{
+	int i, j;
+	int w = 1 + n_col;
+	double p = t[r * w + 1 + c];
+	double a;
+
+	for (j = 0; j < w; ++j)
+		t[r * w + j] = -t[r * w + j] / p;
+	t[r * w + 1 + c] = 1 / p;
+	for (i = 0; i < n_row; ++i) {
+		if (i == r)
+			continue;
+		a = t[i * w + 1 + c];
+		if (a == 0)
+			continue;
+		for (j = 0; j < w; ++j)
+			t[i * w + j] += a * t[r * w + j];
+		t[i * w + 1 + c] = a * t[r * w + 1 + c];
+	}
+}
+
+/* Minimize the row variable "obj" over a floating point copy of "tab"
+ * using the primal simplex method and store the non-basic variables
+ * of the final tableau in "col_var".
+ * Pivot columns are chosen according to Dantzig's rule, with
+ * a fallback to Bland's rule after a long sequence of degenerate pivots.
+ * Pivot rows are chosen as in pivot_row.
+ * Return 1 if an optimal basis was found, 0 if no basis was found
+ * (because the problem appears to be unbounded or
+ * the number of iterations exceeds a bound) and -1 on error.
+ * "tab" is assumed not to involve a big parameter.
+ */
+static int float_lp_basis(struct isl_tab *tab, struct isl_tab_var *obj,
+	int *col_var)
+{
+	int i, j, r, c, o, dir, it;
+	int n_row = tab->n_row, n_col = tab->n_col, w = 1 + n_col;
+	int n_degenerate = 0;
+	int res = 0;
+	double a, d, best, ratio, best_ratio;
+	double *t;
+	int *row_var;
+
+	t = isl_alloc_array(tab->mat->ctx, double, n_row * w);
+	row_var = isl_alloc_array(tab->mat->ctx, int, n_row);
+	if ((n_row && !t) || (n_row && !row_var)) {
+		free(t);
+		free(row_var);
+		return -1;
+	}
+	for (i = 0; i < n_row; ++i) {
+		isl_int *row = tab->mat->row[i];
+
+		row_var[i] = tab->row_var[i];
+		d = isl_int_get_d(row[0]);
+		t[i * w] = isl_int_get_d(row[1]) / d;
+		for (j = 0; j < n_col; ++j)
+			t[i * w + 1 + j] = isl_int_get_d(row[2 + j]) / d;
+	}
+	for (j = 0; j < n_col; ++j)
+		col_var[j] = tab->col_var[j];
+
+	o = obj->index;
+	for (it = 0; it < 10 * (n_row + n_col); ++it) {
+		c = -1;
+		best = 0;
+		for (j = tab->n_dead; j < n_col; ++j) {
+			a = t[o * w + 1 + j];
+			if (float_abs(a) <= ISL_TAB_FLOAT_EPS)
+				continue;
+			if (a > 0 && var_from_index(tab, col_var[j])->is_nonneg)
+				continue;
+			if (n_degenerate > n_col) {
+				if (c < 0 || col_var[j] < col_var[c])
+					c = j;
+				continue;
+			}
+			if (c < 0 || float_abs(a) > best) {
+				c = j;
+				best = float_abs(a);
+			}
+		}
+		if (c < 0) {
+			res = 1;
+			break;
+		}
+		dir = t[o * w + 1 + c] < 0 ? 1 : -1;
+		r = -1;
+		best_ratio = 0;
+		for (i = tab->n_redundant; i < n_row; ++i) {
+			if (i == o)
+				continue;
+			if (!var_from_index(tab, row_var[i])->is_nonneg)
+				continue;
+			a = t[i * w + 1 + c];
+			if (dir * a >= -ISL_TAB_FLOAT_EPS)
+				continue;
+			ratio = t[i * w] > 0 ? t[i * w] / float_abs(a) : 0;
+			if (r >= 0 && (ratio > best_ratio ||
+			    (ratio == best_ratio && row_var[i] > row_var[r])))
+				continue;
+			r = i;
+			best_ratio = ratio;
+		}
+		if (r < 0)
+			break;
+		if (t[r * w] <= ISL_TAB_FLOAT_EPS)
+			n_degenerate++;
+		else
+			n_degenerate = 0;
+		float_pivot(t, n_row, n_col, r, c);
+		j = row_var[r];
+		row_var[r] = col_var[c];
+		col_var[c] = j;
+	}
+
+	free(t);
+	free(row_var);
+	return res;
+}
+
+/* Is the sample value of every non-redundant non-negative row variable
+ * of "tab" non-negative?
+ * "tab" is assumed not to involve a big parameter.
+ */
+static int sample_is_feasible(struct isl_tab *tab)
+{
+	int i;
+
+	for (i = tab->n_redundant; i < tab->n_row; ++i) {
+		if (!isl_tab_var_from_row(tab, i)->is_nonneg)
+			continue;
+		if (isl_int_is_neg(tab->mat->row[i][1]))
+			return 0;
+	}
+
+	return 1;
+}
+
+/* Try and move "tab" to the basis with non-basic variables "col_var".
+ * The move is only accepted if "col_var" corresponds to a basis
+ * and if the sample value of this basis satisfies all constraints.
+ * Otherwise, the original basis is restored.
+ * Return 1 if the move was accepted, 0 if it was not and -1 on error.
+ *
+ * The pivots are performed as if during a rollback, such that
+ * no rows are marked redundant while the tableau may be infeasible.
+ * In particular, the variables in the original and in the new basis
+ * remain in rows that may be pivoted.
+ */
+static int try_basis(struct isl_tab *tab, int *col_var)
+{
+	int i, r;
+	int *orig;
+
+	orig = isl_alloc_array(tab->mat->ctx, int, tab->n_col);
+	if (tab->n_col && !orig)
+		return -1;
+	for (i = 0; i < tab->n_col; ++i)
+		orig[i] = tab->col_var[i];
+
+	tab->in_undo = 1;
+	r = pivot_to_basis(tab, col_var);
+	if (r == 0 && sample_is_feasible(tab))
+		r = 1;
+	else if (r >= 0) {
+		r = pivot_to_basis(tab, orig);
+		if (r > 0)
+			isl_die(isl_tab_get_ctx(tab), isl_error_internal,
+				"cannot restore basis", r = -1);
+	}
+	tab->in_undo = 0;
+
+	free(orig);
+	return r;
+}
+
+/* Try and use a floating point version of the simplex method
+ * to find an optimal basis for minimizing the row variable "obj"
+ * and move "tab" to this basis if it is feasible.
+ * This basis still needs to be certified optimal by the exact
+ * simplex method, which will also continue to improve the solution
+ * if it is not.
+ * The numbers of accepted and rejected guesses are recorded
+ * in the statistics of the isl_ctx.
+ */
+static isl_stat float_filter(struct isl_tab *tab, struct isl_tab_var *obj)
+{
+	int r;
+	int *col_var;
+	isl_ctx *ctx = isl_tab_get_ctx(tab);
+
+	col_var = isl_alloc_array(ctx, int, tab->n_col);
+	if (tab->n_col && !col_var)
+		return isl_stat_error;
+	r = float_lp_basis(tab, obj, col_var);
+	if (r > 0)
+		r = try_basis(tab, col_var);
+	free(col_var);
+	if (r < 0)
+		return isl_stat_error;
+
+	if (r)
+		ctx->stats->tab_float_accepted++;
+	else
+		ctx->stats->tab_float_rejected++;
+
+	return isl_stat_ok;
+}
+
 /* Return the minimal value of the affine expression "f" with denominator
  * "denom" in *opt, *opt_denom, assuming the tableau is not empty and
  * the expression cannot attain arbitrarily small values.
@@ -3198,6 +3867,10 @@ int isl_tab_is_equality(struct isl_tab *tab, int con)
  *
  * This function assumes that at least one more row and at least
  * one more element in the constraint array are available in the tableau.
+ *
+ * If the tab-float-filter option is set, then the tableau is first
+ * moved to an optimal basis computed in floating point
+ * (if there is no big parameter and no row signs need to be maintained).
  */
 enum isl_lp_result isl_tab_min(struct isl_tab *tab,
 	isl_int *f, isl_int denom, isl_int *opt, isl_int *opt_denom,
@@ -3219,6 +3892,9 @@ enum isl_lp_result isl_tab_min(struct isl_tab *tab,
 	if (r < 0)
 		return isl_lp_error;
 	var = &tab->con[r];
+	if (tab->mat->ctx->opt->tab_float_filter && !tab->M && !tab->row_sign)
+		if (float_filter(tab, var) < 0)
+			return isl_lp_error;
 	for (;;) {
 		int row, col;
 		find_pivot(tab, var, var, -1, &row, &col);
@@ -3447,58 +4123,17 @@ static isl_stat drop_bmap_div(struct isl_tab *tab, int pos)
 
 /* Restore the tableau to the state where the basic variables
  * are those in "col_var".
- * We first construct a list of variables that are currently in
- * the basis, but shouldn't.  Then we iterate over all variables
- * that should be in the basis and for each one that is currently
- * not in the basis, we exchange it with one of the elements of the
- * list constructed before.
- * We can always find an appropriate variable to pivot with because
- * the current basis is mapped to the old basis by a non-singular
- * matrix and so we can never end up with a zero row.
+ * We can always find an appropriate variable to pivot with in
+ * pivot_to_basis because the current basis is mapped to the old basis
+ * by a non-singular matrix and so we can never end up with a zero row.
  */
 static int restore_basis(struct isl_tab *tab, int *col_var)
 {
-	int i, j;
-	int n_extra = 0;
-	int *extra = NULL;	/* current columns that contain bad stuff */
-	unsigned off = 2 + tab->M;
-
-	extra = isl_alloc_array(tab->mat->ctx, int, tab->n_col);
-	if (tab->n_col && !extra)
-		goto error;
-	for (i = 0; i < tab->n_col; ++i) {
-		for (j = 0; j < tab->n_col; ++j)
-			if (tab->col_var[i] == col_var[j])
-				break;
-		if (j < tab->n_col)
-			continue;
-		extra[n_extra++] = i;
-	}
-	for (i = 0; i < tab->n_col && n_extra > 0; ++i) {
-		struct isl_tab_var *var;
-		int row;
-
-		for (j = 0; j < tab->n_col; ++j)
-			if (col_var[i] == tab->col_var[j])
-				break;
-		if (j < tab->n_col)
-			continue;
-		var = var_from_index(tab, col_var[i]);
-		row = var->index;
-		for (j = 0; j < n_extra; ++j)
-			if (!isl_int_is_zero(tab->mat->row[row][off+extra[j]]))
-				break;
-		isl_assert(tab->mat->ctx, j < n_extra, goto error);
-		if (isl_tab_pivot(tab, row, extra[j]) < 0)
-			goto error;
-		extra[j] = extra[--n_extra];
-	}
+	int r;
 
-	free(extra);
-	return 0;
-error:
-	free(extra);
-	return -1;
+	r = pivot_to_basis(tab, col_var);
+	isl_assert(tab->mat->ctx, r <= 0, return -1);
+	return r;
 }
 
 /* Remove all samples with index n or greater, i.e., those samples
@@ -3586,7 +4221,7 @@ int isl_tab_rollback(struct isl_tab *tab, struct isl_tab_undo *snap)
 			tab->in_undo = 0;
 			return -1;
 		}
-		free_undo_record(undo);
+		free_undo_record(tab, undo);
 	}
 	tab->in_undo = 0;
 	tab->top = undo;
@@ -25,6 +25,7 @@ struct isl_tab_var {
 	unsigned marked : 1;
 	unsigned frozen : 1;
 	unsigned negated : 1;
+	double weight;
 };
 
 enum isl_tab_undo_type {
@@ -64,6 +65,22 @@ struct isl_tab_undo {
 	struct isl_tab_undo	*next;
 };
 
+/* A chunk of memory for storing undo records.
+ * The undo records of a tableau are allocated in stack order
+ * from a doubly linked list of such chunks.
+ * "n" is the number of records in use out of the "size" records
+ * in "undo".
+ * Chunks that become unused during a rollback are kept around
+ * for later reuse.
+ */
+struct isl_tab_undo_chunk {
+	struct isl_tab_undo_chunk	*prev;
+	struct isl_tab_undo_chunk	*next;
+	int				n;
+	int				size;
+	struct isl_tab_undo		*undo;
+};
+
 /* The tableau maintains equality relations.
  * Each column and each row is associated to a variable or a constraint.
  * The "value" of an inequality constraint is the value of the corresponding
@@ -124,6 +141,9 @@ struct isl_tab_undo {
  *
  * If "preserve" is set, then we want to keep all constraints in the
  * tableau, even if they turn out to be redundant.
+ *
+ * "nz_pos" is a buffer of size "nz_size" that is used by isl_tab_pivot
+ * to hold the positions of the non-zero entries of a sparse pivot row.
  */
 enum isl_tab_row_sign {
 	isl_tab_row_unknown = 0,
@@ -154,6 +174,7 @@ struct isl_tab {
 
 	struct isl_tab_undo bottom;
 	struct isl_tab_undo *top;
+	struct isl_tab_undo_chunk *undo_chunk;
 
 	struct isl_vec *dual;
 	struct isl_basic_map *bmap;
@@ -170,6 +191,12 @@ struct isl_tab {
 	int (*conflict)(int con, void *user);
 	void *conflict_user;
 
+	unsigned n_degenerate;
+	unsigned random;
+
+	int *nz_pos;
+	unsigned nz_size;
+
 	unsigned strict_redundant : 1;
 	unsigned need_undo : 1;
 	unsigned preserve : 1;
@@ -256,6 +283,8 @@ __isl_give isl_map *isl_tab_basic_map_partial_lexopt(
 __isl_give isl_pw_multi_aff *isl_tab_basic_map_partial_lexopt_pw_multi_aff(
 	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
 	__isl_give isl_set **empty, unsigned flags);
+isl_stat isl_tab_shared_contexts_start(isl_ctx *ctx);
+void isl_tab_shared_contexts_finish(isl_ctx *ctx);
 
 /* An isl_region represents a sequence of consecutive variables.
  * pos is the location (starting at 0) of the first variable in the sequence.
@@ -14,47 +14,49 @@
 #define xSF(TYPE,SUFFIX) TYPE ## SUFFIX
 #define SF(TYPE,SUFFIX) xSF(TYPE,SUFFIX)
 
-/* Given a basic map with at least two parallel constraints (as found
- * by the function parallel_constraints), first look for more constraints
- * parallel to the two constraint and replace the found list of parallel
- * constraints by a single constraint with as "input" part the minimum
- * of the input parts of the list of constraints.  Then, recursively call
- * basic_map_partial_lexopt (possibly finding more parallel constraints)
+/* Given a basic map with a family of at least two parallel constraints
+ * (as found by the function parallel_constraints), replace the family
+ * by a single constraint with as "input" part the minimum
+ * of the input parts of the constraints in the family.  Then, recursively
+ * call basic_map_partial_lexopt (possibly finding more parallel constraints)
  * and plug in the definition of the minimum in the result.
  *
  * As in parallel_constraints, only inequality constraints that only
- * involve input variables that do not occur in any other inequality
- * constraints are considered.
+ * involve input variables that do not occur in any inequality
+ * constraints outside the family are considered.
  *
  * More specifically, given a set of constraints
  *
- *	a x + b_i(p) >= 0
+ *	s_i a x + b_i(p) >= 0
  *
- * Replace this set by a single constraint
+ * with s_i positive integers (all equal to one if the map is rational),
+ * replace this set by a single constraint
  *
  *	a x + u >= 0
  *
  * with u a new parameter with constraints
  *
- *	u <= b_i(p)
+ *	s_i u <= b_i(p)
  *
  * Any solution to the new system is also a solution for the original system
  * since
  *
- *	a x >= -u >= -b_i(p)
+ *	s_i a x >= -s_i u >= -b_i(p)
  *
- * Moreover, m = min_i(b_i(p)) satisfies the constraints on u and can
- * therefore be plugged into the solution.
+ * Moreover, m = min_i(floor(b_i(p)/s_i)) satisfies the constraints on u and
+ * can therefore be plugged into the solution, since, a x being integral,
+ * s_i a x + b_i(p) >= 0 is equivalent to a x + floor(b_i(p)/s_i) >= 0.
+ * The constraints on u are stored in "cst", in the space of the domain
+ * extended with u.
  */
 static TYPE *SF(basic_map_partial_lexopt_symm,SUFFIX)(
 	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
-	__isl_give isl_set **empty, int max, int first, int second)
+	__isl_give isl_set **empty, int max,
+	struct isl_parallel_family *family)
 {
-	int i, n, k;
-	int *list = NULL;
+	int i, k;
 	unsigned n_in, n_out, n_div;
 	isl_ctx *ctx;
-	isl_vec *var = NULL;
 	isl_mat *cst = NULL;
 	isl_space *map_space, *set_space;
 
@@ -66,32 +68,20 @@ static TYPE *SF(basic_map_partial_lexopt_symm,SUFFIX)(
 	n_out = isl_basic_map_dim(bmap, isl_dim_all) - n_in;
 
 	ctx = isl_basic_map_get_ctx(bmap);
-	list = isl_alloc_array(ctx, int, bmap->n_ineq);
-	var = isl_vec_alloc(ctx, n_out);
-	if ((bmap->n_ineq && !list) || (n_out && !var))
-		goto error;
-
-	list[0] = first;
-	list[1] = second;
-	isl_seq_cpy(var->el, bmap->ineq[first] + 1 + n_in, n_out);
-	for (i = second + 1, n = 2; i < bmap->n_ineq; ++i) {
-		if (isl_seq_eq(var->el, bmap->ineq[i] + 1 + n_in, n_out) &&
-		    all_single_occurrence(bmap, i, n_in))
-			list[n++] = i;
-	}
-
-	cst = isl_mat_alloc(ctx, n, 1 + n_in);
+	cst = isl_mat_alloc(ctx, family->n, 1 + n_in + 1);
 	if (!cst)
 		goto error;
 
-	for (i = 0; i < n; ++i)
-		isl_seq_cpy(cst->row[i], bmap->ineq[list[i]], 1 + n_in);
+	for (i = 0; i < family->n; ++i) {
+		isl_seq_cpy(cst->row[i], bmap->ineq[family->list[i]], 1 + n_in);
+		isl_int_neg(cst->row[i][1 + n_in], family->scale->el[i]);
+	}
 
 	bmap = isl_basic_map_cow(bmap);
 	if (!bmap)
 		goto error;
-	for (i = n - 1; i >= 0; --i)
-		if (isl_basic_map_drop_inequality(bmap, list[i]) < 0)
+	for (i = family->n - 1; i >= 0; --i)
+		if (isl_basic_map_drop_inequality(bmap, family->list[i]) < 0)
 			goto error;
 
 	bmap = isl_basic_map_add_dims(bmap, isl_dim_in, 1);
@@ -101,32 +91,28 @@ static TYPE *SF(basic_map_partial_lexopt_symm,SUFFIX)(
 		goto error;
 	isl_seq_clr(bmap->ineq[k], 1 + n_in);
 	isl_int_set_si(bmap->ineq[k][1 + n_in], 1);
-	isl_seq_cpy(bmap->ineq[k] + 1 + n_in + 1, var->el, n_out);
+	isl_seq_clr(bmap->ineq[k] + 1 + n_in + 1, n_out);
+	isl_seq_cpy(bmap->ineq[k] + 1 + n_in + 1, family->var->el,
+		    family->var->size);
 	bmap = isl_basic_map_finalize(bmap);
 
 	n_div = isl_basic_set_dim(dom, isl_dim_div);
 	dom = isl_basic_set_add_dims(dom, isl_dim_set, 1);
-	dom = isl_basic_set_extend_constraints(dom, 0, n);
-	for (i = 0; i < n; ++i) {
+	dom = isl_basic_set_extend_constraints(dom, 0, family->n);
+	for (i = 0; i < family->n; ++i) {
 		k = isl_basic_set_alloc_inequality(dom);
 		if (k < 0)
 			goto error;
-		isl_seq_cpy(dom->ineq[k], cst->row[i], 1 + n_in);
-		isl_int_set_si(dom->ineq[k][1 + n_in], -1);
-		isl_seq_clr(dom->ineq[k] + 1 + n_in + 1, n_div);
+		isl_seq_cpy(dom->ineq[k], cst->row[i], cst->n_col);
+		isl_seq_clr(dom->ineq[k] + cst->n_col, n_div);
 	}
 
-	isl_vec_free(var);
-	free(list);
-
 	return SF(basic_map_partial_lexopt_symm_core,SUFFIX)(bmap, dom, empty,
 						max, cst, map_space, set_space);
 error:
 	isl_space_free(map_space);
 	isl_space_free(set_space);
 	isl_mat_free(cst);
-	isl_vec_free(var);
-	free(list);
 	isl_basic_set_free(dom);
 	isl_basic_map_free(bmap);
 	return NULL;
@@ -146,22 +132,26 @@ static __isl_give TYPE *SF(basic_map_partial_lexopt,SUFFIX)(
 	__isl_give isl_set **empty, int max)
 {
 	int par = 0;
-	int first, second;
+	struct isl_parallel_family family = { 0 };
+	TYPE *res;
 
 	if (!bmap)
 		goto error;
 
 	if (bmap->ctx->opt->pip_symmetry)
-		par = parallel_constraints(bmap, &first, &second);
+		par = parallel_constraints(bmap, &family);
 	if (par < 0)
 		goto error;
 	if (!par)
 		return SF(basic_map_partial_lexopt_base,SUFFIX)(bmap, dom,
 								empty, max);
 
-	return SF(basic_map_partial_lexopt_symm,SUFFIX)(bmap, dom, empty, max,
-							 first, second);
+	res = SF(basic_map_partial_lexopt_symm,SUFFIX)(bmap, dom, empty, max,
+							&family);
+	parallel_family_clear(&family);
+	return res;
 error:
+	parallel_family_clear(&family);
 	isl_basic_set_free(dom);
 	isl_basic_map_free(bmap);
 	return NULL;
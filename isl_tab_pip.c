@@ -16,12 +16,17 @@
 #include <isl_seq.h>
 #include "isl_tab.h"
 #include "isl_sample.h"
+#include "isl_presolve.h"
 #include <isl_mat_private.h>
 #include <isl_vec_private.h>
 #include <isl_aff_private.h>
+#include <isl_local_space_private.h>
 #include <isl_constraint_private.h>
 #include <isl_options_private.h>
 #include <isl_config.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 /*
  * The implementation of parametric integer linear programming in this file
@@ -118,12 +123,18 @@ struct isl_context_op {
  *
  * "n_unknown" is the number of final unknown integer divisions
  * in the input domain.
+ * "shared" is set if the context is shared with other problems
+ * over the same domain (see isl_context_acquire) and
+ * then points to the corresponding entry in the isl_ctx.
  */
 struct isl_context {
 	struct isl_context_op *op;
 	int n_unknown;
+	struct isl_shared_context *shared;
 };
 
+static void isl_context_release(struct isl_context *context);
+
 struct isl_context_lex {
 	struct isl_context context;
 	struct isl_tab *tab;
@@ -166,6 +177,11 @@ struct isl_sol_callback {
  * in an isl_set, and
  * isl_sol_for, which calls a user-defined function for each part of
  * the solution.
+ *
+ * If "parallel" is set, then some parts of the context may be handed
+ * over to other threads.  The solutions in those parts are then
+ * not passed to "add" or "add_empty", but need to be collected
+ * separately through sol_parallel_collect.
  */
 struct isl_sol {
 	int error;
@@ -180,13 +196,17 @@ struct isl_sol {
 	void (*add_empty)(struct isl_sol *sol, struct isl_basic_set *bset);
 	void (*free)(struct isl_sol *sol);
 	struct isl_sol_callback	dec_level;
+	struct isl_sol_parallel *parallel;
 };
 
+static void sol_parallel_free(struct isl_sol_parallel *parallel);
+
 static void sol_free(struct isl_sol *sol)
 {
 	struct isl_partial_sol *partial, *next;
 	if (!sol)
 		return;
+	sol_parallel_free(sol->parallel);
 	for (partial = sol->partial; partial; partial = next) {
 		next = partial->next;
 		isl_basic_set_free(partial->dom);
@@ -542,6 +562,7 @@ static void sol_add(struct isl_sol *sol, struct isl_tab *tab)
 
 	isl_int_clear(m);
 
+	tab->mat->ctx->stats->pip_pieces++;
 	sol_push_sol(sol, bset, mat);
 	return;
 error2:
@@ -563,7 +584,7 @@ static void sol_map_free(struct isl_sol_map *sol_map)
 	if (!sol_map)
 		return;
 	if (sol_map->sol.context)
-		sol_map->sol.context->op->free(sol_map->sol.context);
+		isl_context_release(sol_map->sol.context);
 	isl_map_free(sol_map->map);
 	isl_set_free(sol_map->empty);
 	free(sol_map);
@@ -1109,11 +1130,15 @@ static int lexmin_pivot_col(struct isl_tab *tab, int row)
 	int j;
 	int col = tab->n_col;
 	isl_int *tr;
-	isl_int tmp;
+	isl_int *tmp;
+	isl_ctx *ctx;
 
 	tr = tab->mat->row[row] + 2 + tab->M;
 
-	isl_int_init(tmp);
+	ctx = isl_tab_get_ctx(tab);
+	tmp = isl_ctx_scratch_acquire(ctx, 1);
+	if (!tmp)
+		return -1;
 
 	for (j = tab->n_dead; j < tab->n_col; ++j) {
 		if (tab->col_var[j] >= 0 &&
@@ -1127,14 +1152,14 @@ static int lexmin_pivot_col(struct isl_tab *tab, int row)
 		if (col == tab->n_col)
 			col = j;
 		else
-			col = lexmin_col_pair(tab, row, col, j, tmp);
+			col = lexmin_col_pair(tab, row, col, j, tmp[0]);
 		isl_assert(tab->mat->ctx, col >= 0, goto error);
 	}
 
-	isl_int_clear(tmp);
+	isl_ctx_scratch_release(ctx, tmp, 1);
 	return col;
 error:
-	isl_int_clear(tmp);
+	isl_ctx_scratch_release(ctx, tmp, 1);
 	return -1;
 }
 
@@ -2179,8 +2204,109 @@ error:
 	return NULL;
 }
 
+/* Is "row" of the main tableau "tab" a row that may require a split,
+ * i.e., a row of a non-negative variable for which the sign
+ * in the current context is unknown?
+ */
+static int is_split_candidate(struct isl_tab *tab, int row)
+{
+	if (!isl_tab_var_from_row(tab, row)->is_nonneg)
+		return 0;
+	return tab->row_sign[row] == isl_tab_row_any;
+}
+
+/* Return the number of coefficients of the parameters and
+ * the integer divisions in "row" of the main tableau "tab"
+ * that are not integral.
+ * Each of these coefficients may require a new integer division
+ * to be added to the context later on.
+ */
+static int n_non_integer_parameter(struct isl_tab *tab, int row)
+{
+	int i;
+	int col;
+	int n = 0;
+	unsigned off = 2 + tab->M;
+
+	for (i = 0; i < tab->n_param; ++i) {
+		if (tab->var[i].is_row)
+			continue;
+		col = tab->var[i].index;
+		if (!isl_int_is_divisible_by(tab->mat->row[row][off + col],
+						tab->mat->row[row][0]))
+			n++;
+	}
+	for (i = 0; i < tab->n_div; ++i) {
+		if (tab->var[tab->n_var - tab->n_div + i].is_row)
+			continue;
+		col = tab->var[tab->n_var - tab->n_div + i].index;
+		if (!isl_int_is_divisible_by(tab->mat->row[row][off + col],
+						tab->mat->row[row][0]))
+			n++;
+	}
+	return n;
+}
+
+/* Count the rows of the main tableau "tab", other than "split",
+ * that may require a split and that, in the context represented by
+ * "context_tab", are known to be non-negative ("*n_pos") or
+ * known to be negative ("*n_neg").
+ * If "context_tab" is empty, then all those rows are counted
+ * as being non-negative.
+ * "context_tab" is restored to its original state before returning.
+ */
+static int count_determined_rows(struct isl_tab *tab, int split,
+	struct isl_tab *context_tab, int *n_pos, int *n_neg)
+{
+	struct isl_tab_undo *snap;
+	int row;
+
+	*n_pos = 0;
+	*n_neg = 0;
+	snap = isl_tab_snap(context_tab);
+
+	for (row = tab->n_redundant; row < tab->n_row; ++row) {
+		struct isl_tab_var *var;
+		struct isl_vec *ineq;
+		int ok;
+
+		if (row == split)
+			continue;
+		if (!is_split_candidate(tab, row))
+			continue;
+		if (context_tab->empty) {
+			(*n_pos)++;
+			continue;
+		}
+
+		ineq = get_row_parameter_ineq(tab, row);
+		if (!ineq)
+			return -1;
+		ok = isl_tab_add_ineq(context_tab, ineq->el) >= 0;
+		isl_vec_free(ineq);
+		if (!ok)
+			return -1;
+		var = &context_tab->con[context_tab->n_con - 1];
+		if (context_tab->empty) {
+			(*n_neg)++;
+		} else {
+			ok = isl_tab_min_at_most_neg_one(context_tab, var);
+			if (ok < 0)
+				return -1;
+			if (!ok)
+				(*n_pos)++;
+		}
+		if (isl_tab_rollback(context_tab, snap) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
 /* Given a main tableau where more than one row requires a split,
  * determine and return the "best" row to split on.
+ * The heuristic that determines which row is considered best
+ * is selected by the pip_split option.
  *
  * Given two rows in the main tableau, if the inequality corresponding
  * to the first row is redundant with respect to that of the second row
@@ -2189,80 +2315,99 @@ error:
  * (In the negative part a pivot will have to be performed and just about
  * anything can happen to the sign of the other row.)
  *
- * As a simple heuristic, we therefore select the row that makes the most
- * of the other rows redundant.
- *
- * Perhaps it would also be useful to look at the number of constraints
- * that conflict with any given constraint.
+ * As a simple heuristic, ISL_PIP_SPLIT_REDUNDANT therefore selects the row
+ * that makes the most of the other rows redundant.
+ * ISL_PIP_SPLIT_CONSTRAINED also takes into account the other rows
+ * that conflict with the row, i.e., that are known to be negative
+ * in the positive part.  It selects the row that determines the sign
+ * of the most other rows.
+ * ISL_PIP_SPLIT_LOOKAHEAD additionally looks at the negative part and
+ * selects the row for which the smallest number of other rows
+ * still require a split in the two parts combined.
+ * ISL_PIP_SPLIT_DIVS selects a row with the smallest number
+ * of non-integral parameter coefficients, since these may result
+ * in integer divisions getting added to the context,
+ * breaking ties in the same way as ISL_PIP_SPLIT_REDUNDANT.
+ * The context tableau is not consulted for rows with more
+ * non-integral parameter coefficients than the best row so far.
  *
  * best is the best row so far (-1 when we have not found any row yet).
- * best_r is the number of other rows made redundant by row best.
- * When best is still -1, bset_r is meaningless, but it is initialized
- * to some arbitrary value (0) anyway.  Without this redundant initialization
- * valgrind may warn about uninitialized memory accesses when isl
- * is compiled with some versions of gcc.
+ * best_score is the score of row best and best_frac is its number of
+ * non-integral parameter coefficients (only used by ISL_PIP_SPLIT_DIVS).
+ * When best is still -1, best_score and best_frac are meaningless,
+ * but they are initialized to some arbitrary value (0) anyway.
+ * Without this redundant initialization valgrind may warn about
+ * uninitialized memory accesses when isl is compiled with some versions
+ * of gcc.
  */
 static int best_split(struct isl_tab *tab, struct isl_tab *context_tab)
 {
 	struct isl_tab_undo *snap;
+	int strategy;
 	int split;
 	int row;
+	int n_cand = 0;
 	int best = -1;
-	int best_r = 0;
+	int best_score = 0;
+	int best_frac = 0;
+
+	strategy = tab->mat->ctx->opt->pip_split;
 
 	if (isl_tab_extend_cons(context_tab, 2) < 0)
 		return -1;
 
 	snap = isl_tab_snap(context_tab);
 
+	for (row = tab->n_redundant; row < tab->n_row; ++row)
+		if (is_split_candidate(tab, row))
+			n_cand++;
+
 	for (split = tab->n_redundant; split < tab->n_row; ++split) {
-		struct isl_tab_undo *snap2;
 		struct isl_vec *ineq = NULL;
-		int r = 0;
+		int n_pos = 0, n_neg = 0;
+		int n_frac = 0;
+		int score;
 		int ok;
 
-		if (!isl_tab_var_from_row(tab, split)->is_nonneg)
-			continue;
-		if (tab->row_sign[split] != isl_tab_row_any)
+		if (!is_split_candidate(tab, split))
 			continue;
+		if (strategy == ISL_PIP_SPLIT_DIVS) {
+			n_frac = n_non_integer_parameter(tab, split);
+			if (best != -1 && n_frac > best_frac)
+				continue;
+		}
 
 		ineq = get_row_parameter_ineq(tab, split);
 		if (!ineq)
 			return -1;
 		ok = isl_tab_add_ineq(context_tab, ineq->el) >= 0;
+		if (ok)
+			ok = count_determined_rows(tab, split, context_tab,
+						    &n_pos, &n_neg) >= 0;
+		if (ok && strategy == ISL_PIP_SPLIT_LOOKAHEAD) {
+			score = -(n_cand - 1 - n_pos - n_neg);
+			ok = isl_tab_rollback(context_tab, snap) >= 0;
+			isl_seq_neg(ineq->el, ineq->el, ineq->size);
+			isl_int_sub_ui(ineq->el[0], ineq->el[0], 1);
+			if (ok)
+				ok = isl_tab_add_ineq(context_tab, ineq->el) >= 0;
+			if (ok)
+				ok = count_determined_rows(tab, split,
+					    context_tab, &n_pos, &n_neg) >= 0;
+			score -= n_cand - 1 - n_pos - n_neg;
+		} else if (strategy == ISL_PIP_SPLIT_CONSTRAINED) {
+			score = n_pos + n_neg;
+		} else {
+			score = n_pos;
+		}
 		isl_vec_free(ineq);
 		if (!ok)
 			return -1;
 
-		snap2 = isl_tab_snap(context_tab);
-
-		for (row = tab->n_redundant; row < tab->n_row; ++row) {
-			struct isl_tab_var *var;
-
-			if (row == split)
-				continue;
-			if (!isl_tab_var_from_row(tab, row)->is_nonneg)
-				continue;
-			if (tab->row_sign[row] != isl_tab_row_any)
-				continue;
-
-			ineq = get_row_parameter_ineq(tab, row);
-			if (!ineq)
-				return -1;
-			ok = isl_tab_add_ineq(context_tab, ineq->el) >= 0;
-			isl_vec_free(ineq);
-			if (!ok)
-				return -1;
-			var = &context_tab->con[context_tab->n_con - 1];
-			if (!context_tab->empty &&
-			    !isl_tab_min_at_most_neg_one(context_tab, var))
-				r++;
-			if (isl_tab_rollback(context_tab, snap2) < 0)
-				return -1;
-		}
-		if (best == -1 || r > best_r) {
+		if (best == -1 || n_frac < best_frac || score > best_score) {
 			best = split;
-			best_r = r;
+			best_score = score;
+			best_frac = n_frac;
 		}
 		if (isl_tab_rollback(context_tab, snap) < 0)
 			return -1;
@@ -3454,6 +3599,7 @@ static struct isl_context *isl_context_alloc(__isl_keep isl_basic_set *dom)
 	if (!context)
 		return NULL;
 
+	context->shared = NULL;
 	first = isl_basic_set_first_unknown_div(dom);
 	if (first < 0)
 		return context->op->free(context);
@@ -3462,6 +3608,207 @@ static struct isl_context *isl_context_alloc(__isl_keep isl_basic_set *dom)
 	return context;
 }
 
+/* A context that is shared by the lexicographic optimization problems
+ * over the same domain, e.g., the problems corresponding to
+ * the disjuncts of an isl_map.
+ *
+ * "dom" is the domain from which "context" was constructed and
+ * "saved" is a snapshot of "context" in its original state.
+ * "in_use" is set while "context" is being used by some isl_sol.
+ * An entry is not in use if "context" is NULL.
+ */
+struct isl_shared_context {
+	isl_basic_set *dom;
+	struct isl_context *context;
+	void *saved;
+	int in_use;
+};
+
+/* The maximal number of contexts that are kept for sharing.
+ */
+#define ISL_N_SHARED_CONTEXT	4
+
+/* The contexts that may currently be shared.
+ *
+ * "depth" is the number of calls to isl_tab_shared_contexts_start
+ * without a corresponding call to isl_tab_shared_contexts_finish.
+ */
+struct isl_shared_contexts {
+	int depth;
+	struct isl_shared_context entry[ISL_N_SHARED_CONTEXT];
+};
+
+/* Free the context of "entry" (which is assumed not to be in use)
+ * and mark the entry as unused.
+ */
+static void shared_context_clear(struct isl_shared_context *entry)
+{
+	if (!entry->context)
+		return;
+	entry->context->shared = NULL;
+	entry->context->op->discard(entry->saved);
+	entry->context->op->free(entry->context);
+	isl_basic_set_free(entry->dom);
+	entry->context = NULL;
+	entry->dom = NULL;
+	entry->saved = NULL;
+	entry->in_use = 0;
+}
+
+/* Start allowing the contexts of lexicographic optimization problems
+ * over the same domain to be shared until the matching call
+ * to isl_tab_shared_contexts_finish.
+ * Calls to these functions may be nested.
+ */
+isl_stat isl_tab_shared_contexts_start(isl_ctx *ctx)
+{
+	if (!ctx->shared_contexts) {
+		ctx->shared_contexts = isl_calloc_type(ctx,
+						struct isl_shared_contexts);
+		if (!ctx->shared_contexts)
+			return isl_stat_error;
+	}
+	ctx->shared_contexts->depth++;
+	return isl_stat_ok;
+}
+
+/* Stop sharing contexts, freeing all shared contexts
+ * if this call matches the outermost call
+ * to isl_tab_shared_contexts_start.
+ */
+void isl_tab_shared_contexts_finish(isl_ctx *ctx)
+{
+	int i;
+	struct isl_shared_contexts *shared = ctx->shared_contexts;
+
+	if (!shared || --shared->depth > 0)
+		return;
+	for (i = 0; i < ISL_N_SHARED_CONTEXT; ++i)
+		shared_context_clear(&shared->entry[i]);
+	free(shared);
+	ctx->shared_contexts = NULL;
+}
+
+/* Is "entry" a context that is not in use and that was constructed
+ * from a domain that is obviously the same as "dom"?
+ */
+static isl_bool shared_context_matches(struct isl_shared_context *entry,
+	__isl_keep isl_basic_set *dom)
+{
+	isl_bool equal;
+
+	if (!entry->context || entry->in_use)
+		return isl_bool_false;
+	if (ISL_F_ISSET(entry->dom, ISL_BASIC_SET_RATIONAL) !=
+	    ISL_F_ISSET(dom, ISL_BASIC_SET_RATIONAL))
+		return isl_bool_false;
+	equal = isl_space_is_equal(entry->dom->dim, dom->dim);
+	if (equal < 0 || !equal)
+		return equal;
+	return isl_basic_map_plain_cmp(entry->dom, dom) == 0;
+}
+
+/* Return a context corresponding to "dom".
+ *
+ * If contexts may be shared (see isl_tab_shared_contexts_start) and
+ * there is a shared context for the same domain that is not in use,
+ * then return that context, which is in its original state.
+ * Otherwise, construct a new context and, if contexts may be shared,
+ * keep track of it such that it can be reused once it is released.
+ * This requires a free entry or, failing that, an entry that
+ * is not in use, the context of which is then discarded.
+ * If there is no such entry, then the new context is simply
+ * not shared.
+ */
+static struct isl_context *isl_context_acquire(__isl_keep isl_basic_set *dom)
+{
+	int i;
+	isl_ctx *ctx;
+	struct isl_shared_contexts *shared;
+	struct isl_shared_context *entry;
+	struct isl_context *context;
+
+	if (!dom)
+		return NULL;
+
+	ctx = isl_basic_set_get_ctx(dom);
+	shared = ctx->shared_contexts;
+	if (!shared)
+		return isl_context_alloc(dom);
+
+	for (i = 0; i < ISL_N_SHARED_CONTEXT; ++i) {
+		isl_bool match;
+
+		entry = &shared->entry[i];
+		match = shared_context_matches(entry, dom);
+		if (match < 0)
+			return NULL;
+		if (!match)
+			continue;
+		entry->in_use = 1;
+		ctx->stats->pip_shared_contexts++;
+		return entry->context;
+	}
+
+	context = isl_context_alloc(dom);
+	if (!context)
+		return NULL;
+
+	entry = NULL;
+	for (i = 0; i < ISL_N_SHARED_CONTEXT; ++i) {
+		if (!shared->entry[i].context) {
+			entry = &shared->entry[i];
+			break;
+		}
+		if (!entry && !shared->entry[i].in_use)
+			entry = &shared->entry[i];
+	}
+	if (!entry)
+		return context;
+	shared_context_clear(entry);
+	entry->saved = context->op->save(context);
+	if (!entry->saved)
+		return context;
+	entry->dom = isl_basic_set_copy(dom);
+	entry->context = context;
+	entry->in_use = 1;
+	context->shared = entry;
+
+	return context;
+}
+
+/* Release "context", which is no longer needed by its isl_sol.
+ *
+ * If "context" is not shared, then it is simply freed.
+ * Otherwise, it is restored to its original state such that
+ * it can be reused by another problem over the same domain.
+ * Note that this needs to happen before the isl_sol itself is freed
+ * since rolling back the context may call the callbacks of the isl_sol.
+ * If anything goes wrong, then the context is no longer shared.
+ */
+static void isl_context_release(struct isl_context *context)
+{
+	struct isl_shared_context *entry;
+
+	if (!context)
+		return;
+	entry = context->shared;
+	if (!entry) {
+		context->op->free(context);
+		return;
+	}
+
+	entry->in_use = 0;
+	if (context->op->is_ok(context)) {
+		context->op->restore(context, entry->saved);
+		entry->saved = NULL;
+		if (context->op->is_ok(context))
+			entry->saved = context->op->save(context);
+	}
+	if (!entry->saved || !context->op->is_ok(context))
+		shared_context_clear(entry);
+}
+
 /* Construct an isl_sol_map structure for accumulating the solution.
  * If track_empty is set, then we also keep track of the parts
  * of the context where there is no solution.
@@ -3494,7 +3841,7 @@ static struct isl_sol *sol_map_init(struct isl_basic_map *bmap,
 	if (!sol_map->map)
 		goto error;
 
-	sol_map->sol.context = isl_context_alloc(dom);
+	sol_map->sol.context = isl_context_acquire(dom);
 	if (!sol_map->sol.context)
 		goto error;
 
@@ -3684,93 +4031,647 @@ error:
 	return isl_tab_row_unknown;
 }
 
-static void find_solutions(struct isl_sol *sol, struct isl_tab *tab);
-
-/* Find solutions for values of the parameters that satisfy the given
- * inequality.
- *
- * We currently take a snapshot of the context tableau that is reset
- * when we return from this function, while we make a copy of the main
- * tableau, leaving the original main tableau untouched.
- * These are fairly arbitrary choices.  Making a copy also of the context
- * tableau would obviate the need to undo any changes made to it later,
- * while taking a snapshot of the main tableau could reduce memory usage.
- * If we were to switch to taking a snapshot of the main tableau,
- * we would have to keep in mind that we need to save the row signs
- * and that we need to do this before saving the current basis
- * such that the basis has been restore before we restore the row signs.
+/* Return a copy of "bmap" in the space "space", which may live
+ * in a different isl_ctx, but which has the same dimensions
+ * as the space of "bmap".
+ * Only the constraints, the integer divisions and the rationality
+ * of "bmap" are copied such that the result does not share
+ * any objects with "bmap".
  */
-static void find_in_pos(struct isl_sol *sol, struct isl_tab *tab, isl_int *ineq)
+static __isl_give isl_basic_map *basic_map_transfer(
+	__isl_keep isl_basic_map *bmap, __isl_take isl_space *space)
 {
-	void *saved;
-
-	if (!sol->context)
-		goto error;
-	saved = sol->context->op->save(sol->context);
+	int i, k;
+	unsigned total;
+	isl_basic_map *res;
 
-	tab = isl_tab_dup(tab);
-	if (!tab)
+	if (!bmap || !space)
 		goto error;
 
-	sol->context->op->add_ineq(sol->context, ineq, 0, 1);
-
-	find_solutions(sol, tab);
+	total = isl_basic_map_total_dim(bmap);
+	res = isl_basic_map_alloc_space(space,
+					bmap->n_div, bmap->n_eq, bmap->n_ineq);
+	for (i = 0; i < bmap->n_div; ++i) {
+		k = isl_basic_map_alloc_div(res);
+		if (k < 0)
+			return isl_basic_map_free(res);
+		isl_seq_cpy(res->div[k], bmap->div[i], 2 + total);
+	}
+	for (i = 0; i < bmap->n_eq; ++i) {
+		k = isl_basic_map_alloc_equality(res);
+		if (k < 0)
+			return isl_basic_map_free(res);
+		isl_seq_cpy(res->eq[k], bmap->eq[i], 1 + total);
+	}
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		k = isl_basic_map_alloc_inequality(res);
+		if (k < 0)
+			return isl_basic_map_free(res);
+		isl_seq_cpy(res->ineq[k], bmap->ineq[i], 1 + total);
+	}
+	if (res && ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
+		ISL_F_SET(res, ISL_BASIC_MAP_RATIONAL);
 
-	if (!sol->error)
-		sol->context->op->restore(sol->context, saved);
-	else
-		sol->context->op->discard(saved);
-	return;
+	return isl_basic_map_finalize(res);
 error:
-	sol->error = 1;
+	isl_space_free(space);
+	return NULL;
 }
 
-/* Record the absence of solutions for those values of the parameters
- * that do not satisfy the given inequality with equality.
+/* Return a copy of "map" in the space "space", which may live
+ * in a different isl_ctx.
+ * See basic_map_transfer.
  */
-static void no_sol_in_strict(struct isl_sol *sol,
-	struct isl_tab *tab, struct isl_vec *ineq)
+static __isl_give isl_map *map_transfer(__isl_keep isl_map *map,
+	__isl_take isl_space *space)
 {
-	int empty;
-	void *saved;
-
-	if (!sol->context || sol->error)
-		goto error;
-	saved = sol->context->op->save(sol->context);
-
-	isl_int_sub_ui(ineq->el[0], ineq->el[0], 1);
+	int i;
+	unsigned flags = 0;
+	isl_map *res;
 
-	sol->context->op->add_ineq(sol->context, ineq->el, 1, 0);
-	if (!sol->context)
+	if (!map || !space)
 		goto error;
 
-	empty = tab->empty;
-	tab->empty = 1;
-	sol_add(sol, tab);
-	tab->empty = empty;
+	if (ISL_F_ISSET(map, ISL_MAP_DISJOINT))
+		flags = ISL_MAP_DISJOINT;
+	res = isl_map_alloc_space(isl_space_copy(space), map->n, flags);
+	for (i = 0; i < map->n; ++i) {
+		isl_basic_map *bmap;
 
-	isl_int_add_ui(ineq->el[0], ineq->el[0], 1);
+		bmap = basic_map_transfer(map->p[i], isl_space_copy(space));
+		res = isl_map_add_basic_map(res, bmap);
+	}
 
-	sol->context->op->restore(sol->context, saved);
-	return;
+	isl_space_free(space);
+	return res;
 error:
-	sol->error = 1;
+	isl_space_free(space);
+	return NULL;
 }
 
-/* Reset all row variables that are marked to have a sign that may
- * be both positive and negative to have an unknown sign.
+/* Return a copy of "mat" in "ctx", which may be different
+ * from the isl_ctx of "mat".
  */
-static void reset_any_to_unknown(struct isl_tab *tab)
+static __isl_give isl_mat *mat_transfer(__isl_keep isl_mat *mat,
+	isl_ctx *ctx)
 {
-	int row;
-
-	for (row = tab->n_redundant; row < tab->n_row; ++row) {
-		if (!isl_tab_var_from_row(tab, row)->is_nonneg)
-			continue;
-		if (tab->row_sign[row] == isl_tab_row_any)
-			tab->row_sign[row] = isl_tab_row_unknown;
-	}
-}
+	int i;
+	isl_mat *res;
+
+	if (!mat)
+		return NULL;
+
+	res = isl_mat_alloc(ctx, mat->n_row, mat->n_col);
+	if (!res)
+		return NULL;
+	for (i = 0; i < mat->n_row; ++i)
+		isl_seq_cpy(res->row[i], mat->row[i], mat->n_col);
+
+	return res;
+}
+
+/* Return a copy of "aff" with domain space "space", which may live
+ * in a different isl_ctx, but which has the same dimensions
+ * as the domain space of "aff".
+ * Only the integer divisions and the coefficients of "aff" are copied.
+ */
+static __isl_give isl_aff *aff_transfer(__isl_keep isl_aff *aff,
+	__isl_take isl_space *space)
+{
+	isl_mat *div;
+	isl_local_space *ls;
+	isl_aff *res;
+
+	if (!aff || !space)
+		goto error;
+
+	div = mat_transfer(aff->ls->div, isl_space_get_ctx(space));
+	ls = isl_local_space_alloc_div(space, div);
+	res = isl_aff_alloc(ls);
+	if (!res)
+		return NULL;
+	isl_seq_cpy(res->v->el, aff->v->el, aff->v->size);
+
+	return res;
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
+/* Return a copy of "ma" in the space "space", which may live
+ * in a different isl_ctx, but which has the same dimensions
+ * as the space of "ma".
+ */
+static __isl_give isl_multi_aff *multi_aff_transfer(
+	__isl_keep isl_multi_aff *ma, __isl_take isl_space *space)
+{
+	int i;
+	isl_multi_aff *res;
+
+	if (!ma || !space)
+		goto error;
+
+	res = isl_multi_aff_zero(isl_space_copy(space));
+	for (i = 0; i < ma->n; ++i) {
+		isl_aff *aff;
+
+		aff = aff_transfer(ma->p[i],
+				    isl_space_domain(isl_space_copy(space)));
+		res = isl_multi_aff_set_aff(res, i, aff);
+	}
+
+	isl_space_free(space);
+	return res;
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
+/* Return a copy of "pma" in the space "space", which may live
+ * in a different isl_ctx, but which has the same dimensions
+ * as the space of "pma".
+ * The cells of "pma" are assumed to be disjoint.
+ */
+static __isl_give isl_pw_multi_aff *pw_multi_aff_transfer(
+	__isl_keep isl_pw_multi_aff *pma, __isl_take isl_space *space)
+{
+	int i;
+	isl_pw_multi_aff *res;
+
+	if (!pma || !space)
+		goto error;
+
+	res = isl_pw_multi_aff_empty(isl_space_copy(space));
+	for (i = 0; i < pma->n; ++i) {
+		isl_set *set;
+		isl_multi_aff *ma;
+
+		set = map_transfer(pma->p[i].set,
+				    isl_space_domain(isl_space_copy(space)));
+		ma = multi_aff_transfer(pma->p[i].maff, isl_space_copy(space));
+		res = isl_pw_multi_aff_add_disjoint(res,
+					isl_pw_multi_aff_alloc(set, ma));
+	}
+
+	isl_space_free(space);
+	return res;
+error:
+	isl_space_free(space);
+	return NULL;
+}
+
+#ifdef HAVE_PTHREAD_H
+
+/* A part of the context that has been handed over to a separate thread.
+ *
+ * "ctx" is the isl_ctx of the thread.
+ * "bmap" and "dom" are the input problem and the part of the context
+ * in "ctx", which are consumed by the thread.
+ * "max" is set if the lexicographic maximum is being computed and
+ * "track_empty" is set if the part of the context without solutions
+ * needs to be computed.
+ * "use_pma" is set if the result should be computed
+ * as an isl_pw_multi_aff rather than as an isl_map.
+ * "map" or "pma" and "empty" are the results computed
+ * by the thread in "ctx".
+ * "running" is set while the thread has not been joined yet.
+ */
+struct isl_sol_branch {
+	pthread_t thread;
+	int running;
+	isl_ctx *ctx;
+	int max;
+	int track_empty;
+	int use_pma;
+	isl_basic_map *bmap;
+	isl_basic_set *dom;
+	isl_map *map;
+	isl_pw_multi_aff *pma;
+	isl_set *empty;
+};
+
+/* Information about the parts of the context of an isl_sol
+ * that are handed over to other threads.
+ *
+ * "bmap" is the input problem (in the original isl_ctx), with
+ * its original integer divisions, "max" is set if the lexicographic
+ * maximum is being computed and "track_empty" is set if the parts
+ * of the context without solutions need to be computed.
+ * "use_pma" is set if the results of the other threads should be
+ * computed as isl_pw_multi_affs rather than as isl_maps.
+ * "branch" holds the "n_branch" parts that have been handed over
+ * so far, in the order in which they were handed over,
+ * with room for "max_branch" parts.
+ */
+struct isl_sol_parallel {
+	isl_basic_map *bmap;
+	int max;
+	int track_empty;
+	int use_pma;
+	int n_branch;
+	int max_branch;
+	struct isl_sol_branch *branch;
+};
+
+/* Free "branch" and its isl_ctx, waiting for its thread
+ * to finish first if it has not been joined yet.
+ */
+static void sol_branch_clear(struct isl_sol_branch *branch)
+{
+	if (branch->running)
+		pthread_join(branch->thread, NULL);
+	branch->running = 0;
+	isl_basic_map_free(branch->bmap);
+	isl_basic_set_free(branch->dom);
+	isl_map_free(branch->map);
+	isl_pw_multi_aff_free(branch->pma);
+	isl_set_free(branch->empty);
+	branch->bmap = NULL;
+	branch->dom = NULL;
+	branch->map = NULL;
+	branch->pma = NULL;
+	branch->empty = NULL;
+	if (branch->ctx)
+		isl_ctx_free(branch->ctx);
+	branch->ctx = NULL;
+}
+
+static void sol_parallel_free(struct isl_sol_parallel *parallel)
+{
+	int i;
+
+	if (!parallel)
+		return;
+
+	for (i = 0; i < parallel->n_branch; ++i)
+		sol_branch_clear(&parallel->branch[i]);
+	free(parallel->branch);
+	isl_basic_map_free(parallel->bmap);
+	free(parallel);
+}
+
+/* Allocate an isl_sol_parallel for computing the lexicographic
+ * optimum of "bmap" in parallel, if the pip-threads option
+ * allows for more than one thread.
+ * "use_pma" is set if the optimum is computed as an isl_pw_multi_aff.
+ * Return NULL if the computation should be performed sequentially
+ * (or if an error occurred).
+ */
+static struct isl_sol_parallel *sol_parallel_alloc(
+	__isl_keep isl_basic_map *bmap, int max, int track_empty, int use_pma)
+{
+	isl_ctx *ctx;
+	struct isl_sol_parallel *parallel;
+
+	if (!bmap)
+		return NULL;
+	ctx = isl_basic_map_get_ctx(bmap);
+	if (ctx->opt->pip_threads <= 1)
+		return NULL;
+
+	parallel = isl_calloc_type(ctx, struct isl_sol_parallel);
+	if (!parallel)
+		return NULL;
+	parallel->max_branch = ctx->opt->pip_threads - 1;
+	parallel->branch = isl_calloc_array(ctx, struct isl_sol_branch,
+						parallel->max_branch);
+	parallel->bmap = isl_basic_map_copy(bmap);
+	parallel->max = max;
+	parallel->track_empty = track_empty;
+	parallel->use_pma = use_pma;
+	if (!parallel->branch || !parallel->bmap) {
+		sol_parallel_free(parallel);
+		return NULL;
+	}
+
+	return parallel;
+}
+
+/* Compute the lexicographic optimum of the problem of "branch"
+ * in the isl_ctx of "branch", in the form requested by "branch".
+ */
+static void *solve_branch(void *user)
+{
+	struct isl_sol_branch *branch = user;
+	unsigned flags = branch->max ? ISL_OPT_MAX : 0;
+	isl_set **empty = branch->track_empty ? &branch->empty : NULL;
+
+	if (branch->use_pma)
+		branch->pma = isl_tab_basic_map_partial_lexopt_pw_multi_aff(
+				branch->bmap, branch->dom, empty, flags);
+	else
+		branch->map = isl_tab_basic_map_partial_lexopt(branch->bmap,
+						branch->dom, empty, flags);
+	branch->bmap = NULL;
+	branch->dom = NULL;
+
+	return NULL;
+}
+
+/* Try and hand over the part of the context of "sol" where
+ * "ineq" is satisfied to another thread.
+ * Return 1 if this part has been handed over and
+ * 0 if it should be handled by the caller.
+ *
+ * The part is only handed over if there is still room for another thread.
+ * The thread gets an isl_ctx of its own, with all options and
+ * the operation quota copied from the original isl_ctx (except that
+ * the thread handles its part sequentially), along with copies of
+ * the input problem and of the context restricted to "ineq".
+ * It then solves the problem on this context from scratch.
+ * Note that the context may involve integer divisions that
+ * do not appear in the input problem, but these are
+ * added to the problem by isl_tab_basic_map_partial_lexopt.
+ * If anything goes wrong while setting up the thread, then
+ * the part is simply handled by the caller.
+ */
+static int sol_hand_off(struct isl_sol *sol, __isl_keep isl_vec *ineq)
+{
+	isl_ctx *ctx, *branch_ctx;
+	isl_space *space;
+	isl_basic_set *dom;
+	struct isl_sol_parallel *parallel = sol->parallel;
+	struct isl_sol_branch *branch;
+
+	if (!parallel || parallel->n_branch >= parallel->max_branch)
+		return 0;
+	dom = sol->context->op->peek_basic_set(sol->context);
+	if (!dom || ineq->size != 1 + isl_basic_set_total_dim(dom))
+		return 0;
+
+	ctx = isl_basic_set_get_ctx(dom);
+	branch = &parallel->branch[parallel->n_branch];
+	branch->ctx = branch_ctx = isl_ctx_alloc_worker(ctx);
+	if (!branch_ctx)
+		return 0;
+	branch_ctx->opt->pip_threads = 0;
+	branch->max = parallel->max;
+	branch->track_empty = parallel->track_empty;
+	branch->use_pma = parallel->use_pma;
+
+	space = isl_space_alloc(branch_ctx,
+			isl_basic_map_dim(parallel->bmap, isl_dim_param),
+			isl_basic_map_dim(parallel->bmap, isl_dim_in),
+			isl_basic_map_dim(parallel->bmap, isl_dim_out));
+	branch->bmap = basic_map_transfer(parallel->bmap, space);
+	space = isl_space_set_alloc(branch_ctx,
+			isl_basic_set_dim(dom, isl_dim_param),
+			isl_basic_set_dim(dom, isl_dim_set));
+	branch->dom = basic_map_transfer(dom, space);
+	branch->dom = isl_basic_map_add_ineq(branch->dom, ineq->el);
+	if (!branch->bmap || !branch->dom ||
+	    pthread_create(&branch->thread, NULL, &solve_branch, branch) != 0) {
+		sol_branch_clear(branch);
+		return 0;
+	}
+	branch->running = 1;
+	parallel->n_branch++;
+	ctx->stats->pip_parallel_branches++;
+
+	return 1;
+}
+
+/* Wait for the thread of "branch" of "parallel" to finish and
+ * add the operations and statistics of its isl_ctx to "ctx",
+ * the isl_ctx of "parallel".
+ * If "empty" is not NULL, then add the part of the context
+ * without solutions computed by the thread to "*empty",
+ * copying it to the space of "*empty", which has the same dimensions
+ * as that used by the thread.
+ * An error in the thread is reported in "ctx"
+ * with the error code of the thread.
+ */
+static isl_stat sol_branch_collect(isl_ctx *ctx,
+	struct isl_sol_parallel *parallel, struct isl_sol_branch *branch,
+	__isl_give isl_set **empty)
+{
+	enum isl_error error;
+	isl_set *empty_i;
+
+	pthread_join(branch->thread, NULL);
+	branch->running = 0;
+	isl_ctx_merge_worker(ctx, branch->ctx);
+	if ((parallel->use_pma ? !branch->pma : !branch->map) ||
+	    (parallel->track_empty && !branch->empty)) {
+		error = isl_ctx_last_error(branch->ctx);
+		if (error == isl_error_none)
+			error = isl_error_unknown;
+		isl_die(ctx, error,
+			"error in parametric integer programming thread",
+			return isl_stat_error);
+	}
+	if (empty && parallel->track_empty) {
+		empty_i = map_transfer(branch->empty,
+					isl_set_get_space(*empty));
+		*empty = isl_set_union_disjoint(*empty, empty_i);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Wait for all parts of the context of "sol" that were handed over
+ * to other threads to be solved and add the results to "map" and,
+ * if "empty" is not NULL, to "*empty".
+ * The results are added in the order in which the parts
+ * were handed over, such that the final result does not depend
+ * on the scheduling of the threads.
+ * The results are copied to the spaces of "map" and "*empty",
+ * which have the same dimensions as those used by the threads.
+ */
+static __isl_give isl_map *sol_parallel_collect(struct isl_sol *sol,
+	__isl_take isl_map *map, __isl_give isl_set **empty)
+{
+	int i;
+	isl_ctx *ctx;
+	struct isl_sol_parallel *parallel = sol->parallel;
+
+	if (!parallel)
+		return map;
+
+	ctx = isl_basic_map_get_ctx(parallel->bmap);
+	for (i = 0; i < parallel->n_branch; ++i) {
+		struct isl_sol_branch *branch = &parallel->branch[i];
+		isl_map *map_i;
+
+		if (sol_branch_collect(ctx, parallel, branch, empty) < 0)
+			goto error;
+		map_i = map_transfer(branch->map, isl_map_get_space(map));
+		map = isl_map_union_disjoint(map, map_i);
+		sol_branch_clear(branch);
+	}
+
+	return map;
+error:
+	isl_map_free(map);
+	if (empty) {
+		isl_set_free(*empty);
+		*empty = NULL;
+	}
+	return NULL;
+}
+
+/* Wait for all parts of the context of "sol" that were handed over
+ * to other threads to be solved and add the results to "pma" and,
+ * if "empty" is not NULL, to "*empty".
+ * This is the isl_pw_multi_aff version of sol_parallel_collect.
+ * The threads compute their results directly
+ * as isl_pw_multi_affs such that they can simply be copied over.
+ */
+static __isl_give isl_pw_multi_aff *sol_parallel_collect_pma(
+	struct isl_sol *sol, __isl_take isl_pw_multi_aff *pma,
+	__isl_give isl_set **empty)
+{
+	int i;
+	isl_ctx *ctx;
+	struct isl_sol_parallel *parallel = sol->parallel;
+
+	if (!parallel)
+		return pma;
+
+	ctx = isl_basic_map_get_ctx(parallel->bmap);
+	for (i = 0; i < parallel->n_branch; ++i) {
+		struct isl_sol_branch *branch = &parallel->branch[i];
+		isl_pw_multi_aff *pma_i;
+
+		if (sol_branch_collect(ctx, parallel, branch, empty) < 0)
+			goto error;
+		pma_i = pw_multi_aff_transfer(branch->pma,
+					isl_pw_multi_aff_get_space(pma));
+		pma = isl_pw_multi_aff_add_disjoint(pma, pma_i);
+		sol_branch_clear(branch);
+	}
+
+	return pma;
+error:
+	isl_pw_multi_aff_free(pma);
+	if (empty) {
+		isl_set_free(*empty);
+		*empty = NULL;
+	}
+	return NULL;
+}
+
+#else
+
+struct isl_sol_parallel;
+
+static void sol_parallel_free(struct isl_sol_parallel *parallel)
+{
+}
+
+static struct isl_sol_parallel *sol_parallel_alloc(
+	__isl_keep isl_basic_map *bmap, int max, int track_empty, int use_pma)
+{
+	return NULL;
+}
+
+static int sol_hand_off(struct isl_sol *sol, __isl_keep isl_vec *ineq)
+{
+	return 0;
+}
+
+static __isl_give isl_map *sol_parallel_collect(struct isl_sol *sol,
+	__isl_take isl_map *map, __isl_give isl_set **empty)
+{
+	return map;
+}
+
+static __isl_give isl_pw_multi_aff *sol_parallel_collect_pma(
+	struct isl_sol *sol, __isl_take isl_pw_multi_aff *pma,
+	__isl_give isl_set **empty)
+{
+	return pma;
+}
+
+#endif
+
+static void find_solutions(struct isl_sol *sol, struct isl_tab *tab);
+
+/* Find solutions for values of the parameters that satisfy the given
+ * inequality.
+ *
+ * We currently take a snapshot of the context tableau that is reset
+ * when we return from this function, while we make a copy of the main
+ * tableau, leaving the original main tableau untouched.
+ * These are fairly arbitrary choices.  Making a copy also of the context
+ * tableau would obviate the need to undo any changes made to it later,
+ * while taking a snapshot of the main tableau could reduce memory usage.
+ * If we were to switch to taking a snapshot of the main tableau,
+ * we would have to keep in mind that we need to save the row signs
+ * and that we need to do this before saving the current basis
+ * such that the basis has been restore before we restore the row signs.
+ */
+static void find_in_pos(struct isl_sol *sol, struct isl_tab *tab, isl_int *ineq)
+{
+	void *saved;
+
+	if (!sol->context)
+		goto error;
+	saved = sol->context->op->save(sol->context);
+
+	tab = isl_tab_dup(tab);
+	if (!tab)
+		goto error;
+
+	sol->context->op->add_ineq(sol->context, ineq, 0, 1);
+
+	find_solutions(sol, tab);
+
+	if (!sol->error)
+		sol->context->op->restore(sol->context, saved);
+	else
+		sol->context->op->discard(saved);
+	return;
+error:
+	sol->error = 1;
+}
+
+/* Record the absence of solutions for those values of the parameters
+ * that do not satisfy the given inequality with equality.
+ */
+static void no_sol_in_strict(struct isl_sol *sol,
+	struct isl_tab *tab, struct isl_vec *ineq)
+{
+	int empty;
+	void *saved;
+
+	if (!sol->context || sol->error)
+		goto error;
+	saved = sol->context->op->save(sol->context);
+
+	isl_int_sub_ui(ineq->el[0], ineq->el[0], 1);
+
+	sol->context->op->add_ineq(sol->context, ineq->el, 1, 0);
+	if (!sol->context)
+		goto error;
+
+	empty = tab->empty;
+	tab->empty = 1;
+	sol_add(sol, tab);
+	tab->empty = empty;
+
+	isl_int_add_ui(ineq->el[0], ineq->el[0], 1);
+
+	sol->context->op->restore(sol->context, saved);
+	return;
+error:
+	sol->error = 1;
+}
+
+/* Reset all row variables that are marked to have a sign that may
+ * be both positive and negative to have an unknown sign.
+ */
+static void reset_any_to_unknown(struct isl_tab *tab)
+{
+	int row;
+
+	for (row = tab->n_redundant; row < tab->n_row; ++row) {
+		if (!isl_tab_var_from_row(tab, row)->is_nonneg)
+			continue;
+		if (tab->row_sign[row] == isl_tab_row_any)
+			tab->row_sign[row] = isl_tab_row_unknown;
+	}
+}
 
 /* Compute the lexicographic minimum of the set represented by the main
  * tableau "tab" within the context "sol->context_tab".
@@ -3910,6 +4811,7 @@ static void find_solutions(struct isl_sol *sol, struct isl_tab *tab)
 				split = context->op->best_split(context, tab);
 			if (split < 0)
 				goto error;
+			tab->mat->ctx->stats->pip_splits++;
 			ineq = get_row_parameter_ineq(tab, split);
 			if (!ineq)
 				goto error;
@@ -3917,7 +4819,8 @@ static void find_solutions(struct isl_sol *sol, struct isl_tab *tab)
 			reset_any_to_unknown(tab);
 			tab->row_sign[split] = isl_tab_row_pos;
 			sol_inc_level(sol);
-			find_in_pos(sol, tab, ineq->el);
+			if (!sol_hand_off(sol, ineq))
+				find_in_pos(sol, tab, ineq->el);
 			tab->row_sign[split] = isl_tab_row_neg;
 			isl_seq_neg(ineq->el, ineq->el, ineq->size);
 			isl_int_sub_ui(ineq->el[0], ineq->el[0], 1);
@@ -3940,6 +4843,7 @@ static void find_solutions(struct isl_sol *sol, struct isl_tab *tab)
 				break;
 			}
 			row = add_cut(tab, row);
+			tab->mat->ctx->stats->pip_cuts++;
 		} else if (ISL_FL_ISSET(flags, I_VAR)) {
 			struct isl_vec *div;
 			struct isl_vec *ineq;
@@ -3964,8 +4868,10 @@ static void find_solutions(struct isl_sol *sol, struct isl_tab *tab)
 			tab = set_row_cst_to_div(tab, row, d);
 			if (context->op->is_empty(context))
 				break;
-		} else
+		} else {
 			row = add_parametric_cut(tab, row, context);
+			tab->mat->ctx->stats->pip_cuts++;
+		}
 		if (row < 0)
 			goto error;
 	}
@@ -4171,24 +5077,37 @@ error:
  * We make sure the divs in the domain are properly ordered,
  * because they will be added one by one in the given order
  * during the construction of the solution map.
+ *
+ * If the pip-threads option is set, then some parts of the context
+ * may be handed over to other threads.  These threads solve
+ * the problem from scratch, so they are given a copy
+ * of the original "bmap", before its divs are aligned to the context.
+ * "use_pma" is set if they should compute their results
+ * as isl_pw_multi_affs.
+ * The caller is responsible for collecting their results.
  */
 static struct isl_sol *basic_map_partial_lexopt_base_sol(
 	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
-	__isl_give isl_set **empty, int max,
+	__isl_give isl_set **empty, int max, int use_pma,
 	struct isl_sol *(*init)(__isl_keep isl_basic_map *bmap,
 		    __isl_take isl_basic_set *dom, int track_empty, int max))
 {
 	struct isl_tab *tab;
 	struct isl_sol *sol = NULL;
 	struct isl_context *context;
+	struct isl_sol_parallel *parallel;
 
+	parallel = sol_parallel_alloc(bmap, max, !!empty, use_pma);
 	if (dom->n_div) {
 		dom = isl_basic_set_order_divs(dom);
 		bmap = align_context_divs(bmap, dom);
 	}
 	sol = init(bmap, dom, !!empty, max);
-	if (!sol)
+	if (!sol) {
+		sol_parallel_free(parallel);
 		goto error;
+	}
+	sol->parallel = parallel;
 
 	context = sol->context;
 	if (isl_basic_set_plain_is_empty(context->op->peek_basic_set(context)))
@@ -4217,7 +5136,9 @@ error:
 /* Base case of isl_tab_basic_map_partial_lexopt, after removing
  * some obvious symmetries.
  *
- * We call basic_map_partial_lexopt_base_sol and extract the results.
+ * We call basic_map_partial_lexopt_base_sol and extract the results,
+ * adding those of the parts of the context that were handed over
+ * to other threads, if any.
  */
 static __isl_give isl_map *basic_map_partial_lexopt_base(
 	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
@@ -4227,7 +5148,7 @@ static __isl_give isl_map *basic_map_partial_lexopt_base(
 	struct isl_sol *sol;
 	struct isl_sol_map *sol_map;
 
-	sol = basic_map_partial_lexopt_base_sol(bmap, dom, empty, max,
+	sol = basic_map_partial_lexopt_base_sol(bmap, dom, empty, max, 0,
 						&sol_map_init);
 	if (!sol)
 		return NULL;
@@ -4236,6 +5157,7 @@ static __isl_give isl_map *basic_map_partial_lexopt_base(
 	result = isl_map_copy(sol_map->map);
 	if (empty)
 		*empty = isl_set_copy(sol_map->empty);
+	result = sol_parallel_collect(sol, result, empty);
 	sol_free(&sol_map->sol);
 	return result;
 }
@@ -4267,45 +5189,176 @@ static __isl_give int *count_occurrences(__isl_keep isl_basic_map *bmap,
 	return occurrences;
 }
 
-/* Do all of the "n" variables with non-zero coefficients in "c"
- * occur in exactly a single constraint.
- * "occurrences" is an array of length "n" containing the number
+/* A family of parallel constraints, as found by parallel_constraints.
+ * "n" is the number of constraints in the family and
+ * "list" contains their positions among the inequality constraints,
+ * in increasing order.
+ * The coefficients of the output variables of the i-th constraint
+ * are equal to scale->el[i] times "var".
+ */
+struct isl_parallel_family {
+	int n;
+	int *list;
+	isl_vec *scale;
+	isl_vec *var;
+};
+
+/* Remove the constraints from the family of constraints of "bmap"
+ * marked in "member" that involve any of the "n_in" initial variables
+ * that also occur in some inequality constraint outside the family.
+ * "n" is the number of constraints in the family.
+ * "occurrences" is an array of length "n_in" containing the number
  * of occurrences of each of the variables in the inequality constraints.
+ * Removing a constraint from the family may cause other constraints
+ * to involve variables that occur outside the family, so this process
+ * is repeated until no more constraints are removed.
+ * Return the number of remaining constraints in the family.
  */
-static int single_occurrence(int n, isl_int *c, int *occurrences)
+static int close_family(__isl_keep isl_basic_map *bmap, int n_in,
+	int *occurrences, int *member, int n)
+{
+	int i, j;
+	int *count;
+	int changed = 1;
+
+	count = isl_calloc_array(bmap->ctx, int, n_in);
+	if (n_in && !count)
+		return -1;
+
+	while (changed) {
+		changed = 0;
+		for (j = 0; j < n_in; ++j)
+			count[j] = 0;
+		for (i = 0; i < bmap->n_ineq; ++i) {
+			if (!member[i])
+				continue;
+			for (j = 0; j < n_in; ++j)
+				if (!isl_int_is_zero(bmap->ineq[i][1 + j]))
+					count[j]++;
+		}
+		for (i = 0; i < bmap->n_ineq; ++i) {
+			if (!member[i])
+				continue;
+			for (j = 0; j < n_in; ++j) {
+				if (isl_int_is_zero(bmap->ineq[i][1 + j]))
+					continue;
+				if (count[j] != occurrences[j])
+					break;
+			}
+			if (j >= n_in)
+				continue;
+			member[i] = 0;
+			n--;
+			changed = 1;
+		}
+	}
+
+	free(count);
+	return n;
+}
+
+/* Return a copy of the inequality constraints of "bmap",
+ * with "n_in" the number of parameters and input variables
+ * and "n_out" the number of output variables.
+ * If "bmap" is integral, then the coefficients of the output variables
+ * in each row are divided by their greatest common divisor,
+ * such that constraints with output parts that are positive multiples
+ * of each other end up with the same output parts.
+ */
+static __isl_give isl_mat *normalized_ineq(__isl_keep isl_basic_map *bmap,
+	unsigned n_in, unsigned n_out)
 {
 	int i;
+	unsigned total;
+	isl_int gcd;
+	isl_mat *ineq;
 
-	for (i = 0; i < n; ++i) {
-		if (isl_int_is_zero(c[i]))
+	total = isl_basic_map_total_dim(bmap);
+	ineq = isl_mat_alloc(bmap->ctx, bmap->n_ineq, 1 + total);
+	if (!ineq)
+		return NULL;
+
+	isl_int_init(gcd);
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		isl_int *out = ineq->row[i] + 1 + n_in;
+
+		isl_seq_cpy(ineq->row[i], bmap->ineq[i], 1 + total);
+		if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
 			continue;
-		if (occurrences[i] != 1)
-			return 0;
+		isl_seq_gcd(out, n_out, &gcd);
+		if (!isl_int_is_zero(gcd) && !isl_int_is_one(gcd))
+			isl_seq_scale_down(out, out, gcd, n_out);
 	}
+	isl_int_clear(gcd);
 
-	return 1;
+	return ineq;
 }
 
-/* Do all of the "n" initial variables that occur in inequality constraint
- * "ineq" of "bmap" only occur in that constraint?
+/* Free the memory allocated for the family of parallel constraints "family".
  */
-static int all_single_occurrence(__isl_keep isl_basic_map *bmap, int ineq,
-	int n)
+static void parallel_family_clear(struct isl_parallel_family *family)
 {
-	int i, j;
+	free(family->list);
+	isl_vec_free(family->scale);
+	isl_vec_free(family->var);
+	family->list = NULL;
+	family->scale = NULL;
+	family->var = NULL;
+}
+
+/* Store the family of constraints of "bmap" marked in "member"
+ * in "family", with "n_in" the number of parameters and input variables
+ * and "n_out" the number of output variables.
+ *
+ * The coefficients a_i of the output variables of the constraints
+ * are all positive multiples of the same primitive vector g,
+ * i.e., a_i = c_i g, with c_i the greatest common divisor of a_i.
+ * Let d be the greatest common divisor of the c_i.
+ * The output part of the combined constraint is set to d g and
+ * the scales s_i to c_i/d, such that family->scale is all ones
+ * if the a_i are all equal.
+ * In case of a rational "bmap", the a_i are all equal and
+ * the scales are set to one.
+ */
+static int parallel_family_set(struct isl_parallel_family *family,
+	__isl_keep isl_basic_map *bmap, int *member, int n,
+	unsigned n_in, unsigned n_out)
+{
+	int i, k;
+	isl_ctx *ctx;
+	isl_int d;
 
-	for (i = 0; i < n; ++i) {
-		if (isl_int_is_zero(bmap->ineq[ineq][1 + i]))
+	ctx = isl_basic_map_get_ctx(bmap);
+	family->n = n;
+	family->list = isl_alloc_array(ctx, int, n);
+	family->scale = isl_vec_alloc(ctx, n);
+	family->var = isl_vec_alloc(ctx, n_out);
+	if (!family->list || !family->scale || !family->var)
+		return -1;
+
+	isl_int_init(d);
+	isl_int_set_si(d, 0);
+	for (i = 0, k = 0; i < bmap->n_ineq; ++i) {
+		if (!member[i])
 			continue;
-		for (j = 0; j < bmap->n_ineq; ++j) {
-			if (j == ineq)
-				continue;
-			if (!isl_int_is_zero(bmap->ineq[j][1 + i]))
-				return 0;
-		}
+		family->list[k] = i;
+		if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
+			isl_int_set_si(family->scale->el[k], 1);
+		else
+			isl_seq_gcd(bmap->ineq[i] + 1 + n_in, n_out,
+					&family->scale->el[k]);
+		isl_int_gcd(d, d, family->scale->el[k]);
+		k++;
 	}
 
-	return 1;
+	i = family->list[0];
+	isl_seq_scale_down(family->var->el, bmap->ineq[i] + 1 + n_in,
+				family->scale->el[0], n_out);
+	isl_seq_scale(family->var->el, family->var->el, d, n_out);
+	isl_seq_scale_down(family->scale->el, family->scale->el, d, n);
+	isl_int_clear(d);
+
+	return 0;
 }
 
 /* Structure used during detection of parallel constraints.
@@ -4314,7 +5367,6 @@ static int all_single_occurrence(__isl_keep isl_basic_map *bmap, int ineq,
  * val: the coefficients of the output variables
  */
 struct isl_constraint_equal_info {
-	isl_basic_map *bmap;
 	unsigned n_in;
 	unsigned n_out;
 	isl_int *val;
@@ -4331,27 +5383,43 @@ static int constraint_equal(const void *entry, const void *val)
 	return isl_seq_eq((*row) + 1 + info->n_in, info->val, info->n_out);
 }
 
-/* Check whether "bmap" has a pair of constraints that have
- * the same coefficients for the output variables.
+/* Check whether "bmap" has a family of at least two constraints
+ * that have the same coefficients for the output variables or,
+ * if "bmap" is integral, coefficients that are positive multiples
+ * of each other.
  * Note that the coefficients of the existentially quantified
  * variables need to be zero since the existentially quantified
  * of the result are usually not the same as those of the input.
  * Furthermore, check that each of the input variables that occur
- * in those constraints does not occur in any other constraint.
- * If so, return 1 and return the row indices of the two constraints
- * in *first and *second.
+ * in those constraints does not occur in any constraint outside
+ * the family.  The input variables may however be shared
+ * by several constraints in the family.
+ * If so, return 1 and store the family in "family".
+ *
+ * The constraints are first grouped according to their normalized
+ * output parts, with first[i] the position of the first constraint
+ * in the group of constraint i, or -1 if constraint i cannot be
+ * part of a family.  Each group is then reduced to its largest subset
+ * that satisfies the requirement on the input variables.
+ * If there are several such families, then the one whose second
+ * constraint appears first is selected.
  */
 static int parallel_constraints(__isl_keep isl_basic_map *bmap,
-	int *first, int *second)
+	struct isl_parallel_family *family)
 {
-	int i;
+	int i, j;
 	isl_ctx *ctx;
 	int *occurrences = NULL;
+	int *first = NULL;
+	int *member = NULL;
+	isl_mat *ineq = NULL;
 	struct isl_hash_table *table = NULL;
 	struct isl_hash_table_entry *entry;
 	struct isl_constraint_equal_info info;
 	unsigned n_out;
 	unsigned n_div;
+	int best = -1, best_second = 0, best_n = 0;
+	int r = 0;
 
 	ctx = isl_basic_map_get_ctx(bmap);
 	table = isl_hash_table_alloc(ctx, bmap->n_ineq);
@@ -4363,50 +5431,112 @@ static int parallel_constraints(__isl_keep isl_basic_map *bmap,
 	occurrences = count_occurrences(bmap, info.n_in);
 	if (info.n_in && !occurrences)
 		goto error;
-	info.bmap = bmap;
 	n_out = isl_basic_map_dim(bmap, isl_dim_out);
 	n_div = isl_basic_map_dim(bmap, isl_dim_div);
 	info.n_out = n_out + n_div;
+	ineq = normalized_ineq(bmap, info.n_in, n_out);
+	first = isl_alloc_array(ctx, int, bmap->n_ineq);
+	member = isl_alloc_array(ctx, int, bmap->n_ineq);
+	if (!ineq || (bmap->n_ineq && (!first || !member)))
+		goto error;
 	for (i = 0; i < bmap->n_ineq; ++i) {
 		uint32_t hash;
 
-		info.val = bmap->ineq[i] + 1 + info.n_in;
+		first[i] = -1;
+		info.val = ineq->row[i] + 1 + info.n_in;
 		if (isl_seq_first_non_zero(info.val, n_out) < 0)
 			continue;
 		if (isl_seq_first_non_zero(info.val + n_out, n_div) >= 0)
 			continue;
-		if (!single_occurrence(info.n_in, bmap->ineq[i] + 1,
-					occurrences))
-			continue;
 		hash = isl_seq_get_hash(info.val, info.n_out);
 		entry = isl_hash_table_find(ctx, table, hash,
 					    constraint_equal, &info, 1);
 		if (!entry)
 			goto error;
-		if (entry->data)
-			break;
-		entry->data = &bmap->ineq[i];
+		if (!entry->data)
+			entry->data = &ineq->row[i];
+		first[i] = ((isl_int **)entry->data) - ineq->row;
 	}
 
-	if (i < bmap->n_ineq) {
-		*first = ((isl_int **)entry->data) - bmap->ineq; 
-		*second = i;
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		int n = 0;
+
+		if (first[i] != i)
+			continue;
+		for (j = 0; j < bmap->n_ineq; ++j) {
+			member[j] = first[j] == i;
+			n += member[j];
+		}
+		if (n >= 2)
+			n = close_family(bmap, info.n_in, occurrences,
+					member, n);
+		if (n < 0)
+			goto error;
+		if (n < 2)
+			continue;
+		for (j = 0; !member[j]; ++j)
+			;
+		for (++j; !member[j]; ++j)
+			;
+		if (best >= 0 && j >= best_second)
+			continue;
+		best = i;
+		best_second = j;
+		best_n = n;
+	}
+
+	if (best >= 0) {
+		int n = 0;
+
+		for (j = 0; j < bmap->n_ineq; ++j) {
+			member[j] = first[j] == best;
+			n += member[j];
+		}
+		if (close_family(bmap, info.n_in, occurrences, member, n) < 0 ||
+		    parallel_family_set(family, bmap, member, best_n,
+					info.n_in, n_out) < 0)
+			goto error;
+		r = 1;
 	}
 
 	isl_hash_table_free(ctx, table);
+	isl_mat_free(ineq);
 	free(occurrences);
+	free(first);
+	free(member);
 
-	return i < bmap->n_ineq;
+	return r;
 error:
 	isl_hash_table_free(ctx, table);
+	isl_mat_free(ineq);
 	free(occurrences);
+	free(first);
+	free(member);
 	return -1;
 }
 
-/* Given a set of upper bounds in "var", add constraints to "bset"
- * that make the i-th bound smallest.
+/* Given a set of upper bounds on the last variable m in "var",
+ * add constraints to "bset" that make the i-th bound smallest.
+ * Each row of "var" is of the form
+ *
+ *	b_j - s_j m >= 0
+ *
+ * with s_j a positive integer, representing the bound m <= floor(b_j/s_j).
+ *
+ * In particular, if there are n bounds, then add the constraints
+ *
+ *	m <= floor(b_j/s_j)	for j > i
+ *	m <  floor(b_j/s_j)	for j < i
+ *
+ * i.e.,
+ *
+ *	b_j - s_j m >= 0	for j > i
+ *	b_j - s_j m - s_j >= 0	for j < i
  *
- * In particular, if there are n bounds b_i, then add the constraints
+ * If s_i = 1, then "bset" is assumed to be such that m = b_i
+ * and this value is plugged into the constraints,
+ * resulting in constraints that do not involve m.
+ * In particular, if all s_j are also one, then the constraints are
  *
  *	b_i <= b_j	for j > i
  *	b_i <  b_j	for j < i
@@ -4416,8 +5546,10 @@ static __isl_give isl_basic_set *select_minimum(__isl_take isl_basic_set *bset,
 {
 	isl_ctx *ctx;
 	int j, k;
+	unsigned pos;
 
 	ctx = isl_mat_get_ctx(var);
+	pos = var->n_col - 1;
 
 	for (j = 0; j < var->n_row; ++j) {
 		if (j == i)
@@ -4425,11 +5557,15 @@ static __isl_give isl_basic_set *select_minimum(__isl_take isl_basic_set *bset,
 		k = isl_basic_set_alloc_inequality(bset);
 		if (k < 0)
 			goto error;
-		isl_seq_combine(bset->ineq[k], ctx->one, var->row[j],
-				ctx->negone, var->row[i], var->n_col);
-		isl_int_set_si(bset->ineq[k][var->n_col], 0);
+		if (isl_int_is_negone(var->row[i][pos]))
+			isl_seq_combine(bset->ineq[k], ctx->one, var->row[j],
+					var->row[j][pos], var->row[i],
+					var->n_col);
+		else
+			isl_seq_cpy(bset->ineq[k], var->row[j], var->n_col);
 		if (j < i)
-			isl_int_sub_ui(bset->ineq[k][0], bset->ineq[k][0], 1);
+			isl_int_add(bset->ineq[k][0], bset->ineq[k][0],
+				    var->row[j][pos]);
 	}
 
 	bset = isl_basic_set_finalize(bset);
@@ -4445,35 +5581,63 @@ error:
  * construct a set that divides the space into cells where one
  * of the upper bounds is smaller than all the others and assign
  * this upper bound to m.
+ * Each row of "var" is of the form
  *
- * In particular, if there are n bounds b_i, then the result
+ *	b_j - s_j m >= 0
+ *
+ * with s_j a positive integer, representing the bound m <= floor(b_j/s_j).
+ *
+ * In particular, if there are n bounds, then the result
  * consists of n basic sets, each one of the form
  *
- *	m = b_i
- *	b_i <= b_j	for j > i
- *	b_i <  b_j	for j < i
+ *	m = floor(b_i/s_i)
+ *	m <= floor(b_j/s_j)	for j > i
+ *	m <  floor(b_j/s_j)	for j < i
+ *
+ * where m = floor(b_i/s_i) is expressed as the equality m = b_i if s_i = 1
+ * and as the pair of inequalities
+ *
+ *	b_i - s_i m >= 0
+ *	-b_i + s_i m + s_i - 1 >= 0
+ *
+ * otherwise.
  */
 static __isl_give isl_set *set_minimum(__isl_take isl_space *dim,
 	__isl_take isl_mat *var)
 {
 	int i, k;
+	unsigned pos;
 	isl_basic_set *bset = NULL;
 	isl_set *set = NULL;
 
 	if (!dim || !var)
 		goto error;
 
+	pos = var->n_col - 1;
 	set = isl_set_alloc_space(isl_space_copy(dim),
 				var->n_row, ISL_SET_DISJOINT);
 
 	for (i = 0; i < var->n_row; ++i) {
 		bset = isl_basic_set_alloc_space(isl_space_copy(dim), 0,
-					       1, var->n_row - 1);
-		k = isl_basic_set_alloc_equality(bset);
-		if (k < 0)
-			goto error;
-		isl_seq_cpy(bset->eq[k], var->row[i], var->n_col);
-		isl_int_set_si(bset->eq[k][var->n_col], -1);
+					       1, var->n_row + 1);
+		if (isl_int_is_negone(var->row[i][pos])) {
+			k = isl_basic_set_alloc_equality(bset);
+			if (k < 0)
+				goto error;
+			isl_seq_cpy(bset->eq[k], var->row[i], var->n_col);
+		} else {
+			k = isl_basic_set_alloc_inequality(bset);
+			if (k < 0)
+				goto error;
+			isl_seq_cpy(bset->ineq[k], var->row[i], var->n_col);
+			k = isl_basic_set_alloc_inequality(bset);
+			if (k < 0)
+				goto error;
+			isl_seq_neg(bset->ineq[k], var->row[i], var->n_col);
+			isl_int_sub(bset->ineq[k][0], bset->ineq[k][0],
+				    var->row[i][pos]);
+			isl_int_sub_ui(bset->ineq[k][0], bset->ineq[k][0], 1);
+		}
 		bset = select_minimum(bset, var, i);
 		set = isl_set_add_basic_set(set, bset);
 	}
@@ -4489,6 +5653,21 @@ error:
 	return NULL;
 }
 
+/* Are all the bounds in "cst" of the form m <= b_j, i.e.,
+ * is the coefficient of m in each of the constraints equal to -1?
+ */
+static int all_unit_bounds(__isl_keep isl_mat *cst)
+{
+	int i;
+	unsigned pos = cst->n_col - 1;
+
+	for (i = 0; i < cst->n_row; ++i)
+		if (!isl_int_is_negone(cst->row[i][pos]))
+			return 0;
+
+	return 1;
+}
+
 /* Given that the last input variable of "bmap" represents the minimum
  * of the bounds in "cst", check whether we need to split the domain
  * based on which bound attains the minimum.
@@ -4497,6 +5676,8 @@ error:
  * or in an equality.  Otherwise, it is only needed if it appears in
  * an upper bound that is different from the upper bounds on which it
  * is defined.
+ * Each row of "cst" is one of these upper bounds, including
+ * the coefficient of the minimum.
  */
 static int need_split_basic_map(__isl_keep isl_basic_map *bmap,
 	__isl_keep isl_mat *cst)
@@ -4505,7 +5686,7 @@ static int need_split_basic_map(__isl_keep isl_basic_map *bmap,
 	unsigned total;
 	unsigned pos;
 
-	pos = cst->n_col - 1;
+	pos = cst->n_col - 2;
 	total = isl_basic_map_dim(bmap, isl_dim_all);
 
 	for (i = 0; i < bmap->n_div; ++i)
@@ -4519,8 +5700,6 @@ static int need_split_basic_map(__isl_keep isl_basic_map *bmap,
 	for (i = 0; i < bmap->n_ineq; ++i) {
 		if (isl_int_is_nonneg(bmap->ineq[i][1 + pos]))
 			continue;
-		if (!isl_int_is_negone(bmap->ineq[i][1 + pos]))
-			return 1;
 		if (isl_seq_first_non_zero(bmap->ineq[i] + 1 + pos + 1,
 					   total - pos - 1) >= 0)
 			return 1;
@@ -4569,6 +5748,10 @@ static int need_split_set(__isl_keep isl_set *set, __isl_keep isl_mat *cst)
  * in pieces where one of the bounds is (strictly) smaller than the others.
  * This subdivision is given in "min_expr".
  * The variable is subsequently projected out.
+ * If all bounds are of the form m <= b_i, then this can be done
+ * using Fourier-Motzkin elimination.  Otherwise, the variable
+ * needs to be existentially quantified since m <= floor(b_i/s_i)
+ * is not implied by the bound s_i m <= b_i on rational values of m.
  *
  * We only do the split when it is needed.
  * For example if the last input variable m = min(a,b) and the only
@@ -4582,12 +5765,15 @@ static __isl_give isl_set *split(__isl_take isl_set *empty,
 {
 	int n_in;
 	int i;
+	int unit;
 	isl_space *dim;
 	isl_set *res;
 
 	if (!empty || !min_expr || !cst)
 		goto error;
 
+	unit = all_unit_bounds(cst);
+
 	n_in = isl_set_dim(empty, isl_dim_set);
 	dim = isl_set_get_space(empty);
 	dim = isl_space_drop_dims(dim, isl_dim_set, n_in - 1, 1);
@@ -4599,7 +5785,10 @@ static __isl_give isl_set *split(__isl_take isl_set *empty,
 		set = isl_set_from_basic_set(isl_basic_set_copy(empty->p[i]));
 		if (need_split_basic_set(empty->p[i], cst))
 			set = isl_set_intersect(set, isl_set_copy(min_expr));
-		set = isl_set_remove_dims(set, isl_dim_set, n_in - 1, 1);
+		if (unit)
+			set = isl_set_remove_dims(set, isl_dim_set, n_in - 1, 1);
+		else
+			set = isl_set_project_out(set, isl_dim_set, n_in - 1, 1);
 
 		res = isl_set_union_disjoint(res, set);
 	}
@@ -4628,12 +5817,15 @@ static __isl_give isl_map *split_domain(__isl_take isl_map *opt,
 {
 	int n_in;
 	int i;
+	int unit;
 	isl_space *dim;
 	isl_map *res;
 
 	if (!opt || !min_expr || !cst)
 		goto error;
 
+	unit = all_unit_bounds(cst);
+
 	n_in = isl_map_dim(opt, isl_dim_in);
 	dim = isl_map_get_space(opt);
 	dim = isl_space_drop_dims(dim, isl_dim_in, n_in - 1, 1);
@@ -4646,7 +5838,10 @@ static __isl_give isl_map *split_domain(__isl_take isl_map *opt,
 		if (need_split_basic_map(opt->p[i], cst))
 			map = isl_map_intersect_domain(map,
 						       isl_set_copy(min_expr));
-		map = isl_map_remove_dims(map, isl_dim_in, n_in - 1, 1);
+		if (unit)
+			map = isl_map_remove_dims(map, isl_dim_in, n_in - 1, 1);
+		else
+			map = isl_map_project_out(map, isl_dim_in, n_in - 1, 1);
 
 		res = isl_map_union_disjoint(res, map);
 	}
@@ -4757,7 +5952,7 @@ static void sol_for_free(struct isl_sol_for *sol_for)
 	if (!sol_for)
 		return;
 	if (sol_for->sol.context)
-		sol_for->sol.context->op->free(sol_for->sol.context);
+		isl_context_release(sol_for->sol.context);
 	free(sol_for);
 }
 
@@ -4914,6 +6109,118 @@ int isl_basic_set_foreach_lexopt(__isl_keep isl_basic_set *bset, int max,
 	return isl_basic_map_foreach_lexopt(bset, max, fn, user);
 }
 
+/* Data used in isl_basic_map_foreach_lexmin and
+ * isl_basic_map_foreach_lexmax.
+ *
+ * "space" is the space of the multi-affine expressions passed to "fn".
+ * "fn" and "user" are the user-specified callback and its argument.
+ */
+struct isl_foreach_lexopt_data {
+	isl_space *space;
+	isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user);
+	void *user;
+};
+
+/* Combine the affine expressions in "list" into a multi-affine
+ * expression and call data->fn on this expression and "dom".
+ * The affine expressions are defined over the local space of "dom",
+ * which may involve integer divisions that are not needed
+ * to describe "dom" itself, so "dom" is simplified first.
+ */
+static int foreach_lexopt_piece(__isl_take isl_basic_set *dom,
+	__isl_take isl_aff_list *list, void *user)
+{
+	struct isl_foreach_lexopt_data *data = user;
+	int i, n;
+	isl_multi_aff *maff;
+
+	if (!list)
+		goto error;
+
+	n = isl_aff_list_n_aff(list);
+	maff = isl_multi_aff_alloc(isl_space_copy(data->space));
+	for (i = 0; i < n; ++i)
+		maff = isl_multi_aff_set_aff(maff, i,
+						isl_aff_list_get_aff(list, i));
+	isl_aff_list_free(list);
+	dom = isl_basic_set_simplify(dom);
+	dom = isl_basic_set_finalize(dom);
+	if (!dom || !maff) {
+		isl_basic_set_free(dom);
+		isl_multi_aff_free(maff);
+		return -1;
+	}
+
+	return data->fn(dom, maff, data->user);
+error:
+	isl_basic_set_free(dom);
+	isl_aff_list_free(list);
+	return -1;
+}
+
+/* Call "fn" on each piece of the lexicographic minimum
+ * (or maximum if "max" is set) of "bmap", without constructing
+ * the full result.
+ */
+static isl_stat basic_map_foreach_lexopt_piece(__isl_keep isl_basic_map *bmap,
+	int max, isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user), void *user)
+{
+	struct isl_foreach_lexopt_data data = { NULL, fn, user };
+	int r;
+
+	if (!bmap)
+		return isl_stat_error;
+
+	data.space = isl_basic_map_get_space(bmap);
+	r = isl_basic_map_foreach_lexopt(bmap, max,
+					&foreach_lexopt_piece, &data);
+	isl_space_free(data.space);
+
+	return r < 0 ? isl_stat_error : isl_stat_ok;
+}
+
+/* Call "fn" on each piece of the lexicographic minimum of "bmap"
+ * as soon as it has been computed.
+ * Each piece consists of a part of the domain of "bmap" and
+ * a multi-affine expression in the space of "bmap" that describes
+ * the minimum on that part of the domain.
+ * The parts are pairwise disjoint.
+ * If "fn" returns an error, then the computation is aborted.
+ */
+isl_stat isl_basic_map_foreach_lexmin(__isl_keep isl_basic_map *bmap,
+	isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user), void *user)
+{
+	return basic_map_foreach_lexopt_piece(bmap, 0, fn, user);
+}
+
+/* Call "fn" on each piece of the lexicographic maximum of "bmap"
+ * as soon as it has been computed.
+ * See isl_basic_map_foreach_lexmin.
+ */
+isl_stat isl_basic_map_foreach_lexmax(__isl_keep isl_basic_map *bmap,
+	isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user), void *user)
+{
+	return basic_map_foreach_lexopt_piece(bmap, 1, fn, user);
+}
+
+isl_stat isl_basic_set_foreach_lexmin(__isl_keep isl_basic_set *bset,
+	isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user), void *user)
+{
+	return isl_basic_map_foreach_lexmin(bset, fn, user);
+}
+
+isl_stat isl_basic_set_foreach_lexmax(__isl_keep isl_basic_set *bset,
+	isl_stat (*fn)(__isl_take isl_basic_set *dom,
+		__isl_take isl_multi_aff *maff, void *user), void *user)
+{
+	return isl_basic_map_foreach_lexmax(bset, fn, user);
+}
+
 /* Check if the given sequence of len variables starting at pos
  * represents a trivial (i.e., zero) solution.
  * The variables are assumed to be non-negative and to come in pairs,
@@ -5039,6 +6346,38 @@ struct isl_trivial {
 	struct isl_tab_undo *snap;
 };
 
+/* Data for reporting conflicts in a presolved set
+ * in terms of the constraints of the original set.
+ *
+ * "conflict" and "user" are the callback passed by the user.
+ * "row_map" maps the "n_row" constraints of the presolved set
+ * to the constraints of the original set, which has "n_orig" constraints.
+ */
+struct isl_presolve_conflict {
+	int (*conflict)(int con, void *user);
+	void *user;
+	int *row_map;
+	int n_row;
+	int n_orig;
+};
+
+/* Report the conflicting constraint "con" of the presolved set
+ * to the user in terms of the original set.
+ * Constraints that were added after the construction of the tableau
+ * are shifted to the corresponding position after the original
+ * constraints.
+ */
+static int presolve_conflict(int con, void *user)
+{
+	struct isl_presolve_conflict *data = user;
+
+	if (con < data->n_row)
+		con = data->row_map[con];
+	else
+		con += data->n_orig - data->n_row;
+	return data->conflict(con, data->user);
+}
+
 /* Return the lexicographically smallest non-trivial solution of the
  * given ILP problem.
  *
@@ -5059,6 +6398,12 @@ struct isl_trivial {
  * Whenever a conflict is encountered, all constraints involved are
  * reported to the caller through a call to "conflict".
  *
+ * If the tab-presolve option is set, then redundant constraints
+ * are removed from "bset" first.  The variables are kept
+ * since they are referenced by "region".  Conflicts are reported
+ * in terms of the constraints of the original "bset"
+ * through presolve_conflict.
+ *
  * We perform a simple branch-and-bound backtracking search.
  * Each level in the search represents initially trivial region that is forced
  * to be non-trivial.
@@ -5087,8 +6432,9 @@ __isl_give isl_vec *isl_tab_basic_set_non_trivial_lexmin(
 	isl_ctx *ctx;
 	isl_vec *v = NULL;
 	isl_vec *sol = NULL;
-	struct isl_tab *tab;
+	struct isl_tab *tab = NULL;
 	struct isl_trivial *triv = NULL;
+	struct isl_presolve_conflict pc = { conflict, user, NULL };
 	int level, init;
 
 	if (!bset)
@@ -5097,11 +6443,24 @@ __isl_give isl_vec *isl_tab_basic_set_non_trivial_lexmin(
 	ctx = isl_basic_set_get_ctx(bset);
 	sol = isl_vec_alloc(ctx, 0);
 
+	if (ctx->opt->tab_presolve) {
+		pc.n_orig = bset->n_eq + bset->n_ineq;
+		bset = isl_basic_set_presolve(bset, 1, NULL, &pc.row_map);
+		if (!bset)
+			goto error;
+		pc.n_row = bset->n_eq + bset->n_ineq;
+	}
+
 	tab = tab_for_lexmin(bset, NULL, 0, 0);
 	if (!tab)
 		goto error;
-	tab->conflict = conflict;
-	tab->conflict_user = user;
+	if (pc.row_map) {
+		tab->conflict = &presolve_conflict;
+		tab->conflict_user = &pc;
+	} else {
+		tab->conflict = conflict;
+		tab->conflict_user = user;
+	}
 
 	v = isl_vec_alloc(ctx, 1 + tab->n_var);
 	triv = isl_calloc_array(ctx, struct isl_trivial, n_region);
@@ -5187,6 +6546,7 @@ backtrack:
 	}
 
 	free(triv);
+	free(pc.row_map);
 	isl_vec_free(v);
 	isl_tab_free(tab);
 	isl_basic_set_free(bset);
@@ -5194,6 +6554,7 @@ backtrack:
 	return sol;
 error:
 	free(triv);
+	free(pc.row_map);
 	isl_vec_free(v);
 	isl_tab_free(tab);
 	isl_basic_set_free(bset);
@@ -5205,10 +6566,13 @@ error:
  * the lexicographically smallest rational point of a non-negative set.
  * This point is represented by the sample value of "tab",
  * unless "tab" is empty.
+ * If "T" is not NULL, then the set has been presolved and
+ * "T" maps points in the space of "tab" back to the original space.
  */
 struct isl_tab_lexmin {
 	isl_ctx *ctx;
 	struct isl_tab *tab;
+	isl_mat *T;
 };
 
 /* Free "tl" and return NULL.
@@ -5219,6 +6583,7 @@ __isl_null isl_tab_lexmin *isl_tab_lexmin_free(__isl_take isl_tab_lexmin *tl)
 		return NULL;
 	isl_ctx_deref(tl->ctx);
 	isl_tab_free(tl->tab);
+	isl_mat_free(tl->T);
 	free(tl);
 
 	return NULL;
@@ -5227,6 +6592,11 @@ __isl_null isl_tab_lexmin *isl_tab_lexmin_free(__isl_take isl_tab_lexmin *tl)
 /* Construct an isl_tab_lexmin for computing
  * the lexicographically smallest rational point in "bset",
  * assuming that all variables are non-negative.
+ *
+ * If the tab-presolve option is set, then "bset" is presolved first.
+ * Since eliminating fixed variables does not affect the relative
+ * order of the remaining variables, the lexicographically smallest
+ * point of the presolved set corresponds to that of "bset".
  */
 __isl_give isl_tab_lexmin *isl_tab_lexmin_from_basic_set(
 	__isl_take isl_basic_set *bset)
@@ -5243,6 +6613,11 @@ __isl_give isl_tab_lexmin *isl_tab_lexmin_from_basic_set(
 		goto error;
 	tl->ctx = ctx;
 	isl_ctx_ref(ctx);
+	if (ctx->opt->tab_presolve) {
+		bset = isl_basic_set_presolve(bset, 1, &tl->T, NULL);
+		if (!bset)
+			return isl_tab_lexmin_free(tl);
+	}
 	tl->tab = tab_for_lexmin(bset, NULL, 0, 0);
 	isl_basic_set_free(bset);
 	if (!tl->tab)
@@ -5258,21 +6633,22 @@ error:
  */
 int isl_tab_lexmin_dim(__isl_keep isl_tab_lexmin *tl)
 {
-	return tl ? tl->tab->n_var : -1;
+	if (!tl)
+		return -1;
+	if (tl->T)
+		return tl->T->n_row - 1;
+	return tl->tab->n_var;
 }
 
-/* Add the equality with coefficients "eq" to "tl", updating the optimal
- * solution if needed.
+/* Add the equality with coefficients "eq" to the tableau of "tl",
+ * updating the optimal solution if needed.
  * The equality is added as two opposite inequality constraints.
  */
-__isl_give isl_tab_lexmin *isl_tab_lexmin_add_eq(__isl_take isl_tab_lexmin *tl,
+static __isl_give isl_tab_lexmin *lexmin_add_eq(__isl_take isl_tab_lexmin *tl,
 	isl_int *eq)
 {
 	unsigned n_var;
 
-	if (!tl || !eq)
-		return isl_tab_lexmin_free(tl);
-
 	if (isl_tab_extend_cons(tl->tab, 2) < 0)
 		return isl_tab_lexmin_free(tl);
 	n_var = tl->tab->n_var;
@@ -5287,18 +6663,53 @@ __isl_give isl_tab_lexmin *isl_tab_lexmin_add_eq(__isl_take isl_tab_lexmin *tl,
 	return tl;
 }
 
+/* Add the equality with coefficients "eq" to "tl", updating the optimal
+ * solution if needed.
+ * If "tl" was presolved, then the equality is first expressed
+ * in terms of the remaining variables.
+ */
+__isl_give isl_tab_lexmin *isl_tab_lexmin_add_eq(__isl_take isl_tab_lexmin *tl,
+	isl_int *eq)
+{
+	isl_vec *v;
+
+	if (!tl || !eq)
+		return isl_tab_lexmin_free(tl);
+
+	if (!tl->T)
+		return lexmin_add_eq(tl, eq);
+
+	v = isl_vec_alloc(tl->ctx, tl->T->n_row);
+	if (!v)
+		return isl_tab_lexmin_free(tl);
+	isl_seq_cpy(v->el, eq, v->size);
+	v = isl_vec_mat_product(v, isl_mat_copy(tl->T));
+	if (!v)
+		return isl_tab_lexmin_free(tl);
+	tl = lexmin_add_eq(tl, v->el);
+	isl_vec_free(v);
+
+	return tl;
+}
+
 /* Return the lexicographically smallest rational point in the basic set
  * from which "tl" was constructed.
  * If the original input was empty, then return a zero-length vector.
+ * If "tl" was presolved, then the sample value of the tableau
+ * is mapped back to the original space.
  */
 __isl_give isl_vec *isl_tab_lexmin_get_solution(__isl_keep isl_tab_lexmin *tl)
 {
+	isl_vec *sol;
+
 	if (!tl)
 		return NULL;
 	if (tl->tab->empty)
 		return isl_vec_alloc(tl->ctx, 0);
-	else
-		return isl_tab_get_sample_value(tl->tab);
+	sol = isl_tab_get_sample_value(tl->tab);
+	if (tl->T)
+		sol = isl_mat_vec_product(isl_mat_copy(tl->T), sol);
+	return sol;
 }
 
 /* Return the lexicographically smallest rational point in "bset",
@@ -5328,7 +6739,7 @@ static void sol_pma_free(struct isl_sol_pma *sol_pma)
 	if (!sol_pma)
 		return;
 	if (sol_pma->sol.context)
-		sol_pma->sol.context->op->free(sol_pma->sol.context);
+		isl_context_release(sol_pma->sol.context);
 	isl_pw_multi_aff_free(sol_pma->pma);
 	isl_set_free(sol_pma->empty);
 	free(sol_pma);
@@ -5481,7 +6892,7 @@ static struct isl_sol *sol_pma_init(__isl_keep isl_basic_map *bmap,
 	if (!sol_pma->pma)
 		goto error;
 
-	sol_pma->sol.context = isl_context_alloc(dom);
+	sol_pma->sol.context = isl_context_acquire(dom);
 	if (!sol_pma->sol.context)
 		goto error;
 
@@ -5503,7 +6914,9 @@ error:
 /* Base case of isl_tab_basic_map_partial_lexopt, after removing
  * some obvious symmetries.
  *
- * We call basic_map_partial_lexopt_base_sol and extract the results.
+ * We call basic_map_partial_lexopt_base_sol and extract the results,
+ * adding those of the parts of the context that were handed over
+ * to other threads, if any.
  */
 static __isl_give isl_pw_multi_aff *basic_map_partial_lexopt_base_pw_multi_aff(
 	__isl_take isl_basic_map *bmap, __isl_take isl_basic_set *dom,
@@ -5513,7 +6926,7 @@ static __isl_give isl_pw_multi_aff *basic_map_partial_lexopt_base_pw_multi_aff(
 	struct isl_sol *sol;
 	struct isl_sol_pma *sol_pma;
 
-	sol = basic_map_partial_lexopt_base_sol(bmap, dom, empty, max,
+	sol = basic_map_partial_lexopt_base_sol(bmap, dom, empty, max, 1,
 						&sol_pma_init);
 	if (!sol)
 		return NULL;
@@ -5522,6 +6935,7 @@ static __isl_give isl_pw_multi_aff *basic_map_partial_lexopt_base_pw_multi_aff(
 	result = isl_pw_multi_aff_copy(sol_pma->pma);
 	if (empty)
 		*empty = isl_set_copy(sol_pma->empty);
+	result = sol_parallel_collect_pma(sol, result, empty);
 	sol_free(&sol_pma->sol);
 	return result;
 }
@@ -5563,6 +6977,9 @@ static int need_substitution(__isl_keep isl_multi_aff *maff)
  * The affine expression on this cell is
  *
  *	b_i
+ *
+ * Each row of "var" is of the form b_i - m >= 0, i.e.,
+ * this function is only called if all_unit_bounds holds.
  */
 static __isl_give isl_pw_aff *set_minimum_pa(__isl_take isl_space *space,
 	__isl_take isl_mat *var)
@@ -5592,8 +7009,8 @@ static __isl_give isl_pw_aff *set_minimum_pa(__isl_take isl_space *space,
 		if (!aff || !bset)
 			goto error;
 		isl_int_set_si(aff->v->el[0], 1);
-		isl_seq_cpy(aff->v->el + 1, var->row[i], var->n_col);
-		isl_int_set_si(aff->v->el[1 + var->n_col], 0);
+		isl_seq_cpy(aff->v->el + 1, var->row[i], var->n_col - 1);
+		isl_int_set_si(aff->v->el[var->n_col], 0);
 		bset = select_minimum(bset, var, i);
 		paff_i = isl_pw_aff_alloc(isl_set_from_basic_set(bset), aff);
 		paff = isl_pw_aff_add_disjoint(paff, paff_i);
@@ -5624,6 +7041,14 @@ error:
  * is plugged in.  Otherwise, if the variable appears in the constraints
  * and a split is required, then the domain is split.  Otherwise, no split
  * is performed.
+ *
+ * If some of the bounds in "cst" are of the form m <= floor(b_i/s_i)
+ * with s_i > 1, then "min_expr_pa" is NULL since the minimum
+ * is not affine on the cells of "min_expr" and isl_pw_multi_aff_substitute
+ * cannot plug in expressions involving integer divisions.
+ * The expressions that involve the variable are then instead
+ * converted to a map, intersected with "min_expr" and converted back
+ * after projecting out the variable.
  */
 static __isl_give isl_pw_multi_aff *split_domain_pma(
 	__isl_take isl_pw_multi_aff *opt, __isl_take isl_pw_aff *min_expr_pa,
@@ -5647,6 +7072,17 @@ static __isl_give isl_pw_multi_aff *split_domain_pma(
 
 		pma = isl_pw_multi_aff_alloc(isl_set_copy(opt->p[i].set),
 					 isl_multi_aff_copy(opt->p[i].maff));
+		if (need_substitution(opt->p[i].maff) && !min_expr_pa) {
+			isl_map *map;
+
+			map = isl_map_from_pw_multi_aff(pma);
+			map = isl_map_intersect_domain(map,
+						       isl_set_copy(min_expr));
+			map = isl_map_project_out(map, isl_dim_in, n_in - 1, 1);
+			pma = isl_pw_multi_aff_from_map(map);
+			res = isl_pw_multi_aff_add_disjoint(res, pma);
+			continue;
+		}
 		if (need_substitution(opt->p[i].maff))
 			pma = isl_pw_multi_aff_substitute(pma,
 					isl_dim_in, n_in - 1, min_expr_pa);
@@ -5696,8 +7132,10 @@ basic_map_partial_lexopt_symm_core_pw_multi_aff(
 	isl_set *min_expr;
 
 	min_expr = set_minimum(isl_basic_set_get_space(dom), isl_mat_copy(cst));
-	min_expr_pa = set_minimum_pa(isl_basic_set_get_space(dom),
-					isl_mat_copy(cst));
+	min_expr_pa = NULL;
+	if (all_unit_bounds(cst))
+		min_expr_pa = set_minimum_pa(isl_basic_set_get_space(dom),
+						isl_mat_copy(cst));
 
 	opt = basic_map_partial_lexopt_pw_multi_aff(bmap, dom, empty, max);
 
@@ -18,6 +18,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <limits.h>
+#include <isl_config.h>
 #include <isl_ctx_private.h>
 #include <isl_map_private.h>
 #include <isl_aff_private.h>
@@ -32,6 +33,10 @@
 #include <isl/schedule.h>
 #include <isl/schedule_node.h>
 #include <isl_options_private.h>
+#include <isl_seq.h>
+#include <isl_mat_private.h>
+#include <isl_vec_private.h>
+#include <isl_tab.h>
 #include <isl/vertices.h>
 #include <isl/ast_build.h>
 #include <isl/val.h>
@@ -557,6 +562,25 @@ struct {
 	{ "NaN", '/', "-infty", "NaN" },
 	{ "1", '-', "1/3", "2/3" },
 	{ "1/3", '+', "1/2", "5/6" },
+	{ "1/6", '+', "1/3", "1/2" },
+	{ "3/10", '+', "1/15", "11/30" },
+	{ "5/6", '-', "1/3", "1/2" },
+	{ "1/6", '-', "3/10", "-2/15" },
+	{ "-3/4", '+', "5/6", "1/12" },
+	{ "2/3", '*', "3/4", "1/2" },
+	{ "-2/3", '*', "9/4", "-3/2" },
+	{ "-2/3", '/', "4/9", "-3/2" },
+	{ "2/3", '/', "-4/9", "-3/2" },
+	{ "-2/3", '/', "-2/3", "1" },
+	{ "6", '/', "-4", "-3/2" },
+	{ "1/2147483647", '+', "1/2147483646",
+	  "4294967293/4611686011984936962" },
+	{ "1/2147483647", '-', "1/2147483646",
+	  "-1/4611686011984936962" },
+	{ "2147483647/2", '*', "2147483647/3", "4611686014132420609/6" },
+	{ "2147483647/2", '/', "-3/2147483647", "-4611686014132420609/6" },
+	{ "2147483648/3", '+', "1/2", "4294967299/6" },
+	{ "2147483648/3", '*', "3/2147483648", "1" },
 	{ "1/2", '+', "1/2", "1" },
 	{ "3/4", '-', "1/4", "1/2" },
 	{ "1/2", '-', "1/3", "1/6" },
@@ -2389,6 +2413,361 @@ static int test_lexmin(struct isl_ctx *ctx)
 	return 0;
 }
 
+/* Parametric maps for which the lexicographic optimum is computed
+ * in test_pip_threads.
+ */
+static const char *pip_threads_tests[] = {
+	"[n, m] -> { [i] -> [j] : j >= i and j >= n and j >= m and j <= 100 }",
+	"[N, M] -> { [i, j] -> [a, b] : 0 <= a <= N and 0 <= b <= M and "
+		"a + b >= i and 2a - b <= j and a - 3b <= i + j + N }",
+	"[n] -> { [i] -> [j, k] : 3j >= i + n and 5k >= j - n and "
+		"j <= 100 and -100 <= k <= 100 }",
+};
+
+/* Check that computing the lexicographic minimum and maximum
+ * with context splits handed off to other threads produces
+ * the same results as a sequential computation and
+ * that some context splits are actually handed off.
+ */
+static int test_pip_threads(isl_ctx *ctx)
+{
+	int i;
+	int r = 0;
+	int threads;
+	long branches;
+	isl_map *map, *seq, *par;
+	isl_pw_multi_aff *pma;
+	isl_bool equal;
+
+	threads = isl_options_get_pip_threads(ctx);
+	branches = ctx->stats->pip_parallel_branches;
+	for (i = 0; r >= 0 && i < ARRAY_SIZE(pip_threads_tests); ++i) {
+		map = isl_map_read_from_str(ctx, pip_threads_tests[i]);
+		isl_options_set_pip_threads(ctx, 0);
+		seq = isl_map_lexmin(isl_map_copy(map));
+		isl_options_set_pip_threads(ctx, 4);
+		par = isl_map_lexmin(isl_map_copy(map));
+		equal = isl_map_is_equal(seq, par);
+		isl_map_free(seq);
+		isl_map_free(par);
+		isl_options_set_pip_threads(ctx, 0);
+		seq = isl_map_lexmax(isl_map_copy(map));
+		isl_options_set_pip_threads(ctx, 4);
+		pma = isl_map_lexmax_pw_multi_aff(map);
+		par = isl_map_from_pw_multi_aff(pma);
+		if (equal >= 0 && equal)
+			equal = isl_map_is_equal(seq, par);
+		isl_map_free(seq);
+		isl_map_free(par);
+		if (equal < 0)
+			r = -1;
+		else if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"parallel result differs from sequential result",
+				r = -1);
+	}
+#ifdef HAVE_PTHREAD_H
+	if (r >= 0 && ctx->stats->pip_parallel_branches == branches)
+		isl_die(ctx, isl_error_unknown,
+			"no context split handed off", r = -1);
+#endif
+	isl_options_set_pip_threads(ctx, threads);
+
+	return r;
+}
+
+static int pip_split[] = {
+	ISL_PIP_SPLIT_REDUNDANT,
+	ISL_PIP_SPLIT_DIVS,
+	ISL_PIP_SPLIT_CONSTRAINED,
+	ISL_PIP_SPLIT_LOOKAHEAD,
+};
+
+/* Check that computing the lexicographic minimum and maximum
+ * of the maps in pip_threads_tests produces the same results
+ * for each of the split heuristics and that the splits and pieces
+ * are recorded in the statistics.
+ */
+static int test_pip_split(isl_ctx *ctx)
+{
+	int i, j;
+	int r = 0;
+	int split;
+	long splits, pieces;
+	isl_map *map, *ref_min, *ref_max, *res;
+	isl_bool equal;
+
+	split = isl_options_get_pip_split(ctx);
+	splits = ctx->stats->pip_splits;
+	pieces = ctx->stats->pip_pieces;
+	for (i = 0; r >= 0 && i < ARRAY_SIZE(pip_threads_tests); ++i) {
+		map = isl_map_read_from_str(ctx, pip_threads_tests[i]);
+		isl_options_set_pip_split(ctx, ISL_PIP_SPLIT_REDUNDANT);
+		ref_min = isl_map_lexmin(isl_map_copy(map));
+		ref_max = isl_map_lexmax(isl_map_copy(map));
+		equal = isl_bool_true;
+		for (j = 1; equal == isl_bool_true &&
+			    j < ARRAY_SIZE(pip_split); ++j) {
+			isl_options_set_pip_split(ctx, pip_split[j]);
+			res = isl_map_lexmin(isl_map_copy(map));
+			equal = isl_map_is_equal(ref_min, res);
+			isl_map_free(res);
+			if (equal != isl_bool_true)
+				break;
+			res = isl_map_lexmax(isl_map_copy(map));
+			equal = isl_map_is_equal(ref_max, res);
+			isl_map_free(res);
+		}
+		isl_map_free(ref_min);
+		isl_map_free(ref_max);
+		isl_map_free(map);
+		if (equal < 0)
+			r = -1;
+		else if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"result depends on split heuristic", r = -1);
+	}
+	if (r >= 0 && (ctx->stats->pip_splits == splits ||
+		       ctx->stats->pip_pieces == pieces))
+		isl_die(ctx, isl_error_unknown,
+			"splits or pieces not recorded", r = -1);
+	isl_options_set_pip_split(ctx, split);
+
+	return r;
+}
+
+/* Inputs for test_pip_symmetry, containing families of constraints
+ * with the same coefficients for the optimized variables
+ * up to a positive scaling factor, some of which involve
+ * input variables or parameters that are shared by several members.
+ */
+static const char *pip_symmetry_tests[] = {
+	"[n, m] -> { [i] -> [j] : j >= i and j >= n and j >= m and j <= 100 }",
+	"[n, m] -> { [i] -> [j] : 2j >= n and 3j >= m and j >= i and j <= 100 }",
+	"[n, m] -> { [i] -> [j] : 2j >= n and 4j >= m + 1 and 6j >= n + m and "
+		"j >= i and j <= 100 }",
+	"[n, m] -> { [i] -> [j, k] : 2j + 4k >= n and j + 2k >= m and "
+		"3j + 6k >= n - m and 0 <= j <= 10 and 0 <= k <= 10 }",
+	"[n, m, p] -> { [i] -> [j] : j >= n + m and j >= n - p and "
+		"2j >= m + p and j >= i and j <= 50 }",
+	"[n] -> { [i] -> [j] : 2j >= n and 3j >= i and j <= 20 and "
+		"5j <= i + n + 40 }",
+	"[n, m] -> { [i] -> [j, k] : 3j >= n and 2j >= m and k >= 2j - i and "
+		"k <= 100 and j <= 100 }",
+	"[n, m] -> { [i] -> [j] : 2j >= n + i and 3j >= m - i and j <= 100 }",
+	"[n, m] -> { [i] -> [j, k] : 0 <= j <= 20 and 0 <= k <= 20 and "
+		"j + k <= i + 15 and 6j + 3k >= 2n - 2m - i - 5 and "
+		"6j + 3k >= n - m - i - 4 and 4j + 2k >= n - m + i + 1 }",
+};
+
+/* Compute the lexicographic minimum of "map" as an isl_map,
+ * along with the part of the parameter domain where it is empty,
+ * and the lexicographic minimum and maximum as isl_pw_multi_affs,
+ * storing the results in "res".
+ */
+static void pip_symmetry_compute(__isl_keep isl_map *map, isl_map *res[4])
+{
+	isl_set *dom;
+	isl_set *empty = NULL;
+
+	dom = isl_set_universe(isl_space_domain(isl_map_get_space(map)));
+	res[0] = isl_map_partial_lexmin(isl_map_copy(map), dom, &empty);
+	res[1] = isl_map_from_domain(empty);
+	res[2] = isl_map_from_pw_multi_aff(
+			isl_map_lexmin_pw_multi_aff(isl_map_copy(map)));
+	res[3] = isl_map_from_pw_multi_aff(
+			isl_map_lexmax_pw_multi_aff(isl_map_copy(map)));
+}
+
+/* Check that computing the lexicographic optima of the maps
+ * in pip_symmetry_tests produces the same results
+ * with and without symmetry detection.
+ */
+static int test_pip_symmetry(isl_ctx *ctx)
+{
+	int i, j;
+	int r = 0;
+	int symmetry;
+	isl_map *map, *ref[4], *res[4];
+	isl_bool equal;
+
+	symmetry = isl_options_get_pip_symmetry(ctx);
+	for (i = 0; r >= 0 && i < ARRAY_SIZE(pip_symmetry_tests); ++i) {
+		map = isl_map_read_from_str(ctx, pip_symmetry_tests[i]);
+		isl_options_set_pip_symmetry(ctx, 0);
+		pip_symmetry_compute(map, ref);
+		isl_options_set_pip_symmetry(ctx, 1);
+		pip_symmetry_compute(map, res);
+		equal = isl_bool_true;
+		for (j = 0; j < 4; ++j) {
+			if (equal == isl_bool_true)
+				equal = isl_map_is_equal(ref[j], res[j]);
+			isl_map_free(ref[j]);
+			isl_map_free(res[j]);
+		}
+		isl_map_free(map);
+		if (equal < 0)
+			r = -1;
+		else if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"result depends on symmetry detection", r = -1);
+	}
+	isl_options_set_pip_symmetry(ctx, symmetry);
+
+	return r;
+}
+
+/* Add the piece "dom" -> "maff" to the isl_pw_multi_aff "user".
+ */
+static isl_stat add_lexopt_piece(__isl_take isl_basic_set *dom,
+	__isl_take isl_multi_aff *maff, void *user)
+{
+	isl_pw_multi_aff **pma = user;
+	isl_pw_multi_aff *piece;
+
+	piece = isl_pw_multi_aff_alloc(isl_set_from_basic_set(dom), maff);
+	*pma = isl_pw_multi_aff_add_disjoint(*pma, piece);
+
+	return *pma ? isl_stat_ok : isl_stat_error;
+}
+
+/* Abort the computation on the first piece.
+ */
+static isl_stat abort_lexopt_piece(__isl_take isl_basic_set *dom,
+	__isl_take isl_multi_aff *maff, void *user)
+{
+	isl_basic_set_free(dom);
+	isl_multi_aff_free(maff);
+
+	return isl_stat_error;
+}
+
+/* Basic maps for which the pieces of the lexicographic minimum and
+ * maximum are collected in test_foreach_lexmin.
+ */
+static const char *foreach_lexmin_tests[] = {
+	"[n, m] -> { [i] -> [j] : j >= i and j >= n and j >= m and j <= 100 }",
+	"{ [x] -> [y] : x - 2 <= 4y <= x }",
+	"[N] -> { [i] -> [a, b] : 0 <= a <= N and 0 <= b <= i and "
+		"exists (e : 2e = a + b) }",
+	"[n] -> { [j, k] : 3j >= n and 5k >= j - n and -100 <= k <= 100 }",
+};
+
+/* Check that the pieces passed to the callback of
+ * isl_basic_map_foreach_lexmin and isl_basic_map_foreach_lexmax
+ * together form the lexicographic minimum and maximum and
+ * that the computation is aborted if the callback returns an error.
+ */
+static int test_foreach_lexmin(isl_ctx *ctx)
+{
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(foreach_lexmin_tests); ++i) {
+		for (j = 0; j < 2; ++j) {
+			isl_basic_map *bmap;
+			isl_pw_multi_aff *pma;
+			isl_map *map1, *map2;
+			isl_stat r;
+			isl_bool equal;
+
+			bmap = isl_basic_map_read_from_str(ctx,
+						foreach_lexmin_tests[i]);
+			pma = isl_pw_multi_aff_empty(
+					isl_basic_map_get_space(bmap));
+			if (j)
+				r = isl_basic_map_foreach_lexmax(bmap,
+						&add_lexopt_piece, &pma);
+			else
+				r = isl_basic_map_foreach_lexmin(bmap,
+						&add_lexopt_piece, &pma);
+			map1 = isl_map_from_pw_multi_aff(pma);
+			if (j)
+				map2 = isl_basic_map_lexmax(bmap);
+			else
+				map2 = isl_basic_map_lexmin(bmap);
+			equal = isl_map_is_equal(map1, map2);
+			isl_map_free(map1);
+			isl_map_free(map2);
+			if (r < 0 || equal < 0)
+				return -1;
+			if (!equal)
+				isl_die(ctx, isl_error_unknown,
+					"pieces do not form optimum",
+					return -1);
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(foreach_lexmin_tests); ++i) {
+		isl_basic_map *bmap;
+		isl_stat r;
+
+		bmap = isl_basic_map_read_from_str(ctx,
+						foreach_lexmin_tests[i]);
+		r = isl_basic_map_foreach_lexmin(bmap,
+						&abort_lexopt_piece, NULL);
+		isl_basic_map_free(bmap);
+		if (r >= 0)
+			isl_die(ctx, isl_error_unknown,
+				"computation not aborted", return -1);
+	}
+
+	return 0;
+}
+
+/* Maps and domains for which the partial lexicographic minimum
+ * is computed in test_shared_contexts.
+ */
+static struct {
+	const char *map;
+	const char *dom;
+} shared_contexts_tests[] = {
+	{ "[n] -> { [i] -> [j] : 0 <= j <= n and j >= i; "
+		"[i] -> [j] : 0 <= j <= n and j >= 2i - 5 }",
+	  "[n] -> { [i] : 0 <= i <= n }" },
+	{ "[n] -> { [i] -> [j, k] : 0 <= j <= n and k >= i - j and k >= 0; "
+		"[i] -> [j, k] : i <= j <= n and k = 2j; "
+		"[i] -> [j, k] : 3j >= i and k >= j and k <= n }",
+	  "[n] -> { [i] : 0 <= i <= 3 or 10 <= i <= n }" },
+};
+
+/* Check that the partial lexicographic minimum of a map
+ * with several disjuncts over a domain is computed correctly and
+ * that the context tableaus for the domain are shared
+ * among the disjuncts.
+ */
+static int test_shared_contexts(isl_ctx *ctx)
+{
+	int i;
+	long shared;
+
+	shared = ctx->stats->pip_shared_contexts;
+	for (i = 0; i < ARRAY_SIZE(shared_contexts_tests); ++i) {
+		isl_map *map, *res, *expected;
+		isl_set *dom;
+		isl_bool equal;
+
+		map = isl_map_read_from_str(ctx, shared_contexts_tests[i].map);
+		dom = isl_set_read_from_str(ctx, shared_contexts_tests[i].dom);
+		expected = isl_map_intersect_domain(isl_map_copy(map),
+							isl_set_copy(dom));
+		expected = isl_map_lexmin(expected);
+		res = isl_map_partial_lexmin(map, dom, NULL);
+		equal = isl_map_is_equal(res, expected);
+		isl_map_free(res);
+		isl_map_free(expected);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected partial lexmin", return -1);
+	}
+	if (ctx->stats->pip_shared_contexts == shared)
+		isl_die(ctx, isl_error_unknown,
+			"no context tableau shared", return -1);
+
+	return 0;
+}
+
 /* A specialized isl_set_min_val test case that would return the wrong result
  * in earlier versions of isl.
  * The explicit call to isl_basic_set_union prevents the second basic set
@@ -2439,7 +2818,13 @@ struct {
 	{ "{ [a, b] : 0 <= a, b <= 100 and b mod 2 = 0}",
 	  "{ [a, b] -> [floor((b - 2*floor((-a)/4))/5)] }",
 	  &isl_set_max_val, "30" },
-
+	{ "{ [x, y, z] : x, y, z >= 0 and x + y + z <= 10 and x + y <= 10 and "
+	  "x + z <= 10 and y + z <= 10 and x + 2y + z <= 20 }",
+	  "{ [x, y, z] -> [x + 2y + 3z] }", &isl_set_max_val, "30" },
+	{ "{ [x, y] : 0 <= x, y <= 4 and x + y <= 4 and x - y <= 4 and "
+	  "y - x <= 4 }", "{ [x, y] -> [3x + y] }", &isl_set_max_val, "12" },
+	{ "{ [x, y] : 0 <= x, y <= 4 and x + y <= 4 and x - y <= 4 and "
+	  "y - x <= 4 }", "{ [x, y] -> [x - 3y] }", &isl_set_min_val, "-12" },
 };
 
 /* Perform basic isl_set_min_val and isl_set_max_val tests.
@@ -2471,12 +2856,539 @@ static int test_min(struct isl_ctx *ctx)
 				"unexpected optimum", return -1);
 	}
 
-	if (test_min_special(ctx) < 0)
+	if (test_min_special(ctx) < 0)
+		return -1;
+
+	return 0;
+}
+
+struct {
+	const char *set;
+	const char *obj;
+	__isl_give isl_multi_val *(*fn)(__isl_keep isl_set *set,
+		__isl_keep isl_multi_aff *obj);
+	const char *res;
+} opt_multi_tests[] = {
+	{ "{ [-1]; [1] }", "{ [x] -> [x, -x, 2x + 1] }",
+	  &isl_set_min_multi_aff, "{ [-1, -1, -1] }" },
+	{ "{ [x, y] : 0 <= x, y <= 4 and x + y <= 4 and x - y <= 4 and "
+	  "y - x <= 4 }", "{ [x, y] -> [3x + y, x - 3y, x, y] }",
+	  &isl_set_max_multi_aff, "{ [12, 4, 4, 4] }" },
+	{ "{ [x, y] : 0 <= x, y <= 4 and x + y <= 4 and x - y <= 4 and "
+	  "y - x <= 4 }", "{ [x, y] -> [3x + y, x - 3y, x, y] }",
+	  &isl_set_min_multi_aff, "{ [0, -12, 0, 0] }" },
+	{ "{ [x, y] : 2x = 3y and 0 <= y <= 5 }", "{ [x, y] -> [x, y, x - y] }",
+	  &isl_set_max_multi_aff, "{ [6, 4, 2] }" },
+	{ "{ [a, b] : 0 <= a, b <= 100 and b mod 2 = 0}",
+	  "{ [a, b] -> [floor((b - 2*floor((-a)/4))/5), a + b] }",
+	  &isl_set_max_multi_aff, "{ [30, 200] }" },
+	{ "{ [x, y] : x >= 0 and y <= 0 }", "{ [x, y] -> [x, y] }",
+	  &isl_set_max_multi_aff, "{ [infty, 0] }" },
+};
+
+/* Perform basic isl_set_min_multi_aff and isl_set_max_multi_aff tests.
+ * Since NaN is not equal to itself, the result on an empty set
+ * is checked separately.
+ */
+static int test_min_multi(struct isl_ctx *ctx)
+{
+	int i;
+	isl_set *set;
+	isl_multi_aff *obj;
+	isl_multi_val *mv, *res;
+	isl_val *v;
+	isl_bool ok;
+
+	for (i = 0; i < ARRAY_SIZE(opt_multi_tests); ++i) {
+		set = isl_set_read_from_str(ctx, opt_multi_tests[i].set);
+		obj = isl_multi_aff_read_from_str(ctx, opt_multi_tests[i].obj);
+		res = isl_multi_val_read_from_str(ctx, opt_multi_tests[i].res);
+		mv = opt_multi_tests[i].fn(set, obj);
+		ok = isl_multi_val_plain_is_equal(res, mv);
+		isl_multi_val_free(res);
+		isl_multi_val_free(mv);
+		isl_multi_aff_free(obj);
+		isl_set_free(set);
+
+		if (ok < 0)
+			return -1;
+		if (!ok)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected optima", return -1);
+	}
+
+	set = isl_set_read_from_str(ctx, "{ [x] : x > 0 and x < 0 }");
+	obj = isl_multi_aff_read_from_str(ctx, "{ [x] -> [x, -x] }");
+	mv = isl_set_min_multi_aff(set, obj);
+	isl_multi_aff_free(obj);
+	isl_set_free(set);
+	if (!mv)
+		return -1;
+	ok = isl_bool_true;
+	for (i = 0; ok == isl_bool_true && i < 2; ++i) {
+		v = isl_multi_val_get_val(mv, i);
+		ok = isl_val_is_nan(v);
+		isl_val_free(v);
+	}
+	isl_multi_val_free(mv);
+	if (ok < 0)
+		return -1;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown,
+			"expecting NaN on empty set", return -1);
+
+	return 0;
+}
+
+/* Run "test" with the integer option accessed through "get" and "set"
+ * temporarily set to "val" and check that this increases
+ * the statistics counter "counter".
+ * "msg" is the error message in case it does not.
+ */
+static int test_with_option(isl_ctx *ctx, int (*get)(isl_ctx *ctx),
+	isl_stat (*set)(isl_ctx *ctx, int val), int val,
+	int (*test)(isl_ctx *ctx), long *counter, const char *msg)
+{
+	int r;
+	int orig;
+	long old;
+
+	orig = get(ctx);
+	if (set(ctx, val) < 0)
+		return -1;
+	old = *counter;
+	r = test(ctx);
+	if (r >= 0 && *counter == old)
+		isl_die(ctx, isl_error_unknown, msg, r = -1);
+	set(ctx, orig);
+
+	return r;
+}
+
+static int tab_pricing[] = {
+	ISL_TAB_PRICING_BLAND,
+	ISL_TAB_PRICING_DEVEX,
+	ISL_TAB_PRICING_STEEPEST_EDGE,
+	ISL_TAB_PRICING_RANDOM,
+};
+
+/* Check that the isl_set_min_val and isl_set_max_val tests
+ * produce the same results for each of the pricing rules and
+ * that the pivots are recorded in the statistics.
+ */
+static int test_tab_pricing(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tab_pricing); ++i)
+		if (test_with_option(ctx, &isl_options_get_tab_pricing,
+			    &isl_options_set_tab_pricing, tab_pricing[i],
+			    &test_min, &ctx->stats->tab_pivots,
+			    "pivots not recorded") < 0)
+			return -1;
+
+	return 0;
+}
+
+/* Check that the maximum of y over the set below is computed correctly.
+ * The constant 2^53 + 5 gets converted to the double 2^53 + 4,
+ * so in floating point, the constraints 2x + y <= 2^53 + 4 and
+ * x + y <= 2^53 + 5 both appear to bound y to 2^53 + 4.
+ * If the floating point simplex picks the basis where x + y <= 2^53 + 5
+ * is tight, then this basis violates the other constraint in exact
+ * arithmetic and needs to be rejected.
+ */
+static int test_tab_float_rejected(isl_ctx *ctx)
+{
+	int r = 0;
+	const char *str;
+	isl_set *set;
+	isl_aff *obj;
+	isl_val *v, *res;
+
+	str = "{ [x, y] : x >= 0 and y >= 0 and "
+		"2x + y <= 9007199254740996 and x + y <= 9007199254740997 }";
+	set = isl_set_read_from_str(ctx, str);
+	obj = isl_aff_read_from_str(ctx, "{ [x, y] -> [y] }");
+	v = isl_set_max_val(set, obj);
+	res = isl_val_read_from_str(ctx, "9007199254740996");
+	if (!v || !res)
+		r = -1;
+	else if (!isl_val_eq(v, res))
+		isl_die(ctx, isl_error_unknown, "unexpected maximum", r = -1);
+	isl_val_free(res);
+	isl_val_free(v);
+	isl_aff_free(obj);
+	isl_set_free(set);
+
+	return r;
+}
+
+/* Check that the isl_set_min_val and isl_set_max_val tests
+ * produce the same results when an optimal basis is first computed
+ * in floating point and that some of these bases are accepted.
+ * Also check that a basis that is infeasible in exact arithmetic
+ * gets rejected without affecting the result.
+ */
+static int test_tab_float_filter(isl_ctx *ctx)
+{
+	if (test_with_option(ctx, &isl_options_get_tab_float_filter,
+		    &isl_options_set_tab_float_filter, 1, &test_min,
+		    &ctx->stats->tab_float_accepted,
+		    "no floating point basis accepted") < 0)
+		return -1;
+	return test_with_option(ctx, &isl_options_get_tab_float_filter,
+		&isl_options_set_tab_float_filter, 1, &test_tab_float_rejected,
+		&ctx->stats->tab_float_rejected,
+		"no floating point basis rejected");
+}
+
+/* Check that pivoting a tableau on an element different from one
+ * results in the same tableau when the other rows are updated
+ * in a sparse way (tab-sparse-density 100) as when they are updated
+ * in a dense way (tab-sparse-density 0).
+ * The pivot element is the coefficient 3 of x in the constraint
+ * 3x + z >= 0, such that the pivot row has a zero entry and
+ * ends up with denominator 3.  The other rows therefore need
+ * to be scaled by this denominator.
+ * Only the rows that are in use are compared.
+ */
+static int test_tab_sparse_pivot(isl_ctx *ctx)
+{
+	int i, j, k;
+	int row = -1, col = -1;
+	int density;
+	int equal;
+	long sparse[2];
+	const char *str;
+	isl_basic_set *bset;
+	struct isl_tab *tab[2];
+	int val[2] = { 100, 0 };
+
+	str = "{ [x, y, z] : 3x + z >= 0 and x + y + z <= 10 and "
+		"2x - y + 5 >= 0 and y >= -4 and 2z - x + 7 >= 0 }";
+	bset = isl_basic_set_read_from_str(ctx, str);
+	tab[0] = isl_tab_from_basic_set(bset, 0);
+	tab[1] = isl_tab_from_basic_set(bset, 0);
+	isl_basic_set_free(bset);
+	if (!tab[0] || !tab[1])
+		goto error;
+
+	for (i = tab[0]->n_redundant; row < 0 && i < tab[0]->n_row; ++i)
+		for (j = 0; j < tab[0]->n_col; ++j)
+			if (isl_int_cmp_si(tab[0]->mat->row[i][2 + j], 3) == 0) {
+				row = i;
+				col = j;
+				break;
+			}
+	if (row < 0)
+		isl_die(ctx, isl_error_unknown, "pivot element not found",
+			goto error);
+
+	density = isl_options_get_tab_sparse_density(ctx);
+	for (k = 0; k < 2; ++k) {
+		int r;
+
+		isl_options_set_tab_sparse_density(ctx, val[k]);
+		sparse[k] = ctx->stats->tab_sparse_pivots;
+		r = isl_tab_pivot(tab[k], row, col);
+		sparse[k] = ctx->stats->tab_sparse_pivots - sparse[k];
+		if (r < 0)
+			break;
+	}
+	isl_options_set_tab_sparse_density(ctx, density);
+	if (k < 2)
+		goto error;
+
+	if (sparse[0] != 1 || sparse[1] != 0)
+		isl_die(ctx, isl_error_unknown, "unexpected type of pivot",
+			goto error);
+	if (isl_int_is_one(tab[0]->mat->row[row][0]))
+		isl_die(ctx, isl_error_unknown,
+			"expecting non-trivial denominator", goto error);
+	equal = tab[0]->n_row == tab[1]->n_row;
+	for (i = 0; equal && i < tab[0]->n_row; ++i)
+		equal = isl_seq_eq(tab[0]->mat->row[i], tab[1]->mat->row[i],
+				    2 + tab[0]->n_col);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"sparse and dense pivots differ", goto error);
+
+	isl_tab_free(tab[0]);
+	isl_tab_free(tab[1]);
+	return 0;
+error:
+	isl_tab_free(tab[0]);
+	isl_tab_free(tab[1]);
+	return -1;
+}
+
+/* Check that the isl_set_min_val and isl_set_max_val tests,
+ * along with a test where variable x is fixed,
+ * produce the same results when the integer linear programs
+ * are presolved.
+ */
+static int test_tab_presolve_min(isl_ctx *ctx)
+{
+	int r;
+	const char *str;
+	isl_set *set;
+	isl_aff *obj;
+	isl_val *res;
+
+	if (test_min(ctx) < 0)
+		return -1;
+
+	str = "{ [x, y, z] : x = 3 and 0 <= y <= 10 and "
+		"y + z <= 7 and z >= 0 }";
+	set = isl_set_read_from_str(ctx, str);
+	obj = isl_aff_read_from_str(ctx, "{ [x, y, z] -> [x + y + z] }");
+	res = isl_set_max_val(set, obj);
+	r = 0;
+	if (!res)
+		r = -1;
+	else if (isl_val_cmp_si(res, 10) != 0)
+		isl_die(ctx, isl_error_unknown, "unexpected maximum", r = -1);
+	isl_val_free(res);
+	isl_aff_free(obj);
+	isl_set_free(set);
+
+	return r;
+}
+
+/* Compute the lexicographically smallest non-negative rational point
+ * of the basic set described by "str", in sol[0], and
+ * the one after imposing that the second and third variables
+ * are equal, in sol[1].
+ */
+static isl_stat tab_lexmin_with_eq(isl_ctx *ctx, const char *str,
+	isl_vec *sol[2])
+{
+	int dim;
+	isl_basic_set *bset;
+	isl_tab_lexmin *tl;
+	isl_vec *eq;
+
+	bset = isl_basic_set_read_from_str(ctx, str);
+	tl = isl_tab_lexmin_from_basic_set(bset);
+	sol[0] = isl_tab_lexmin_get_solution(tl);
+	dim = isl_tab_lexmin_dim(tl);
+	if (dim < 0) {
+		isl_tab_lexmin_free(tl);
+		return isl_stat_error;
+	}
+	eq = isl_vec_clr(isl_vec_alloc(ctx, 1 + dim));
+	eq = isl_vec_set_element_si(eq, 2, 1);
+	eq = isl_vec_set_element_si(eq, 3, -1);
+	if (!eq)
+		tl = isl_tab_lexmin_free(tl);
+	else
+		tl = isl_tab_lexmin_add_eq(tl, eq->el);
+	sol[1] = isl_tab_lexmin_get_solution(tl);
+	isl_vec_free(eq);
+	isl_tab_lexmin_free(tl);
+
+	sol[0] = isl_vec_normalize(sol[0]);
+	sol[1] = isl_vec_normalize(sol[1]);
+	if (!sol[0] || !sol[1])
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Check that presolving a non-negative set with a fixed variable (a)
+ * and a singleton upper bound (d <= 0) does not affect
+ * its lexicographically smallest point, not even after
+ * an additional equality is imposed.
+ * The equality is expressed in terms of the original variables and
+ * needs to be mapped to the presolved set by isl_tab_lexmin_add_eq.
+ */
+static int test_tab_presolve_lexmin(isl_ctx *ctx)
+{
+	int i, j;
+	int presolve;
+	long fixed;
+	isl_stat r = isl_stat_ok;
+	isl_bool equal = isl_bool_true;
+	const char *str;
+	isl_vec *sol[2][2] = { { NULL } };
+
+	str = "{ [a, b, c, d] : a = 2 and d <= 0 and c + d >= 3 and "
+		"b + c >= 4 and b <= 10 }";
+	presolve = isl_options_get_tab_presolve(ctx);
+	fixed = ctx->stats->presolve_fixed_vars;
+	for (i = 0; r >= 0 && i < 2; ++i) {
+		isl_options_set_tab_presolve(ctx, i);
+		r = tab_lexmin_with_eq(ctx, str, sol[i]);
+	}
+	isl_options_set_tab_presolve(ctx, presolve);
+	for (j = 0; r >= 0 && equal == isl_bool_true && j < 2; ++j)
+		equal = isl_vec_is_equal(sol[0][j], sol[1][j]);
+	for (i = 0; i < 2; ++i)
+		for (j = 0; j < 2; ++j)
+			isl_vec_free(sol[i][j]);
+
+	if (r < 0 || equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"presolving changes lexicographic minimum", return -1);
+	if (ctx->stats->presolve_fixed_vars < fixed + 2)
+		isl_die(ctx, isl_error_unknown, "variables not eliminated",
+			return -1);
+
+	return 0;
+}
+
+#define N_PRESOLVE_CONFLICT	10
+
+/* The constraints reported by isl_tab_basic_set_non_trivial_lexmin
+ * as being involved in a conflict.
+ */
+struct presolve_conflict_data {
+	int n;
+	int con[N_PRESOLVE_CONFLICT];
+};
+
+/* Record the conflicting constraint "con" in "user".
+ */
+static int record_conflict(int con, void *user)
+{
+	struct presolve_conflict_data *data = user;
+
+	if (data->n >= N_PRESOLVE_CONFLICT)
+		return -1;
+	data->con[data->n++] = con;
+	return 0;
+}
+
+/* Check that isl_tab_basic_set_non_trivial_lexmin reports
+ * the same conflicting constraints with and without presolving.
+ * The set has no solution that is non-trivial on c and d.
+ * The conflict involves the constraint c + d <= 0 and
+ * the constraint that is added to force c and d to be different.
+ * Presolving removes the constraints a >= 0 and b >= -2,
+ * one before and one after c + d <= 0, so the positions
+ * of the conflicting constraints in the presolved set
+ * need to be mapped back to the original set.
+ */
+static int test_tab_presolve_conflict(isl_ctx *ctx)
+{
+	int i;
+	int presolve;
+	long singleton;
+	const char *str;
+	isl_basic_set *bset;
+	isl_vec *sol;
+	struct isl_region region = { 2, 2 };
+	struct presolve_conflict_data data[2] = { { 0 }, { 0 } };
+
+	str = "{ [a, b, c, d] : a >= 0 and c + d <= 0 and b >= -2 and "
+		"a + b <= 5 }";
+	bset = isl_basic_set_read_from_str(ctx, str);
+	presolve = isl_options_get_tab_presolve(ctx);
+	for (i = 0; i < 2; ++i) {
+		isl_options_set_tab_presolve(ctx, i);
+		singleton = ctx->stats->presolve_singleton_rows;
+		sol = isl_tab_basic_set_non_trivial_lexmin(
+			isl_basic_set_copy(bset), 2, 1, &region,
+			&record_conflict, &data[i]);
+		if (!sol)
+			break;
+		isl_vec_free(sol);
+	}
+	isl_options_set_tab_presolve(ctx, presolve);
+	isl_basic_set_free(bset);
+	if (i < 2)
+		return -1;
+
+	if (ctx->stats->presolve_singleton_rows == singleton)
+		isl_die(ctx, isl_error_unknown, "no constraints removed",
+			return -1);
+	if (data[0].n == 0)
+		isl_die(ctx, isl_error_unknown, "no conflict reported",
+			return -1);
+	if (data[0].n != data[1].n)
+		isl_die(ctx, isl_error_unknown, "different conflicts reported",
+			return -1);
+	for (i = 0; i < data[0].n; ++i)
+		if (data[0].con[i] != data[1].con[i])
+			isl_die(ctx, isl_error_unknown,
+				"different conflicts reported", return -1);
+
+	return 0;
+}
+
+/* Check that a schedule computed with presolving is the same
+ * as the one computed without.
+ * The schedule constraints are those of test_coalescing_schedule.
+ * With schedule-treat-coalescing set, the computation reports
+ * conflicts from isl_tab_basic_set_non_trivial_lexmin and
+ * adds equalities through isl_tab_lexmin_add_eq on presolved sets.
+ */
+static int test_tab_presolve_schedule(isl_ctx *ctx)
+{
+	int i;
+	int presolve, treat_coalescing;
+	isl_bool equal;
+	const char *domain, *dep;
+	isl_union_map *sched[2];
+
+	domain = "{ S[a, b] : 0 <= a <= 1 and 0 <= b <= 1 }";
+	dep = "{ S[a, b] -> S[a + b, 1 - b] }";
+	presolve = isl_options_get_tab_presolve(ctx);
+	treat_coalescing = isl_options_get_schedule_treat_coalescing(ctx);
+	isl_options_set_schedule_treat_coalescing(ctx, 1);
+	for (i = 0; i < 2; ++i) {
+		isl_union_set *I;
+		isl_union_map *D;
+		isl_schedule_constraints *sc;
+		isl_schedule *schedule;
+
+		isl_options_set_tab_presolve(ctx, i);
+		I = isl_union_set_read_from_str(ctx, domain);
+		D = isl_union_map_read_from_str(ctx, dep);
+		sc = isl_schedule_constraints_on_domain(I);
+		sc = isl_schedule_constraints_set_validity(sc, D);
+		schedule = isl_schedule_constraints_compute_schedule(sc);
+		sched[i] = isl_schedule_get_map(schedule);
+		isl_schedule_free(schedule);
+	}
+	isl_options_set_schedule_treat_coalescing(ctx, treat_coalescing);
+	isl_options_set_tab_presolve(ctx, presolve);
+
+	equal = isl_union_map_is_equal(sched[0], sched[1]);
+	isl_union_map_free(sched[0]);
+	isl_union_map_free(sched[1]);
+	if (equal < 0)
 		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"presolving changes schedule", return -1);
 
 	return 0;
 }
 
+/* Check that presolving the integer linear programs of
+ * test_tab_presolve_min does not change the results and
+ * that fixed variables get eliminated.
+ * Also check that presolving does not change the results
+ * of lexicographic optimization, of conflict reporting or
+ * of a schedule computation.
+ */
+static int test_tab_presolve(isl_ctx *ctx)
+{
+	if (test_with_option(ctx, &isl_options_get_tab_presolve,
+		    &isl_options_set_tab_presolve, 1, &test_tab_presolve_min,
+		    &ctx->stats->presolve_fixed_vars,
+		    "no variable eliminated") < 0)
+		return -1;
+	if (test_tab_presolve_lexmin(ctx) < 0)
+		return -1;
+	if (test_tab_presolve_conflict(ctx) < 0)
+		return -1;
+	return test_tab_presolve_schedule(ctx);
+}
+
 struct must_may {
 	isl_map *must;
 	isl_map *may;
@@ -5098,6 +6010,135 @@ int test_sample(isl_ctx *ctx)
 	return 0;
 }
 
+/* A set for which a sample is computed, along with whether it is empty.
+ */
+struct sample_test {
+	const char *set;
+	int empty;
+};
+
+/* For each of the "n" sets in "tests", check that a sample can be computed
+ * exactly when the set is not empty and that it belongs to the set.
+ */
+static int test_sample_sets(isl_ctx *ctx, struct sample_test *tests, int n)
+{
+	int i;
+	isl_basic_set *bset, *sample;
+	isl_bool subset, empty;
+
+	for (i = 0; i < n; ++i) {
+		bset = isl_basic_set_read_from_str(ctx, tests[i].set);
+		sample = isl_basic_set_sample(isl_basic_set_copy(bset));
+		empty = isl_basic_set_plain_is_empty(sample);
+		subset = isl_basic_set_is_subset(sample, bset);
+		isl_basic_set_free(bset);
+		isl_basic_set_free(sample);
+		if (empty < 0 || subset < 0)
+			return -1;
+		if (empty != tests[i].empty)
+			isl_die(ctx, isl_error_unknown, "unexpected emptiness",
+				return -1);
+		if (!subset)
+			isl_die(ctx, isl_error_unknown, "bad point found",
+				return -1);
+	}
+
+	return 0;
+}
+
+/* A sequence of refined sets of increasing difficulty.
+ */
+static struct sample_test gbr_warm_start_tests[] = {
+	{ "{ [x, y, z] : 0 <= 7x - 5y + 3z <= 2 and 0 <= 3x + 2y - 4z <= 3 and "
+	    "0 <= x, y, z <= 30 }", 0 },
+	{ "{ [x, y, z] : 0 <= 7x - 5y + 3z <= 2 and 0 <= 3x + 2y - 4z <= 3 and "
+	    "0 <= x, y, z <= 30 and x + y + z >= 20 }", 0 },
+	{ "{ [x, y, z] : 0 <= 7x - 5y + 3z <= 2 and 0 <= 3x + 2y - 4z <= 3 and "
+	    "0 <= x, y, z <= 30 and x + y + z >= 30 }", 0 },
+};
+
+static int test_gbr_warm_start_sets(isl_ctx *ctx)
+{
+	return test_sample_sets(ctx, gbr_warm_start_tests,
+				ARRAY_SIZE(gbr_warm_start_tests));
+}
+
+/* Check that the samples of a sequence of refined sets
+ * are correct when the basis reduction is warm started
+ * from the basis of the previous sample and that
+ * this warm start actually happens.
+ */
+static int test_gbr_warm_start(isl_ctx *ctx)
+{
+	return test_with_option(ctx, &isl_options_get_gbr_warm_start,
+		&isl_options_set_gbr_warm_start, 1, &test_gbr_warm_start_sets,
+		&ctx->stats->gbr_warm_starts,
+		"no warm started basis reduction");
+}
+
+static struct sample_test sample_threads_tests[] = {
+	{ "{ [x, y, z] : 0 <= 7x - 5y + 3z <= 2 and 0 <= 3x + 2y - 4z <= 3 and "
+	    "0 <= x, y, z <= 30 and x + y + z >= 30 }", 0 },
+	{ "{ [x, y, z] : 0 <= 7x - 5y + 3z <= 2 and 0 <= 3x + 2y - 4z <= 3 and "
+	    "0 <= x, y, z <= 300 and x + y + z >= 300 }", 0 },
+	{ "{ [x, y, z] : 0 <= 7x - 5y + 3z <= 2 and 0 <= 3x + 2y - 4z <= 3 and "
+	    "0 <= x, y, z <= 30 and x + y + z >= 80 }", 1 },
+};
+
+static int test_sample_threads_sets(isl_ctx *ctx)
+{
+	return test_sample_sets(ctx, sample_threads_tests,
+				ARRAY_SIZE(sample_threads_tests));
+}
+
+/* Check that the samples computed by a parallel search are correct
+ * and, if isl was built with thread support,
+ * that a parallel search is actually performed.
+ */
+static int test_sample_threads(isl_ctx *ctx)
+{
+#ifdef HAVE_PTHREAD_H
+	return test_with_option(ctx, &isl_options_get_sample_threads,
+		&isl_options_set_sample_threads, 4, &test_sample_threads_sets,
+		&ctx->stats->sample_parallel_searches,
+		"no parallel search performed");
+#else
+	int r;
+	int threads;
+
+	threads = isl_options_get_sample_threads(ctx);
+	isl_options_set_sample_threads(ctx, 4);
+	r = test_sample_threads_sets(ctx);
+	isl_options_set_sample_threads(ctx, threads);
+
+	return r;
+#endif
+}
+
+static struct sample_test sample_cuts_tests[] = {
+	{ "{ [x, y, z] : 0 <= 7x - 5y + 3z <= 2 and 0 <= 3x + 2y - 4z <= 3 and "
+	    "0 <= x, y, z <= 30 and x + y + z >= 30 }", 0 },
+	{ "{ [x, y, z] : 2 <= 7x - 5y + 3z <= 3 and 1 <= 3x + 2y - 4z <= 2 and "
+	    "0 <= x, y, z <= 10 and x + y >= 15 }", 1 },
+};
+
+static int test_sample_cuts_sets(isl_ctx *ctx)
+{
+	return test_sample_sets(ctx, sample_cuts_tests,
+				ARRAY_SIZE(sample_cuts_tests));
+}
+
+/* Check that the samples computed after adding cuts are correct
+ * and that the cuts allow a branching search to be avoided.
+ */
+static int test_sample_cuts(isl_ctx *ctx)
+{
+	return test_with_option(ctx, &isl_options_get_sample_cut_rounds,
+		&isl_options_set_sample_cut_rounds, 10, &test_sample_cuts_sets,
+		&ctx->stats->sample_cut_searches_avoided,
+		"no search avoided by cuts");
+}
+
 int test_fixed_power(isl_ctx *ctx)
 {
 	const char *str;
@@ -6617,10 +7658,545 @@ static int test_universe(isl_ctx *ctx)
 	return 0;
 }
 
+/* Values used for constructing the rows in test_seq.
+ * They are chosen around the boundaries of the machine word
+ * representations of isl_int.
+ */
+static const char *seq_values[] = {
+	"0", "1", "-1", "7", "-12", "46341", "-46341",
+	"2147483647", "-2147483647", "2147483648", "-2147483648",
+	"9223372036854775807", "-9223372036854775808",
+	"12345678901234567890",
+};
+
+#define SEQ_LEN	ARRAY_SIZE(seq_values)
+
+/* Set row[i] to the value in seq_values at position (i + shift) modulo n,
+ * with n the number of values that should be used.
+ */
+static void seq_init_row(isl_int *row, int shift, int n)
+{
+	int i;
+
+	for (i = 0; i < SEQ_LEN; ++i)
+		isl_int_read(row[i], seq_values[(i + shift) % n]);
+}
+
+/* Check that "row" is equal to "expected" and complain if it is not.
+ */
+static int seq_check(isl_ctx *ctx, isl_int *row, isl_int *expected,
+	const char *op)
+{
+	if (isl_seq_eq(row, expected, SEQ_LEN))
+		return 0;
+	isl_die(ctx, isl_error_unknown, op, return -1);
+}
+
+/* Check the isl_seq row operations with factors "f1" and "f2"
+ * on rows "src1" and "src2" against the element-wise computation.
+ */
+static int test_seq_rows(isl_ctx *ctx, isl_int f1, isl_int *src1,
+	isl_int f2, isl_int *src2)
+{
+	int i;
+	isl_int dst[SEQ_LEN], exp[SEQ_LEN];
+	isl_int g;
+	int r = 0;
+
+	isl_int_init(g);
+	for (i = 0; i < SEQ_LEN; ++i) {
+		isl_int_init(dst[i]);
+		isl_int_init(exp[i]);
+	}
+
+	isl_seq_cpy(dst, src1, SEQ_LEN);
+	isl_seq_combine(dst, f1, dst, f2, src2, SEQ_LEN);
+	for (i = 0; i < SEQ_LEN; ++i) {
+		isl_int_mul(exp[i], f1, src1[i]);
+		isl_int_addmul(exp[i], f2, src2[i]);
+	}
+	if (seq_check(ctx, dst, exp, "isl_seq_combine") < 0)
+		r = -1;
+
+	isl_seq_cpy(dst, src1, SEQ_LEN);
+	isl_seq_submul(dst, f1, src2, SEQ_LEN);
+	for (i = 0; i < SEQ_LEN; ++i) {
+		isl_int_set(exp[i], src1[i]);
+		isl_int_submul(exp[i], f1, src2[i]);
+	}
+	if (seq_check(ctx, dst, exp, "isl_seq_submul") < 0)
+		r = -1;
+
+	isl_seq_scale(dst, src1, f2, SEQ_LEN);
+	for (i = 0; i < SEQ_LEN; ++i)
+		isl_int_mul(exp[i], src1[i], f2);
+	if (seq_check(ctx, dst, exp, "isl_seq_scale") < 0)
+		r = -1;
+
+	if (!isl_int_is_zero(f2)) {
+		isl_seq_scale_down(dst, exp, f2, SEQ_LEN);
+		if (seq_check(ctx, dst, src1, "isl_seq_scale_down") < 0)
+			r = -1;
+	}
+
+	isl_seq_gcd(exp, SEQ_LEN, &g);
+	isl_int_set_si(exp[0], 0);
+	for (i = 0; i < SEQ_LEN; ++i)
+		isl_int_gcd(exp[0], exp[0], exp[i]);
+	if (isl_int_ne(g, exp[0]))
+		isl_die(ctx, isl_error_unknown, "isl_seq_gcd", r = -1);
+
+	isl_int_clear(g);
+	for (i = 0; i < SEQ_LEN; ++i) {
+		isl_int_clear(dst[i]);
+		isl_int_clear(exp[i]);
+	}
+
+	return r;
+}
+
+/* Check that the isl_seq row operations produce the same results
+ * as the corresponding element-wise isl_int operations,
+ * both on rows that only contain values that fit in 32 bits and
+ * on rows that also contain larger values.
+ */
+static int test_seq(isl_ctx *ctx)
+{
+	int i, j, n;
+	isl_int src1[SEQ_LEN], src2[SEQ_LEN];
+	int r = 0;
+
+	for (i = 0; i < SEQ_LEN; ++i) {
+		isl_int_init(src1[i]);
+		isl_int_init(src2[i]);
+	}
+
+	for (n = 9; r >= 0 && n <= SEQ_LEN; n += SEQ_LEN - 9) {
+		seq_init_row(src1, 0, n);
+		seq_init_row(src2, 3, n);
+		for (i = 0; r >= 0 && i < SEQ_LEN; ++i)
+			for (j = 0; r >= 0 && j < SEQ_LEN; ++j)
+				r = test_seq_rows(ctx, src1[i], src1,
+						src2[j], src2);
+	}
+
+	for (i = 0; i < SEQ_LEN; ++i) {
+		isl_int_clear(src1[i]);
+		isl_int_clear(src2[i]);
+	}
+
+	return r;
+}
+
+/* Check that the number of block cache hits and misses
+ * of "ctx" is equal to "hits" and "misses".
+ */
+static int check_block_cache_stats(isl_ctx *ctx, unsigned long hits,
+	unsigned long misses)
+{
+	if (isl_ctx_get_block_cache_hits(ctx) != hits)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of block cache hits", return -1);
+	if (isl_ctx_get_block_cache_misses(ctx) != misses)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of block cache misses", return -1);
+	return 0;
+}
+
+/* Check that freed blocks are reused for allocations of blocks
+ * of a similar size, that the maximal size of the block cache is
+ * respected and that the hits and misses are counted correctly.
+ */
+static int test_block_cache(isl_ctx *ctx)
+{
+	int r = 0;
+	unsigned long max;
+	struct isl_blk b1, b2;
+
+	max = isl_ctx_get_max_block_cache_size(ctx);
+	isl_ctx_clear_block_cache(ctx);
+	isl_ctx_set_max_block_cache_size(ctx, 1000);
+	isl_ctx_reset_block_cache_stats(ctx);
+
+	b1 = isl_blk_alloc(ctx, 10);
+	isl_blk_free(ctx, b1);
+	b1 = isl_blk_alloc(ctx, 12);
+	b2 = isl_blk_alloc(ctx, 100);
+	if (isl_blk_is_error(b1) || isl_blk_is_error(b2) || b1.size != 12)
+		r = -1;
+	if (r >= 0)
+		r = check_block_cache_stats(ctx, 1, 2);
+	isl_blk_free(ctx, b1);
+	isl_blk_free(ctx, b2);
+
+	isl_ctx_set_max_block_cache_size(ctx, 50);
+	b2 = isl_blk_alloc(ctx, 100);
+	b1 = isl_blk_alloc(ctx, 12);
+	if (r >= 0)
+		r = check_block_cache_stats(ctx, 2, 3);
+	isl_blk_free(ctx, b1);
+	isl_blk_free(ctx, b2);
+
+	isl_ctx_set_max_block_cache_size(ctx, 0);
+	b1 = isl_blk_alloc(ctx, 12);
+	if (r >= 0)
+		r = check_block_cache_stats(ctx, 2, 4);
+	isl_blk_free(ctx, b1);
+
+	isl_ctx_set_max_block_cache_size(ctx, max);
+
+	return r;
+}
+
+/* Check that the number of basic map cache hits of "ctx"
+ * is greater than "hits" if "more" is set and equal to "hits" otherwise and
+ * that the number of basic map cache misses is equal to "misses".
+ */
+static int check_basic_map_cache_stats(isl_ctx *ctx, unsigned long hits,
+	int more, unsigned long misses)
+{
+	unsigned long n_hit = isl_ctx_get_basic_map_cache_hits(ctx);
+
+	if (more ? n_hit <= hits : n_hit != hits)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of basic map cache hits", return -1);
+	if (isl_ctx_get_basic_map_cache_misses(ctx) != misses)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected number of basic map cache misses",
+			return -1);
+	return 0;
+}
+
+/* Is the basic set described by "str" empty?
+ * Since the basic set is constructed from scratch,
+ * no information about its emptiness is available yet.
+ */
+static isl_bool basic_set_str_is_empty(isl_ctx *ctx, const char *str)
+{
+	isl_basic_set *bset;
+	isl_bool empty;
+
+	bset = isl_basic_set_read_from_str(ctx, str);
+	empty = isl_basic_set_is_empty(bset);
+	isl_basic_set_free(bset);
+
+	return empty;
+}
+
+/* Check that repeated emptiness and subset tests on basic sets
+ * are answered from the basic map cache, independently of the order
+ * of the constraints, that the results are not affected
+ * and that the hits and misses are counted correctly.
+ */
+static int test_basic_map_cache(isl_ctx *ctx)
+{
+	int i;
+	int r = 0;
+	unsigned long max, hits;
+	const char *str1 = "{ [x, y] : 0 <= x <= 10 and x <= y <= 2x }";
+	const char *str2 = "{ [x, y] : x <= y <= 2x and 0 <= x <= 10 }";
+	const char *str3 = "{ [x, y] : 0 <= x <= 10 and 0 <= y <= 20 }";
+	isl_basic_set *bset1, *bset3;
+	isl_bool empty, subset;
+
+	max = isl_ctx_get_max_basic_map_cache_size(ctx);
+	isl_ctx_clear_basic_map_cache(ctx);
+	isl_ctx_set_max_basic_map_cache_size(ctx, 10);
+	isl_ctx_reset_basic_map_cache_stats(ctx);
+
+	for (i = 0; r >= 0 && i < 3; ++i) {
+		hits = isl_ctx_get_basic_map_cache_hits(ctx);
+		empty = basic_set_str_is_empty(ctx, i < 2 ? str1 : str2);
+		if (empty < 0)
+			r = -1;
+		else if (empty)
+			isl_die(ctx, isl_error_unknown, "unexpected result",
+				r = -1);
+		else
+			r = check_basic_map_cache_stats(ctx, hits, i > 0, 1);
+	}
+
+	bset1 = isl_basic_set_read_from_str(ctx, str1);
+	bset3 = isl_basic_set_read_from_str(ctx, str3);
+	for (i = 0; r >= 0 && i < 2; ++i) {
+		hits = isl_ctx_get_basic_map_cache_hits(ctx);
+		subset = isl_basic_set_is_subset(bset1, bset3);
+		if (subset < 0)
+			r = -1;
+		else if (!subset)
+			isl_die(ctx, isl_error_unknown, "unexpected result",
+				r = -1);
+		subset = isl_basic_set_is_subset(bset3, bset1);
+		if (r >= 0 && subset < 0)
+			r = -1;
+		else if (r >= 0 && subset)
+			isl_die(ctx, isl_error_unknown, "unexpected result",
+				r = -1);
+		if (r >= 0 && i == 1 &&
+		    isl_ctx_get_basic_map_cache_hits(ctx) != hits + 2)
+			isl_die(ctx, isl_error_unknown,
+				"expecting subset tests to be cached", r = -1);
+	}
+	isl_basic_set_free(bset1);
+	isl_basic_set_free(bset3);
+
+	isl_ctx_set_max_basic_map_cache_size(ctx, 0);
+	isl_ctx_reset_basic_map_cache_stats(ctx);
+	empty = basic_set_str_is_empty(ctx, str1);
+	if (r >= 0 && empty < 0)
+		r = -1;
+	if (r >= 0)
+		r = check_basic_map_cache_stats(ctx, 0, 0, 0);
+
+	isl_ctx_set_max_basic_map_cache_size(ctx, max);
+
+	return r;
+}
+
+/* Check that a freed isl_val with a small value is reused
+ * by the next allocation and that a freed isl_val with a large value
+ * is not kept around.
+ */
+static int test_val_cache(isl_ctx *ctx)
+{
+	int r = 0;
+	int n;
+	isl_val *v, *w;
+
+	v = isl_val_int_from_si(ctx, 5);
+	if (!v)
+		return -1;
+	w = v;
+	isl_val_free(v);
+	v = isl_val_int_from_si(ctx, -7);
+	if (!v)
+		return -1;
+	if (v != w)
+		isl_die(ctx, isl_error_unknown,
+			"freed isl_val not reused", r = -1);
+	if (r >= 0 && isl_val_get_num_si(v) != -7)
+		isl_die(ctx, isl_error_unknown,
+			"reused isl_val has wrong value", r = -1);
+	isl_val_free(v);
+
+	v = isl_val_read_from_str(ctx, "1267650600228229401496703205376/3");
+	if (!v)
+		return -1;
+	n = ctx->n_val_cache;
+	isl_val_free(v);
+	if (r >= 0 && ctx->n_val_cache != n)
+		isl_die(ctx, isl_error_unknown,
+			"large isl_val kept for reuse", r = -1);
+
+	return r;
+}
+
+/* Check that an isl_ctx allocated for a worker thread
+ * inherits the options, the operation quota and the number
+ * of operations of "ctx" and that its operations and statistics
+ * are added to those of "ctx" when it is merged back.
+ */
+static int test_ctx_worker(isl_ctx *ctx)
+{
+	int r = 0;
+	int pricing, cut_rounds;
+	unsigned long max_operations, operations;
+	long pivots;
+	isl_ctx *worker;
+	isl_basic_set *bset;
+	isl_bool empty;
+
+	pricing = isl_options_get_tab_pricing(ctx);
+	cut_rounds = isl_options_get_sample_cut_rounds(ctx);
+	max_operations = isl_ctx_get_max_operations(ctx);
+	isl_options_set_tab_pricing(ctx, ISL_TAB_PRICING_STEEPEST_EDGE);
+	isl_options_set_sample_cut_rounds(ctx, cut_rounds + 3);
+	isl_ctx_set_max_operations(ctx, ctx->operations + 100000);
+
+	worker = isl_ctx_alloc_worker(ctx);
+	if (!worker)
+		r = -1;
+	if (r >= 0 &&
+	    (isl_options_get_tab_pricing(worker) !=
+		ISL_TAB_PRICING_STEEPEST_EDGE ||
+	     isl_options_get_sample_cut_rounds(worker) != cut_rounds + 3 ||
+	     isl_options_get_on_error(worker) !=
+		isl_options_get_on_error(ctx) ||
+	     isl_ctx_get_max_operations(worker) !=
+		isl_ctx_get_max_operations(ctx) ||
+	     worker->operations != ctx->operations))
+		isl_die(ctx, isl_error_unknown,
+			"options not inherited by worker", r = -1);
+
+	if (r >= 0) {
+		bset = isl_basic_set_read_from_str(worker,
+			"{ [x, y] : 0 <= 7x - 5y <= 2 and 0 <= x, y <= 100 and "
+			"x + y >= 50 }");
+		empty = isl_basic_set_is_empty(bset);
+		isl_basic_set_free(bset);
+		if (empty < 0)
+			r = -1;
+	}
+	if (r >= 0 && (worker->operations == ctx->operations ||
+		       worker->stats->tab_pivots == 0))
+		isl_die(ctx, isl_error_unknown,
+			"no work performed by worker", r = -1);
+	if (r >= 0) {
+		operations = worker->operations;
+		pivots = ctx->stats->tab_pivots + worker->stats->tab_pivots;
+		isl_ctx_merge_worker(ctx, worker);
+		if (ctx->operations != operations ||
+		    ctx->stats->tab_pivots != pivots ||
+		    worker->stats->tab_pivots != 0)
+			isl_die(ctx, isl_error_unknown,
+				"worker results not merged", r = -1);
+	}
+	if (worker)
+		isl_ctx_free(worker);
+
+	isl_ctx_set_max_operations(ctx, max_operations);
+	isl_options_set_sample_cut_rounds(ctx, cut_rounds);
+	isl_options_set_tab_pricing(ctx, pricing);
+
+	return r;
+}
+
+#define N_NESTED_SCRATCH	(ISL_CTX_N_SCRATCH + 4)
+
+/* Acquire more single scratch integers than fit on the stack
+ * of "ctx", one at a time, and release them in reverse order,
+ * checking that they keep their values and that the stack
+ * is empty again at the end.
+ */
+static int test_scratch_nested(isl_ctx *ctx)
+{
+	int i, n;
+	int r = 0;
+	isl_int *v[N_NESTED_SCRATCH];
+
+	for (n = 0; n < N_NESTED_SCRATCH; ++n) {
+		v[n] = isl_ctx_scratch_acquire(ctx, 1);
+		if (!v[n])
+			break;
+		isl_int_set_si(v[n][0], n);
+	}
+	if (n < N_NESTED_SCRATCH)
+		r = -1;
+	for (i = 0; r >= 0 && i < n; ++i)
+		if (isl_int_cmp_si(v[i][0], i) != 0)
+			isl_die(ctx, isl_error_unknown,
+				"scratch integer overwritten", r = -1);
+	if (r >= 0 && ctx->n_scratch != ISL_CTX_N_SCRATCH)
+		isl_die(ctx, isl_error_unknown,
+			"stack not filled", r = -1);
+	while (n-- > 0)
+		isl_ctx_scratch_release(ctx, v[n], 1);
+	if (r >= 0 && ctx->n_scratch != 0)
+		isl_die(ctx, isl_error_unknown,
+			"scratch integers not returned", r = -1);
+
+	return r;
+}
+
+/* Check that releasing scratch integers from the stack of "ctx"
+ * in the wrong order is reported as an error and
+ * does not affect the stack.
+ */
+static int test_scratch_out_of_order(isl_ctx *ctx)
+{
+	int r = 0;
+	int on_error;
+	isl_int *a, *b;
+
+	a = isl_ctx_scratch_acquire(ctx, 1);
+	b = isl_ctx_scratch_acquire(ctx, 1);
+	if (!a || !b)
+		r = -1;
+	if (r >= 0) {
+		on_error = isl_options_get_on_error(ctx);
+		isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+		isl_ctx_reset_error(ctx);
+		isl_ctx_scratch_release(ctx, a, 1);
+		isl_options_set_on_error(ctx, on_error);
+		if (isl_ctx_last_error(ctx) != isl_error_internal)
+			isl_die(ctx, isl_error_unknown,
+				"out of order release not detected", r = -1);
+		isl_ctx_reset_error(ctx);
+	}
+	if (r >= 0 && ctx->n_scratch != 2)
+		isl_die(ctx, isl_error_unknown,
+			"out of order release affects stack", r = -1);
+	if (b)
+		isl_ctx_scratch_release(ctx, b, 1);
+	if (a)
+		isl_ctx_scratch_release(ctx, a, 1);
+	if (r >= 0 && ctx->n_scratch != 0)
+		isl_die(ctx, isl_error_unknown,
+			"scratch integers not returned", r = -1);
+
+	return r;
+}
+
+/* Check that scratch integers are handed out from the stack
+ * in the context in LIFO order and that requests that do not fit
+ * are served from the heap without disturbing the stack.
+ */
+static int test_scratch(isl_ctx *ctx)
+{
+	int r = 0;
+	isl_int *a, *b, *c;
+
+	a = isl_ctx_scratch_acquire(ctx, 2);
+	b = isl_ctx_scratch_acquire(ctx, 3);
+	c = isl_ctx_scratch_acquire(ctx, ISL_CTX_N_SCRATCH);
+	if (!a || !b || !c)
+		r = -1;
+	if (r >= 0 && (a != ctx->scratch || b != a + 2))
+		isl_die(ctx, isl_error_unknown,
+			"scratch integers not taken from stack", r = -1);
+	if (r >= 0 && c >= ctx->scratch &&
+	    c < ctx->scratch + ISL_CTX_N_SCRATCH)
+		isl_die(ctx, isl_error_unknown,
+			"stack overflow not served from heap", r = -1);
+	if (r >= 0) {
+		isl_int_set_si(c[ISL_CTX_N_SCRATCH - 1], 7);
+		isl_int_set_si(b[2], -3);
+		isl_int_mul(a[1], b[2], c[ISL_CTX_N_SCRATCH - 1]);
+		if (isl_int_cmp_si(a[1], -21) != 0)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected result", r = -1);
+	}
+	if (c)
+		isl_ctx_scratch_release(ctx, c, ISL_CTX_N_SCRATCH);
+	if (r >= 0 && ctx->n_scratch != 5)
+		isl_die(ctx, isl_error_unknown,
+			"heap release affects stack", r = -1);
+	if (b)
+		isl_ctx_scratch_release(ctx, b, 3);
+	if (a)
+		isl_ctx_scratch_release(ctx, a, 2);
+	if (r >= 0 && ctx->n_scratch != 0)
+		isl_die(ctx, isl_error_unknown,
+			"scratch integers not returned", r = -1);
+
+	if (r >= 0)
+		r = test_scratch_nested(ctx);
+	if (r >= 0)
+		r = test_scratch_out_of_order(ctx);
+
+	return r;
+}
+
 struct {
 	const char *name;
 	int (*fn)(isl_ctx *ctx);
 } tests [] = {
+	{ "block cache", &test_block_cache },
+	{ "basic map cache", &test_basic_map_cache },
+	{ "scratch integers", &test_scratch },
+	{ "isl_val cache", &test_val_cache },
+	{ "worker contexts", &test_ctx_worker },
+	{ "seq", &test_seq },
 	{ "universe", &test_universe },
 	{ "domain hash", &test_domain_hash },
 	{ "dual", &test_dual },
@@ -6646,6 +8222,9 @@ struct {
 	{ "slice", &test_slice },
 	{ "fixed power", &test_fixed_power },
 	{ "sample", &test_sample },
+	{ "basis reduction warm start", &test_gbr_warm_start },
+	{ "parallel sample", &test_sample_threads },
+	{ "sample cuts", &test_sample_cuts },
 	{ "output", &test_output },
 	{ "vertices", &test_vertices },
 	{ "fixed", &test_fixed },
@@ -6671,7 +8250,17 @@ struct {
 	{ "subtract", &test_subtract },
 	{ "intersect", &test_intersect },
 	{ "lexmin", &test_lexmin },
+	{ "parallel lexmin", &test_pip_threads },
+	{ "lexmin split heuristics", &test_pip_split },
+	{ "lexmin symmetry detection", &test_pip_symmetry },
+	{ "foreach lexmin", &test_foreach_lexmin },
+	{ "shared lexmin contexts", &test_shared_contexts },
+	{ "tableau pricing", &test_tab_pricing },
+	{ "tableau floating point filter", &test_tab_float_filter },
+	{ "tableau presolve", &test_tab_presolve },
+	{ "sparse tableau pivots", &test_tab_sparse_pivot },
 	{ "min", &test_min },
+	{ "min multi", &test_min_multi },
 	{ "gist", &test_gist },
 	{ "piecewise quasi-polynomials", &test_pwqp },
 	{ "lift", &test_lift },
@@ -57,6 +57,14 @@ struct {
 	{ &int_test_hash, "-2147483647" },
 	{ &int_test_hash, "2147483648" },
 	{ &int_test_hash, "-2147483648" },
+	{ &int_test_hash, "4611686018427387903" },
+	{ &int_test_hash, "-4611686018427387903" },
+	{ &int_test_hash, "4611686018427387904" },
+	{ &int_test_hash, "-4611686018427387904" },
+	{ &int_test_hash, "9223372036854775807" },
+	{ &int_test_hash, "-9223372036854775808" },
+	{ &int_test_hash, "9223372036854775808" },
+	{ &int_test_hash, "-18446744073709551616" },
 };
 
 static void int_test_single_value()
@@ -291,8 +299,28 @@ static void int_test_mul(isl_int expected, isl_int lhs, isl_int rhs)
 	isl_int_clear(result);
 }
 
+/* Check that adding factor1 * factor2 to the negation of product
+ * results in zero and that subtracting it from zero results
+ * in the negation of product.
+ */
+static void int_test_addmul(isl_int product, isl_int factor1, isl_int factor2)
+{
+	isl_int result;
+	isl_int_init(result);
+
+	isl_int_neg(result, product);
+	isl_int_addmul(result, factor1, factor2);
+	assert(isl_int_is_zero(result));
+
+	isl_int_submul(result, factor1, factor2);
+	isl_int_add(result, result, product);
+	assert(isl_int_is_zero(result));
+
+	isl_int_clear(result);
+}
+
 /* Use a triple that satisfies 'product = factor1 * factor2' to check the
- * operations mul, divexact, tdiv, fdiv and cdiv.
+ * operations mul, addmul, submul, divexact, tdiv, fdiv and cdiv.
  */
 static void int_test_product(isl_int product, isl_int factor1, isl_int factor2)
 {
@@ -301,6 +329,9 @@ static void int_test_product(isl_int product, isl_int factor1, isl_int factor2)
 
 	int_test_mul(product, factor1, factor2);
 	int_test_mul(product, factor2, factor1);
+
+	int_test_addmul(product, factor1, factor2);
+	int_test_addmul(product, factor2, factor1);
 }
 
 static void int_test_add(isl_int expected, isl_int lhs, isl_int rhs)
@@ -482,6 +513,18 @@ struct {
 	{ &int_test_sum, "2147483648", "2147483647", "1" },
 	{ &int_test_sum, "-2147483648", "-2147483647", "-1" },
 
+	{ &int_test_sum, "4611686018427387903",
+	  "2305843009213693951", "2305843009213693952" },
+	{ &int_test_sum, "-4611686018427387904",
+	  "-2305843009213693952", "-2305843009213693952" },
+
+	{ &int_test_sum, "4611686018427387904", "4611686018427387903", "1" },
+	{ &int_test_sum, "-4611686018427387904", "-4611686018427387903", "-1" },
+	{ &int_test_sum, "9223372036854775806",
+	  "4611686018427387903", "4611686018427387903" },
+	{ &int_test_sum, "-9223372036854775806",
+	  "-4611686018427387903", "-4611686018427387903" },
+
 	{ &int_test_product, "0", "0", "0" },
 	{ &int_test_product, "0", "0", "1" },
 	{ &int_test_product, "1", "1", "1" },
@@ -508,6 +551,22 @@ struct {
 	{ &int_test_product,
 	  "4611686016279904256", "-2147483647", "-2147483648" },
 
+	{ &int_test_product,
+	  "4611686018427387904", "2147483648", "2147483648" },
+	{ &int_test_product,
+	  "-4611686018427387904", "-2147483648", "2147483648" },
+	{ &int_test_product,
+	  "4611686018427387903", "1", "4611686018427387903" },
+	{ &int_test_product,
+	  "-4611686018427387903", "-1", "4611686018427387903" },
+	{ &int_test_product, "9223372036854775806", "2", "4611686018427387903" },
+	{ &int_test_product,
+	  "21267647932558653957237540927630737409",
+	  "4611686018427387903", "4611686018427387903" },
+	{ &int_test_product,
+	  "-21267647932558653957237540927630737409",
+	  "-4611686018427387903", "4611686018427387903" },
+
 	{ &int_test_product, "85070591730234615847396907784232501249",
 	  "9223372036854775807", "9223372036854775807" },
 	{ &int_test_product, "-85070591730234615847396907784232501249",
@@ -575,6 +634,13 @@ struct {
 	{ &int_test_lcm, "55340232221128654842", "6", "9223372036854775807" },
 	{ &int_test_gcd, "2", "6", "-9223372036854775808" },
 	{ &int_test_lcm, "27670116110564327424", "6", "-9223372036854775808" },
+	{ &int_test_gcd, "4611686018427387903",
+	  "4611686018427387903", "-4611686018427387903" },
+	{ &int_test_lcm, "4611686018427387903",
+	  "4611686018427387903", "-4611686018427387903" },
+	{ &int_test_gcd, "1", "4611686018427387902", "4611686018427387903" },
+	{ &int_test_lcm, "21267647932558653952625854909203349506",
+	  "4611686018427387902", "4611686018427387903" },
 	{ &int_test_gcd, "1", "18446744073709551616", "18446744073709551615" },
 	{ &int_test_lcm, "340282366920938463444927863358058659840",
 	  "18446744073709551616", "18446744073709551615" },
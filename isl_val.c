@@ -7,6 +7,7 @@
  * Ecole Normale Superieure, 45 rue d'Ulm, 75230 Paris, France
  */
 
+#include <limits.h>
 #include <isl_int.h>
 #include <isl_ctx_private.h>
 #include <isl_val_private.h>
@@ -17,24 +18,50 @@
 #include <isl_list_templ.c>
 
 /* Allocate an isl_val object with indeterminate value.
+ *
+ * If "ctx" keeps any previously freed isl_val objects,
+ * then the most recently freed one is reused.
+ * Its numerator and denominator are still initialized and,
+ * in case of GMP, still have their memory, so that no allocation
+ * is needed at all.
+ * Otherwise, the object is allocated and its fields are initialized,
+ * which requires three allocations in case of GMP.
  */
 __isl_give isl_val *isl_val_alloc(isl_ctx *ctx)
 {
 	isl_val *v;
 
-	v = isl_alloc_type(ctx, struct isl_val);
-	if (!v)
-		return NULL;
+	if (ctx && ctx->n_val_cache > 0) {
+		v = ctx->val_cache[--ctx->n_val_cache];
+	} else {
+		v = isl_alloc_type(ctx, struct isl_val);
+		if (!v)
+			return NULL;
+		isl_int_init(v->n);
+		isl_int_init(v->d);
+	}
 
 	v->ctx = ctx;
 	isl_ctx_ref(ctx);
 	v->ref = 1;
-	isl_int_init(v->n);
-	isl_int_init(v->d);
 
 	return v;
 }
 
+/* Free the isl_val objects that are kept in "ctx" for reuse.
+ */
+void isl_val_clear_cache(isl_ctx *ctx)
+{
+	isl_val *v;
+
+	while (ctx->n_val_cache > 0) {
+		v = ctx->val_cache[--ctx->n_val_cache];
+		isl_int_clear(v->n);
+		isl_int_clear(v->d);
+		free(v);
+	}
+}
+
 /* Return a reference to an isl_val representing zero.
  */
 __isl_give isl_val *isl_val_zero(isl_ctx *ctx)
@@ -258,16 +285,29 @@ __isl_give isl_val *isl_val_cow(__isl_take isl_val *val)
 }
 
 /* Free "v" and return NULL.
+ *
+ * If "v" has small numerator and denominator and if there is room,
+ * then "v" is kept in its isl_ctx for reuse by isl_val_alloc.
+ * Values with large numerator or denominator are not kept
+ * since they may hold on to large amounts of memory.
  */
 __isl_null isl_val *isl_val_free(__isl_take isl_val *v)
 {
+	isl_ctx *ctx;
+
 	if (!v)
 		return NULL;
 
 	if (--v->ref > 0)
 		return NULL;
 
-	isl_ctx_deref(v->ctx);
+	ctx = v->ctx;
+	isl_ctx_deref(ctx);
+	if (ctx->n_val_cache < ISL_CTX_N_VAL_CACHE &&
+	    isl_int_fits_slong(v->n) && isl_int_fits_slong(v->d)) {
+		ctx->val_cache[ctx->n_val_cache++] = v;
+		return NULL;
+	}
 	isl_int_clear(v->n);
 	isl_int_clear(v->d);
 	free(v);
@@ -613,6 +653,146 @@ error:
 	return NULL;
 }
 
+/* Values with an absolute value smaller than SMALL_BOUND are small
+ * enough for the sum of two products of such values to fit in a long.
+ */
+#define SMALL_BOUND	((long) 1 << (sizeof(long) * CHAR_BIT / 2 - 1))
+
+/* Is "i" small enough to be handled by the long arithmetic
+ * in add_rat_small and mul_rat_small?
+ */
+static int is_small(isl_int i)
+{
+	long v;
+
+	if (!isl_int_fits_slong(i))
+		return 0;
+	v = isl_int_get_si(i);
+	return v > -SMALL_BOUND && v < SMALL_BOUND;
+}
+
+/* Return the greatest common divisor of the non-negative "a" and "b".
+ */
+static long gcd_si(long a, long b)
+{
+	while (b != 0) {
+		long t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/* Set "v" to the normalized value of n/d, where d is non-zero.
+ */
+static __isl_give isl_val *set_rat_si(__isl_take isl_val *v, long n, long d)
+{
+	long g;
+
+	if (d < 0) {
+		n = -n;
+		d = -d;
+	}
+	g = gcd_si(n < 0 ? -n : n, d);
+	if (g > 1) {
+		n /= g;
+		d /= g;
+	}
+	isl_int_set_si(v->n, n);
+	isl_int_set_si(v->d, d);
+
+	return v;
+}
+
+/* Replace the rational value "v" by the sum (sgn > 0) or difference
+ * (sgn < 0) of "v" and the rational value "v2", where the numerators
+ * and denominators of "v" and "v2" are all small.
+ * The intermediate results then fit in a long.
+ */
+static __isl_give isl_val *add_rat_small(__isl_take isl_val *v,
+	__isl_keep isl_val *v2, int sgn)
+{
+	long n1, d1, n2, d2;
+
+	n1 = isl_int_get_si(v->n);
+	d1 = isl_int_get_si(v->d);
+	n2 = isl_int_get_si(v2->n);
+	d2 = isl_int_get_si(v2->d);
+	if (sgn > 0)
+		return set_rat_si(v, n1 * d2 + n2 * d1, d1 * d2);
+	else
+		return set_rat_si(v, n1 * d2 - n2 * d1, d1 * d2);
+}
+
+/* Replace the rational value "v" by the sum (sgn > 0) or difference
+ * (sgn < 0) of "v" and the rational value "v2", where "v" and "v2"
+ * are normalized and have different denominators.
+ *
+ * Let g be the greatest common divisor of the denominators d_1 and d_2.
+ * If g is one, then
+ *
+ *	n_1 d_2 +/- n_2 d_1
+ *	-------------------
+ *	      d_1 d_2
+ *
+ * is already normalized.  Otherwise, let t = n_1 (d_2/g) +/- n_2 (d_1/g) and
+ * let g' be the greatest common divisor of t and g.  The normalized result
+ * is then
+ *
+ *	       t/g'
+ *	-----------------
+ *	(d_1/g) (d_2/g')
+ *
+ * This avoids computing the greatest common divisor of the (potentially)
+ * much larger unreduced numerator and denominator and keeps
+ * the intermediate results small.
+ * Since the denominators are different, the result cannot be zero.
+ *
+ * If all numerators and denominators are small, then the computation
+ * is performed directly on longs instead.  Otherwise, or in case
+ * of potential overflow, the general isl_int arithmetic is used.
+ */
+static __isl_give isl_val *add_rat(__isl_take isl_val *v,
+	__isl_keep isl_val *v2, int sgn)
+{
+	isl_int g, t;
+
+	if (is_small(v->n) && is_small(v->d) &&
+	    is_small(v2->n) && is_small(v2->d))
+		return add_rat_small(v, v2, sgn);
+
+	isl_int_init(g);
+	isl_int_init(t);
+	isl_int_gcd(g, v->d, v2->d);
+	if (isl_int_is_one(g)) {
+		isl_int_mul(v->n, v->n, v2->d);
+		if (sgn > 0)
+			isl_int_addmul(v->n, v2->n, v->d);
+		else
+			isl_int_submul(v->n, v2->n, v->d);
+		isl_int_mul(v->d, v->d, v2->d);
+	} else {
+		isl_int_divexact(v->d, v->d, g);
+		isl_int_divexact(t, v2->d, g);
+		isl_int_mul(v->n, v->n, t);
+		if (sgn > 0)
+			isl_int_addmul(v->n, v2->n, v->d);
+		else
+			isl_int_submul(v->n, v2->n, v->d);
+		isl_int_gcd(g, v->n, g);
+		if (!isl_int_is_one(g)) {
+			isl_int_divexact(v->n, v->n, g);
+			isl_int_divexact(t, v2->d, g);
+		} else
+			isl_int_set(t, v2->d);
+		isl_int_mul(v->d, v->d, t);
+	}
+	isl_int_clear(t);
+	isl_int_clear(g);
+
+	return v;
+}
+
 /* Return the sum of "v1" and "v2".
  */
 __isl_give isl_val *isl_val_add(__isl_take isl_val *v1, __isl_take isl_val *v2)
@@ -655,14 +835,11 @@ __isl_give isl_val *isl_val_add(__isl_take isl_val *v1, __isl_take isl_val *v2)
 	if (isl_val_is_int(v1) && isl_val_is_int(v2))
 		isl_int_add(v1->n, v1->n, v2->n);
 	else {
-		if (isl_int_eq(v1->d, v2->d))
+		if (isl_int_eq(v1->d, v2->d)) {
 			isl_int_add(v1->n, v1->n, v2->n);
-		else {
-			isl_int_mul(v1->n, v1->n, v2->d);
-			isl_int_addmul(v1->n, v2->n, v1->d);
-			isl_int_mul(v1->d, v1->d, v2->d);
-		}
-		v1 = isl_val_normalize(v1);
+			v1 = isl_val_normalize(v1);
+		} else
+			v1 = add_rat(v1, v2, 1);
 	}
 	isl_val_free(v2);
 	return v1;
@@ -733,14 +910,11 @@ __isl_give isl_val *isl_val_sub(__isl_take isl_val *v1, __isl_take isl_val *v2)
 	if (isl_val_is_int(v1) && isl_val_is_int(v2))
 		isl_int_sub(v1->n, v1->n, v2->n);
 	else {
-		if (isl_int_eq(v1->d, v2->d))
+		if (isl_int_eq(v1->d, v2->d)) {
 			isl_int_sub(v1->n, v1->n, v2->n);
-		else {
-			isl_int_mul(v1->n, v1->n, v2->d);
-			isl_int_submul(v1->n, v2->n, v1->d);
-			isl_int_mul(v1->d, v1->d, v2->d);
-		}
-		v1 = isl_val_normalize(v1);
+			v1 = isl_val_normalize(v1);
+		} else
+			v1 = add_rat(v1, v2, -1);
 	}
 	isl_val_free(v2);
 	return v1;
@@ -769,6 +943,48 @@ __isl_give isl_val *isl_val_sub_ui(__isl_take isl_val *v1, unsigned long v2)
 	return v1;
 }
 
+/* Replace the non-zero rational value "v" by its product
+ * with the non-zero rational value n/d, where "v" is normalized and
+ * n and d do not have any common factor, but d may be negative.
+ *
+ * Any common factor of the numerator of one factor and the denominator
+ * of the other factor is removed before the multiplication,
+ * such that the result is normalized without having to compute
+ * the greatest common divisor of the (potentially) much larger
+ * unreduced numerator and denominator.
+ * If all numerators and denominators are small, then the products
+ * cannot overflow a long and they are computed directly instead.
+ */
+static __isl_give isl_val *mul_rat(__isl_take isl_val *v, isl_int n, isl_int d)
+{
+	isl_int g1, g2, t;
+
+	if (is_small(v->n) && is_small(v->d) && is_small(n) && is_small(d))
+		return set_rat_si(v, isl_int_get_si(v->n) * isl_int_get_si(n),
+				isl_int_get_si(v->d) * isl_int_get_si(d));
+
+	isl_int_init(g1);
+	isl_int_init(g2);
+	isl_int_init(t);
+	isl_int_gcd(g1, v->n, d);
+	isl_int_gcd(g2, n, v->d);
+	isl_int_divexact(v->n, v->n, g1);
+	isl_int_divexact(t, n, g2);
+	isl_int_mul(v->n, v->n, t);
+	isl_int_divexact(v->d, v->d, g2);
+	isl_int_divexact(t, d, g1);
+	isl_int_mul(v->d, v->d, t);
+	if (isl_int_is_neg(v->d)) {
+		isl_int_neg(v->d, v->d);
+		isl_int_neg(v->n, v->n);
+	}
+	isl_int_clear(t);
+	isl_int_clear(g2);
+	isl_int_clear(g1);
+
+	return v;
+}
+
 /* Return the product of "v1" and "v2".
  */
 __isl_give isl_val *isl_val_mul(__isl_take isl_val *v1, __isl_take isl_val *v2)
@@ -814,11 +1030,8 @@ __isl_give isl_val *isl_val_mul(__isl_take isl_val *v1, __isl_take isl_val *v2)
 		goto error;
 	if (isl_val_is_int(v1) && isl_val_is_int(v2))
 		isl_int_mul(v1->n, v1->n, v2->n);
-	else {
-		isl_int_mul(v1->n, v1->n, v2->n);
-		isl_int_mul(v1->d, v1->d, v2->d);
-		v1 = isl_val_normalize(v1);
-	}
+	else
+		v1 = mul_rat(v1, v2->n, v2->d);
 	isl_val_free(v2);
 	return v1;
 error:
@@ -899,14 +1112,7 @@ __isl_give isl_val *isl_val_div(__isl_take isl_val *v1, __isl_take isl_val *v2)
 	v1 = isl_val_cow(v1);
 	if (!v1)
 		goto error;
-	if (isl_val_is_int(v2)) {
-		isl_int_mul(v1->d, v1->d, v2->n);
-		v1 = isl_val_normalize(v1);
-	} else {
-		isl_int_mul(v1->d, v1->d, v2->n);
-		isl_int_mul(v1->n, v1->n, v2->d);
-		v1 = isl_val_normalize(v1);
-	}
+	v1 = mul_rat(v1, v2->d, v2->n);
 	isl_val_free(v2);
 	return v1;
 error:
@@ -28,6 +28,7 @@ struct isl_val {
 #include <isl_list_templ.h>
 
 __isl_give isl_val *isl_val_alloc(isl_ctx *ctx);
+void isl_val_clear_cache(isl_ctx *ctx);
 __isl_give isl_val *isl_val_normalize(__isl_take isl_val *v);
 __isl_give isl_val *isl_val_int_from_isl_int(isl_ctx *ctx, isl_int n);
 __isl_give isl_val *isl_val_rat_from_isl_int(isl_ctx *ctx,